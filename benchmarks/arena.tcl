@@ -0,0 +1,73 @@
+set auto_path "[list [pwd]] $auto_path"
+package require TclOO
+puts "class arena benchmark using TclOO [package provide TclOO]"
+
+# ----------------------------------------------------------------------
+# makeClass --
+#	Make a class whose instances are allocated in an arena if arenaSize
+#	is non-zero.
+#
+proc makeClass {name arenaSize} {
+    oo::class create $name {
+	variable value
+	constructor {v} {set value $v}
+	method value {} {return $value}
+    }
+    if {$arenaSize} {
+	oo::define $name arena $arenaSize
+    }
+}
+
+# ----------------------------------------------------------------------
+# measure --
+#	Make n instances of a class, interleaved with instances of another
+#	class (and some strings) so that the heap is fragmented the way it is
+#	in a real program, then time iterating over the instances and
+#	destroying the class (and with it all its instances). Returns the two
+#	times per instance in microseconds.
+#
+proc measure {n arenaSize} {
+    makeClass Measured $arenaSize
+    makeClass Noise 0
+    set junk {}
+    for {set i 0} {$i < $n} {incr i} {
+	Measured new $i
+	Noise new $i
+	lappend junk [string repeat x [expr {$i % 50}]]
+    }
+
+    set start [clock microseconds]
+    for {set j 0} {$j < 10} {incr j} {
+	oo::foreachInstance obj Measured {}
+    }
+    set iterate [expr {([clock microseconds] - $start) / (10.0 * $n)}]
+
+    set start [clock microseconds]
+    Measured destroy
+    set teardown [expr {([clock microseconds] - $start) / double($n)}]
+
+    Noise destroy
+    return [list $iterate $teardown]
+}
+
+# ----------------------------------------------------------------------
+# The arena only changes where the object records are, so the difference is
+# down to how well the records of the instances of a class share cache lines
+# and pages.
+#
+proc main {{n 20000} {arenaSize 256} args} {
+    incr n 0 ;# sanity check
+
+    lassign [measure $n 0] iterPlain tearPlain
+    lassign [measure $n $arenaSize] iterArena tearArena
+    puts [format "%.3f microseconds per instance to iterate without arena" \
+	    $iterPlain]
+    puts [format "%.3f microseconds per instance to iterate with arena" \
+	    $iterArena]
+    puts [format "%.3f microseconds per instance to tear down without arena" \
+	    $tearPlain]
+    puts [format "%.3f microseconds per instance to tear down with arena" \
+	    $tearArena]
+}
+
+main {*}$argv
@@ -0,0 +1,37 @@
+set auto_path "[list [pwd]] $auto_path"
+package require TclOO
+puts "interpreter benchmark using TclOO [package provide TclOO]"
+
+# ----------------------------------------------------------------------
+# makeInterps --
+#	Create and delete a number of interpreters, running a script in each,
+#	and return the average time taken per interpreter in microseconds.
+#
+proc makeInterps {n script} {
+    global auto_path
+    set start [clock microseconds]
+    for {set i 0} {$i < $n} {incr i} {
+	set slave [interp create]
+	$slave eval [list set auto_path $auto_path]
+	$slave eval $script
+	interp delete $slave
+    }
+    return [expr {([clock microseconds] - $start) / double($n)}]
+}
+
+# ----------------------------------------------------------------------
+# The difference between the two timings is the cost of setting up the
+# object system (plus finding the package the first time round).
+#
+proc main {{n 10000} args} {
+    incr n 0 ;# sanity check
+
+    set bare [makeInterps $n {}]
+    set withOO [makeInterps $n {package require TclOO}]
+    puts [format "%.1f microseconds per interpreter without TclOO" $bare]
+    puts [format "%.1f microseconds per interpreter with TclOO" $withOO]
+    puts [format "%.1f microseconds per interpreter to set up TclOO" \
+	    [expr {$withOO - $bare}]]
+}
+
+main {*}$argv
@@ -24,12 +24,20 @@ static const struct {
     Tcl_ObjCmdProc *objProc;
     int flag;
 } defineCmds[] = {
+    {"arena", TclOODefineArenaObjCmd, 0},
+    {"autodestroy", TclOODefineAutoDestroyObjCmd, 0},
     {"constructor", TclOODefineConstructorObjCmd, 0},
     {"deletemethod", TclOODefineDeleteMethodObjCmd, 0},
     {"destructor", TclOODefineDestructorObjCmd, 0},
     {"export", TclOODefineExportObjCmd, 0},
+    {"filterguard", TclOODefineFilterGuardObjCmd, 0},
     {"forward", TclOODefineForwardObjCmd, 0},
+    {"freeze", TclOODefineFreezeObjCmd, 0},
+    {"memoize", TclOODefineMemoizeObjCmd, 0},
     {"method", TclOODefineMethodObjCmd, 0},
+    {"pool", TclOODefinePoolObjCmd, 0},
+    {"precompile", TclOODefinePrecompileObjCmd, 0},
+    {"property", TclOODefinePropertyObjCmd, 0},
     {"renamemethod", TclOODefineRenameMethodObjCmd, 0},
     {"self", TclOODefineSelfObjCmd, 0},
     {"unexport", TclOODefineUnexportObjCmd, 0},
@@ -38,8 +46,11 @@ static const struct {
     {"class", TclOODefineClassObjCmd, 1},
     {"deletemethod", TclOODefineDeleteMethodObjCmd, 1},
     {"export", TclOODefineExportObjCmd, 1},
+    {"filterguard", TclOODefineFilterGuardObjCmd, 1},
     {"forward", TclOODefineForwardObjCmd, 1},
+    {"memoize", TclOODefineMemoizeObjCmd, 1},
     {"method", TclOODefineMethodObjCmd, 1},
+    {"property", TclOODefinePropertyObjCmd, 1},
     {"renamemethod", TclOODefineRenameMethodObjCmd, 1},
     {"unexport", TclOODefineUnexportObjCmd, 1},
     {NULL, NULL, 0}
@@ -58,7 +69,10 @@ static const struct {
 static Class *		AllocClass(Tcl_Interp *interp, Object *useThisObj,
 			    Foundation *fPtr);
 static Object *		AllocObject(Foundation *fPtr, Tcl_Interp *interp,
-			    const char *nameStr, const char *nsNameStr);
+			    const char *nameStr, const char *nsNameStr,
+			    ObjectArena *arenaPtr);
+static void		ClearObjectVariables(Tcl_Interp *interp,
+			    Object *oPtr);
 static int		CloneClassMethod(Tcl_Interp *interp, Class *clsPtr,
 			    Method *mPtr, Tcl_Obj *namePtr,
 			    Method **newMPtrPtr);
@@ -67,6 +81,14 @@ static int		CloneObjectMethod(Tcl_Interp *interp, Object *oPtr,
 static void		DeletedDefineNamespace(ClientData clientData);
 static void		DeletedObjdefNamespace(ClientData clientData);
 static void		DeletedHelpersNamespace(ClientData clientData);
+static void		DeferredWhenIdle(ClientData clientData);
+static void		DupClassNameRep(Tcl_Obj *srcPtr, Tcl_Obj *dstPtr);
+static int		FinishDeferred(Foundation *fPtr, int limit);
+static int		FirstInstanceList(Tcl_HashTable *classTablePtr,
+			    Object *oPtr);
+static void		FinishObjectDeletion(Tcl_Interp *interp,
+			    Object *oPtr);
+static void		FreeClassNameRep(Tcl_Obj *objPtr);
 static int		InitFoundation(Tcl_Interp *interp);
 static void		KillFoundation(ClientData clientData,
 			    Tcl_Interp *interp);
@@ -76,6 +98,8 @@ static void		ObjectRenamedTrace(ClientData clientData,
 			    Tcl_Interp *interp, const char *oldName,
 			    const char *newName, int flags);
 static void		ReleaseClassContents(Tcl_Interp *interp,Object *oPtr);
+static Object *		RevivePooledObject(Tcl_Interp *interp,
+			    Class *clsPtr);
 
 static int		PublicObjectCmd(ClientData clientData,
 			    Tcl_Interp *interp, int objc,
@@ -120,17 +144,26 @@ static const Tcl_MethodType classConstructor = {
     TclOO_Class_Constructor, NULL, NULL
 };
 
+/*
+ * Object type used to remember which class a fully-qualified class name
+ * (typically the argument to [nextto]) refers to. The first pointer is to the
+ * class's object (which a reference is held to) and the second is the epoch
+ * of the object's command at the time, so renames and deletes are spotted.
+ */
+
+static Tcl_ObjType classNameType = {
+    "TclOO class name",
+    FreeClassNameRep,
+    DupClassNameRep,
+    NULL,
+    NULL
+};
+
 /*
  * Scripted parts of TclOO. Note that we embed the scripts for simpler
  * deployment (i.e., no separate script to load).
  */
 
-static const char *initScript =
-"namespace eval ::oo { variable version " TCLOO_VERSION " };"
-"namespace eval ::oo { variable patchlevel " TCLOO_PATCHLEVEL " };";
-/*"tcl_findLibrary tcloo $oo::version $oo::version" */
-/*"     tcloo.tcl OO_LIBRARY oo::library;"; */
-
 static const char *clonedBody =
 "foreach p [info procs [info object namespace $originObject]::*] {"
 "    set args [info args $p];"
@@ -155,35 +188,6 @@ static const char *clonedBody =
 "    }"
 "}";
 
-static const char *slotScript =
-"::oo::define ::oo::Slot {\n"
-"    method Get {} {error unimplemented}\n"
-"    method Set list {error unimplemented}\n"
-"    method -set args {\n"
-"        uplevel 1 [list [namespace which my] Set $args]\n"
-"    }\n"
-"    method -append args {\n"
-"        uplevel 1 [list [namespace which my] Set [list"
-"                {*}[uplevel 1 [list [namespace which my] Get]] {*}$args]]\n"
-"    }\n"
-"    method -clear {} {uplevel 1 [list [namespace which my] Set {}]}\n"
-"    forward --default-operation my -append\n"
-"    method unknown {args} {\n"
-"        set def --default-operation\n"
-"        if {[llength $args] == 0} {\n"
-"            return [uplevel 1 [list [namespace which my] $def]]\n"
-"        } elseif {![string match -* [lindex $args 0]]} {\n"
-"            return [uplevel 1 [list [namespace which my] $def {*}$args]]\n"
-"        }\n"
-"        next {*}$args\n"
-"    }\n"
-"    export -set -append -clear\n"
-"    unexport unknown destroy\n"
-"}\n"
-"::oo::objdefine ::oo::define::superclass forward --default-operation my -set\n"
-"::oo::objdefine ::oo::define::mixin forward --default-operation my -set\n"
-"::oo::objdefine ::oo::objdefine::mixin forward --default-operation my -set\n";
-
 extern const TclStubs *const tclOOConstStubsPtr;
 
 /*
@@ -240,11 +244,14 @@ Tcloo_Init(
     }
 
     /*
-     * Run our initialization script and, if that works, declare the package
-     * to be fully provided.
+     * Record the version and, if that works, declare the package to be fully
+     * provided.
      */
 
-    if (Tcl_Eval(interp, initScript) != TCL_OK) {
+    if (Tcl_SetVar(interp, "::oo::version", TCLOO_VERSION,
+	    TCL_GLOBAL_ONLY | TCL_LEAVE_ERR_MSG) == NULL
+	    || Tcl_SetVar(interp, "::oo::patchlevel", TCLOO_PATCHLEVEL,
+	    TCL_GLOBAL_ONLY | TCL_LEAVE_ERR_MSG) == NULL) {
 	return TCL_ERROR;
     }
 
@@ -298,6 +305,7 @@ InitFoundation(
     Foundation *fPtr = (Foundation *) ckalloc(sizeof(Foundation));
     Tcl_Obj *namePtr, *argsPtr, *bodyPtr;
     Tcl_DString buffer;
+    Tcl_Command cmd;
     int i;
 
     /*
@@ -318,17 +326,37 @@ InitFoundation(
     fPtr->helpersNs = Tcl_CreateNamespace(interp, "::oo::Helpers", fPtr,
 	    DeletedHelpersNamespace);
     fPtr->epoch = 0;
+    fPtr->frozenEpoch = 0;
     fPtr->tsdPtr = tsdPtr;
+    TclOOInitSharedProcs(fPtr);
+    Tcl_InitHashTable(&fPtr->autoTable, TCL_ONE_WORD_KEYS);
+    fPtr->deferred.num = 0;
+    fPtr->deferred.size = 0;
+    fPtr->deferred.list = NULL;
+    fPtr->deferredHead = 0;
+    fPtr->deferPending = 0;
+    cmd = Tcl_FindCommand(interp, "::return", NULL, TCL_GLOBAL_ONLY);
+    fPtr->returnCompileProc = (cmd == NULL ? NULL
+	    : ((Command *) cmd)->compileProc);
+    cmd = Tcl_FindCommand(interp, "::set", NULL, TCL_GLOBAL_ONLY);
+    fPtr->setCompileProc = (cmd == NULL ? NULL
+	    : ((Command *) cmd)->compileProc);
     fPtr->unknownMethodNameObj = Tcl_NewStringObj("unknown", -1);
     fPtr->constructorName = Tcl_NewStringObj("<constructor>", -1);
     fPtr->destructorName = Tcl_NewStringObj("<destructor>", -1);
     fPtr->clonedName = Tcl_NewStringObj("<cloned>", -1);
     fPtr->defineName = Tcl_NewStringObj("::oo::define", -1);
+    fPtr->slotGetName = Tcl_NewStringObj("Get", -1);
+    fPtr->slotSetName = Tcl_NewStringObj("Set", -1);
+    fPtr->slotDefOpName = Tcl_NewStringObj("--default-operation", -1);
     Tcl_IncrRefCount(fPtr->unknownMethodNameObj);
     Tcl_IncrRefCount(fPtr->constructorName);
     Tcl_IncrRefCount(fPtr->destructorName);
     Tcl_IncrRefCount(fPtr->clonedName);
     Tcl_IncrRefCount(fPtr->defineName);
+    Tcl_IncrRefCount(fPtr->slotGetName);
+    Tcl_IncrRefCount(fPtr->slotSetName);
+    Tcl_IncrRefCount(fPtr->slotDefOpName);
     Tcl_CreateObjCommand(interp, "::oo::UnknownDefinition",
 	    TclOOUnknownDefinition, NULL, NULL);
     namePtr = Tcl_NewStringObj("::oo::UnknownDefinition", -1);
@@ -366,9 +394,9 @@ InitFoundation(
      */
 
     fPtr->objectCls = AllocClass(interp, AllocObject(fPtr, interp,
-	    "::oo::object", NULL), fPtr);
+	    "::oo::object", NULL, NULL), fPtr);
     fPtr->classCls = AllocClass(interp, AllocObject(fPtr, interp,
-	    "::oo::class", NULL), fPtr);
+	    "::oo::class", NULL, NULL), fPtr);
     fPtr->objectCls->thisPtr->selfCls = fPtr->classCls;
     fPtr->objectCls->thisPtr->flags |= ROOT_OBJECT;
     fPtr->objectCls->flags |= ROOT_OBJECT;
@@ -434,16 +462,29 @@ InitFoundation(
     Tcl_CreateObjCommand(interp, "::oo::objdefine", TclOOObjDefObjCmd, NULL,
 	    NULL);
     Tcl_CreateObjCommand(interp, "::oo::copy", TclOOCopyObjectCmd, NULL,NULL);
+    Tcl_CreateObjCommand(interp, "::oo::serialize", TclOOSerializeObjCmd,
+	    NULL, NULL);
+    Tcl_CreateObjCommand(interp, "::oo::deserialize", TclOODeserializeObjCmd,
+	    NULL, NULL);
+    Tcl_CreateObjCommand(interp, "::oo::foreachInstance",
+	    TclOOForeachInstanceObjCmd, NULL, NULL);
+    Tcl_CreateObjCommand(interp, "::oo::broadcast", TclOOBroadcastObjCmd,
+	    NULL, NULL);
+    Tcl_CreateObjCommand(interp, "::oo::collect", TclOOCollectObjCmd, NULL,
+	    NULL);
+    Tcl_CreateObjCommand(interp, "::oo::cache", TclOOCacheObjCmd, NULL,
+	    NULL);
+    Tcl_CreateObjCommand(interp, "::oo::share", TclOOShareObjCmd, NULL,
+	    NULL);
+    Tcl_CreateObjCommand(interp, "::oo::template", TclOOTemplateObjCmd, NULL,
+	    NULL);
     TclOOInitInfo(interp);
 
     /*
      * Now make the class of slots.
      */
 
-    if (TclOODefineSlots(fPtr) != TCL_OK) {
-	return TCL_ERROR;
-    }
-    return Tcl_Eval(interp, slotScript);
+    return TclOODefineSlots(fPtr);
 }
 
 /*
@@ -503,11 +544,31 @@ KillFoundation(
 				 * foundation. */
 {
     Foundation *fPtr = clientData;
+    int i;
 
     if (!Tcl_InterpDeleted(interp)) {
 	Tcl_DeleteAssocData(interp, FOUNDATION_KEY);
     }
 
+    /*
+     * Anything still waiting for its deferred destruction is left to the
+     * deletion of its namespace; the interpreter is going, so there is no
+     * point running destructors.
+     */
+
+    if (fPtr->deferPending) {
+	Tcl_CancelIdleCall(DeferredWhenIdle, fPtr);
+    }
+    for (i=fPtr->deferredHead ; i<fPtr->deferred.num ; i++) {
+	DelRef(fPtr->deferred.list[i]);
+    }
+    if (fPtr->deferred.list != NULL) {
+	ckfree((char *) fPtr->deferred.list);
+    }
+
+    TclOOCancelRewarm(fPtr);
+    TclOOCollectObjects(fPtr, 1);
+    Tcl_DeleteHashTable(&fPtr->autoTable);
     DelRef(fPtr->objectCls->thisPtr);
     DelRef(fPtr->objectCls);
     Tcl_DecrRefCount(fPtr->unknownMethodNameObj);
@@ -515,6 +576,11 @@ KillFoundation(
     Tcl_DecrRefCount(fPtr->destructorName);
     Tcl_DecrRefCount(fPtr->clonedName);
     Tcl_DecrRefCount(fPtr->defineName);
+    Tcl_DecrRefCount(fPtr->slotGetName);
+    Tcl_DecrRefCount(fPtr->slotSetName);
+    Tcl_DecrRefCount(fPtr->slotDefOpName);
+    TclOOReleaseSharedProcs(fPtr, 1);
+    Tcl_DeleteHashTable(&fPtr->procTable);
     ckfree((char *) fPtr);
 }
 
@@ -538,17 +604,23 @@ AllocObject(
 				 * if the OO system should pick the object
 				 * name itself (equal to the namespace
 				 * name). */
-    const char *nsNameStr)	/* The name of the namespace to create, or
+    const char *nsNameStr,	/* The name of the namespace to create, or
 				 * NULL if the OO system should pick a unique
 				 * name itself. If this is non-NULL but names
 				 * a namespace that already exists, the effect
 				 * will be the same as if this was NULL. */
+    ObjectArena *arenaPtr)	/* The arena to allocate the object's record
+				 * from, or NULL to allocate it on its own. */
 {
     Tcl_DString buffer;
     Object *oPtr;
     int creationEpoch;
 
-    oPtr = (Object *) ckalloc(sizeof(Object));
+    if (arenaPtr != NULL) {
+	oPtr = TclOOArenaAlloc(arenaPtr);
+    } else {
+	oPtr = (Object *) ckalloc(sizeof(Object));
+    }
     memset(oPtr, 0, sizeof(Object));
 
     /*
@@ -613,6 +685,10 @@ AllocObject(
     oPtr->creationEpoch = creationEpoch;
     oPtr->refCount = 1;
     oPtr->flags = USE_CLASS_CACHE;
+    if (arenaPtr != NULL) {
+	oPtr->flags |= ARENA_RECORD;
+	oPtr->arenaPtr = arenaPtr;
+    }
 
     /*
      * Finally, create the object commands and initialize the trace on the
@@ -751,6 +827,71 @@ ObjectRenamedTrace(
 	return;
     }
 
+    /*
+     * An object going into its class's pool just loses its command; the rest
+     * of it is kept for reuse.
+     */
+
+    if (oPtr->flags & POOLED_OBJECT) {
+	oPtr->command = NULL;
+	return;
+    }
+
+    /*
+     * If the rest of the destruction has been deferred, all that happens now
+     * is that the object stops being reachable; it is queued (with a lock on
+     * it) to be finished off when the interpreter is next idle. That can't
+     * be put off once the interpreter itself is going.
+     */
+
+    if (oPtr->flags & DEFERRED_DELETE) {
+	if (!Tcl_InterpDeleted(interp)) {
+	    oPtr->command = NULL;
+	    AddRef(oPtr);
+	    if (fPtr->deferred.num >= fPtr->deferred.size) {
+		if (fPtr->deferred.size == 0) {
+		    fPtr->deferred.size = DEFER_BATCH_SIZE;
+		    fPtr->deferred.list = (Object **)
+			    ckalloc(sizeof(Object *) * DEFER_BATCH_SIZE);
+		} else {
+		    fPtr->deferred.size *= 2;
+		    fPtr->deferred.list = (Object **)
+			    ckrealloc((char *) fPtr->deferred.list,
+			    sizeof(Object *) * fPtr->deferred.size);
+		}
+	    }
+	    fPtr->deferred.list[fPtr->deferred.num++] = oPtr;
+	    if (!fPtr->deferPending) {
+		fPtr->deferPending = 1;
+		Tcl_DoWhenIdle(DeferredWhenIdle, fPtr);
+	    }
+	    return;
+	}
+	oPtr->flags &= ~DEFERRED_DELETE;
+    }
+
+    FinishObjectDeletion(interp, oPtr);
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * FinishObjectDeletion --
+ *
+ *	Does the real work of deleting an object once its command has gone (or
+ *	is going): runs the destructors and arranges for the actual cleanup of
+ *	the object's namespace.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static void
+FinishObjectDeletion(
+    Tcl_Interp *interp,		/* The interpreter containing the object. */
+    Object *oPtr)		/* The object being deleted. */
+{
+    Foundation *fPtr = oPtr->fPtr;
+
     /*
      * Oh dear, the object really is being deleted. Handle this by running the
      * destructors and deleting the object's namespace, which in turn causes
@@ -952,10 +1093,19 @@ ReleaseClassContents(
 	    }
 	    if (!Deleted(instancePtr)) {
 		Tcl_DeleteCommandFromToken(interp, instancePtr->command);
+	    } else if (instancePtr->flags & (DEFERRED_DELETE|POOLED_OBJECT)) {
+		/*
+		 * Can't leave finishing the instance off until later; it needs
+		 * its class to do so.
+		 */
+
+		instancePtr->flags &= ~(DEFERRED_DELETE|POOLED_OBJECT);
+		FinishObjectDeletion(interp, instancePtr);
 	    }
 	    DelRef(instancePtr);
 	}
     }
+    TclOOTrimPool(interp, clsPtr, 0);
     if (clsPtr->instances.list != NULL) {
 	ckfree((char *) clsPtr->instances.list);
 	clsPtr->instances.list = NULL;
@@ -983,13 +1133,7 @@ ReleaseClassContents(
 	clsPtr->destructorChainPtr = NULL;
     }
     if (clsPtr->classChainCache) {
-	CallChain *callPtr;
-
-	FOREACH_HASH_VALUE(callPtr, clsPtr->classChainCache) {
-	    TclOODeleteChain(callPtr);
-	}
-	Tcl_DeleteHashTable(clsPtr->classChainCache);
-	ckfree((char *) clsPtr->classChainCache);
+	TclOODeleteChainCache(clsPtr->classChainCache);
 	clsPtr->classChainCache = NULL;
     }
 
@@ -1006,6 +1150,8 @@ ReleaseClassContents(
 	ckfree((char *) clsPtr->filters.list);
 	clsPtr->filters.num = 0;
     }
+    TclOODeleteFilterGuards(clsPtr->filterGuards);
+    clsPtr->filterGuards = NULL;
 
     /*
      * Squelch our metadata.
@@ -1058,6 +1204,9 @@ ObjectNamespaceDeleted(
 
     if (oPtr->command) {
 	Tcl_DeleteCommandFromToken(oPtr->fPtr->interp, oPtr->command);
+    } else if (oPtr->flags & (DEFERRED_DELETE|POOLED_OBJECT)) {
+	oPtr->flags &= ~(DEFERRED_DELETE|POOLED_OBJECT);
+	FinishObjectDeletion(oPtr->fPtr->interp, oPtr);
     }
     if (oPtr->myCommand) {
 	Tcl_DeleteCommandFromToken(oPtr->fPtr->interp, oPtr->myCommand);
@@ -1085,6 +1234,8 @@ ObjectNamespaceDeleted(
     if (i) {
 	ckfree((char *) oPtr->filters.list);
     }
+    TclOODeleteFilterGuards(oPtr->filterGuards);
+    oPtr->filterGuards = NULL;
 
     if (oPtr->methodsPtr) {
 	FOREACH_HASH_VALUE(mPtr, oPtr->methodsPtr) {
@@ -1140,6 +1291,8 @@ ObjectNamespaceDeleted(
 	    ckfree((char *) clsPtr->filters.list);
 	    clsPtr->filters.num = 0;
 	}
+	TclOODeleteFilterGuards(clsPtr->filterGuards);
+	clsPtr->filterGuards = NULL;
 	FOREACH(mixinPtr, clsPtr->mixins) {
 	    if (!Deleted(mixinPtr->thisPtr)) {
 		TclOORemoveFromMixinSubs(clsPtr, mixinPtr);
@@ -1184,6 +1337,13 @@ ObjectNamespaceDeleted(
 	if (i) {
 	    ckfree((char *) clsPtr->variables.list);
 	}
+	if (clsPtr->warmPatternObj != NULL) {
+	    Tcl_DecrRefCount(clsPtr->warmPatternObj);
+	}
+	if (clsPtr->arenaPtr != NULL) {
+	    TclOOReleaseArena(clsPtr->arenaPtr);
+	    clsPtr->arenaPtr = NULL;
+	}
 
 	DelRef(clsPtr);
     }
@@ -1450,7 +1610,7 @@ AllocClass(
 
     memset(clsPtr, 0, sizeof(Class));
     if (useThisObj == NULL) {
-	clsPtr->thisPtr = AllocObject(fPtr, interp, NULL, NULL);
+	clsPtr->thisPtr = AllocObject(fPtr, interp, NULL, NULL, NULL);
     } else {
 	clsPtr->thisPtr = useThisObj;
     }
@@ -1544,10 +1704,18 @@ Tcl_NewObjectInstance(
     }
 
     /*
-     * Create the object.
+     * Create the object, reusing a pooled one if the caller doesn't mind
+     * what it is called. Those are already spliced into the class.
      */
 
-    oPtr = AllocObject(fPtr, interp, nameStr, nsNameStr);
+    if (nameStr == NULL && nsNameStr == NULL && classPtr->poolSize > 0) {
+	oPtr = RevivePooledObject(interp, classPtr);
+	if (oPtr != NULL) {
+	    goto construct;
+	}
+    }
+    oPtr = AllocObject(fPtr, interp, nameStr, nsNameStr,
+	    classPtr->arenaPtr);
     oPtr->selfCls = classPtr;
     TclOOAddToInstances(oPtr, classPtr);
 
@@ -1574,6 +1742,7 @@ Tcl_NewObjectInstance(
      * object cloning only).
      */
 
+  construct:
     if (objc >= 0) {
 	CallContext *contextPtr = TclOOGetCallContext(oPtr,NULL,CONSTRUCTOR);
 
@@ -1628,6 +1797,215 @@ Tcl_NewObjectInstance(
 
     return (Tcl_Object) oPtr;
 }
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOParkObject --
+ *
+ *	Called when an object of a class with a pool is destroyed with its
+ *	[destroy] method, after its destructors have run. If the object is a
+ *	plain instance of its class (nothing has been added to it, and nothing
+ *	else is using it) and there's room, its variables are cleared and it
+ *	is put in its class's pool instead of being torn down, keeping its
+ *	namespace and [my] command. Only the object's command is deleted.
+ *
+ * Results:
+ *	Whether the object was pooled; if not, the caller must delete it in
+ *	the normal way.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+TclOOParkObject(
+    Tcl_Interp *interp,
+    Object *oPtr)
+{
+    Class *clsPtr = oPtr->selfCls;
+    Namespace *nsPtr = (Namespace *) oPtr->namespacePtr;
+
+    /*
+     * The references are those of the object itself, of the call of the
+     * [destroy] method and of the method's own lock on the object; any more
+     * than that means something is still using it.
+     */
+
+    if (clsPtr->pool.num >= clsPtr->poolSize || Deleted(oPtr)
+	    || Deleted(clsPtr->thisPtr) || Tcl_InterpDeleted(interp)
+	    || oPtr->refCount > 3 || oPtr->classPtr != NULL
+	    || oPtr->myCommand == NULL || nsPtr == NULL
+	    || (oPtr->methodsPtr && oPtr->methodsPtr->numEntries)
+	    || oPtr->mixins.num || oPtr->filters.num
+	    || oPtr->filterGuards != NULL || oPtr->variables.num
+	    || (oPtr->metadataPtr && oPtr->metadataPtr->numEntries)
+	    || oPtr->mapMethodNameProc != NULL
+	    || nsPtr->cmdTable.numEntries != 1
+	    || nsPtr->childTable.numEntries != 0
+	    || nsPtr->commandPathLength != 1) {
+	return 0;
+    }
+
+    /*
+     * Clearing the variables can run traces, which can do anything; check
+     * again afterwards.
+     */
+
+    ClearObjectVariables(interp, oPtr);
+    if (clsPtr->pool.num >= clsPtr->poolSize || Deleted(oPtr)
+	    || Deleted(clsPtr->thisPtr)) {
+	return 0;
+    }
+
+    oPtr->flags |= POOLED_OBJECT;
+    Tcl_DeleteCommandFromToken(interp, oPtr->command);
+    if (clsPtr->pool.num >= clsPtr->pool.size) {
+	clsPtr->pool.size += ALLOC_CHUNK;
+	if (clsPtr->pool.size == ALLOC_CHUNK) {
+	    clsPtr->pool.list = (Object **)
+		    ckalloc(sizeof(Object *) * ALLOC_CHUNK);
+	} else {
+	    clsPtr->pool.list = (Object **)
+		    ckrealloc((char *) clsPtr->pool.list,
+		    sizeof(Object *) * clsPtr->pool.size);
+	}
+    }
+    AddRef(oPtr);
+    clsPtr->pool.list[clsPtr->pool.num++] = oPtr;
+    return 1;
+}
+
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * ClearObjectVariables --
+ *
+ *	Unset all the variables in an object's namespace, as if the namespace
+ *	had just been made. This works on the namespace's table of variables
+ *	directly (as deleting a namespace does) rather than by name, since a
+ *	scalar with a name like "a(b)" would otherwise be taken for an array
+ *	element and survive. The namespace is made current while this is
+ *	done so that unset traces see the names as relative to it.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static void
+ClearObjectVariables(
+    Tcl_Interp *interp,
+    Object *oPtr)
+{
+    Namespace *nsPtr = (Namespace *) oPtr->namespacePtr;
+    Tcl_CallFrame frame;
+
+    if (nsPtr->varTable.table.numEntries == 0) {
+	return;
+    }
+    (void) Tcl_PushCallFrame(interp, &frame, (Tcl_Namespace *) nsPtr, 0);
+    TclDeleteVars((Interp *) interp, &nsPtr->varTable);
+    Tcl_PopCallFrame(interp);
+    TclInitVarHashTable(&nsPtr->varTable, nsPtr);
+}
+
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * RevivePooledObject --
+ *
+ *	Take an object out of a class's pool and give it a new name and
+ *	identity, ready for its constructor to be run.
+ *
+ * Results:
+ *	The object, or NULL if the pool held nothing reusable.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static Object *
+RevivePooledObject(
+    Tcl_Interp *interp,
+    Class *clsPtr)
+{
+    Object *oPtr;
+    ThreadLocalData *tsdPtr = clsPtr->thisPtr->fPtr->tsdPtr;
+    char objName[10 + TCL_INTEGER_SPACE];
+
+    while (clsPtr->pool.num > 0) {
+	oPtr = clsPtr->pool.list[--clsPtr->pool.num];
+	if (oPtr->flags & POOLED_OBJECT) {
+	    goto revive;
+	}
+
+	/*
+	 * The object's namespace has been deleted while it was in the pool,
+	 * taking the object with it.
+	 */
+
+	DelRef(oPtr);
+    }
+    clsPtr->poolMisses++;
+    return NULL;
+
+    /*
+     * The new name is picked the same way as for new objects, and the
+     * object is given a new creation epoch too, so nothing cached about what
+     * it used to be can be mistaken for it.
+     */
+
+  revive:
+    do {
+	sprintf(objName, "::oo::Obj%d", ++tsdPtr->nsCount);
+    } while (Tcl_FindCommand(interp, objName, NULL, TCL_GLOBAL_ONLY));
+    oPtr->creationEpoch = tsdPtr->nsCount;
+    oPtr->epoch++;
+    oPtr->flags &= ~(POOLED_OBJECT|DESTRUCTOR_CALLED);
+    SquelchCachedName(oPtr);
+    oPtr->command = Tcl_CreateObjCommand(interp, objName, PublicObjectCmd,
+	    oPtr, NULL);
+    Tcl_TraceCommand(interp, objName, TCL_TRACE_RENAME|TCL_TRACE_DELETE,
+	    ObjectRenamedTrace, oPtr);
+    clsPtr->poolHits++;
+    DelRef(oPtr);
+    return oPtr;
+}
+
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOTrimPool --
+ *
+ *	Finish off the objects in a class's pool beyond the first few (or all
+ *	of them), releasing their namespaces and the rest of their structure.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+void
+TclOOTrimPool(
+    Tcl_Interp *interp,
+    Class *clsPtr,
+    int keep)			/* How many objects to leave in the pool. */
+{
+    Object *oPtr;
+
+    while (clsPtr->pool.num > keep) {
+	oPtr = clsPtr->pool.list[--clsPtr->pool.num];
+	if (oPtr->flags & POOLED_OBJECT) {
+	    oPtr->flags &= ~POOLED_OBJECT;
+	    FinishObjectDeletion(interp, oPtr);
+	}
+	DelRef(oPtr);
+    }
+    if (clsPtr->pool.num == 0 && clsPtr->pool.list != NULL) {
+	ckfree((char *) clsPtr->pool.list);
+	clsPtr->pool.list = NULL;
+	clsPtr->pool.size = 0;
+    }
+}
+
 
 /*
  * ----------------------------------------------------------------------
@@ -1713,6 +2091,7 @@ Tcl_CopyObjectInstance(
     FOREACH(filterObj, o2Ptr->filters) {
 	Tcl_IncrRefCount(filterObj);
     }
+    o2Ptr->filterGuards = TclOOCopyFilterGuards(oPtr->filterGuards);
 
     /*
      * Copy the object's variable resolution list to the new object.
@@ -1727,11 +2106,13 @@ Tcl_CopyObjectInstance(
      * Copy the object's flags to the new object, clearing those that must be
      * kept object-local. The duplicate is never deleted at this point, nor is
      * it the root of the object system or in the midst of processing a filter
-     * call.
+     * call. Whether its record is in an arena depends on how the duplicate
+     * was allocated, not on the original.
      */
 
-    o2Ptr->flags = oPtr->flags & ~(
-	    OBJECT_DELETED | ROOT_OBJECT | ROOT_CLASS | FILTER_HANDLING);
+    o2Ptr->flags = (o2Ptr->flags & ARENA_RECORD) | (oPtr->flags & ~(
+	    OBJECT_DELETED | ROOT_OBJECT | ROOT_CLASS | FILTER_HANDLING
+	    | ARENA_RECORD));
 
     /*
      * Copy the object's metadata.
@@ -1769,10 +2150,11 @@ Tcl_CopyObjectInstance(
 	Class *superPtr;
 
 	/*
-	 * Copy the class flags across.
+	 * Copy the class flags across. The copy is not frozen, since the
+	 * point of copying a class is usually to change it.
 	 */
 
-	cls2Ptr->flags = clsPtr->flags;
+	cls2Ptr->flags = clsPtr->flags & ~FROZEN_CLASS;
 
 	/*
 	 * Ensure that the new class's superclass structure is the same as the
@@ -1805,6 +2187,7 @@ Tcl_CopyObjectInstance(
 	FOREACH(filterObj, cls2Ptr->filters) {
 	    Tcl_IncrRefCount(filterObj);
 	}
+	cls2Ptr->filterGuards = TclOOCopyFilterGuards(clsPtr->filterGuards);
 
 	/*
 	 * Copy the source class's variable resolution list.
@@ -2269,19 +2652,50 @@ TclOOObjectCmdCore(
     methodNamePtr = objv[1];
     if (oPtr->mapMethodNameProc != NULL) {
 	register Class **startClsPtr = &startCls;
+	int isPure = (startCls == NULL && (oPtr->flags & PURE_NAME_MAPPER));
 
-	methodNamePtr = Tcl_DuplicateObj(methodNamePtr);
-	result = oPtr->mapMethodNameProc(interp, (Tcl_Object) oPtr,
-		(Tcl_Class *) startClsPtr, methodNamePtr);
-	if (result != TCL_OK) {
-	    if (result == TCL_ERROR) {
-		Tcl_AddErrorInfo(interp, "\n    (while mapping method name)");
+	/*
+	 * If the mapper is pure, we may already know what it will say.
+	 */
+
+	if (!isPure || !TclOOGetMappedMethodName(oPtr, objv[1],
+		&methodNamePtr, startClsPtr)) {
+	    methodNamePtr = Tcl_DuplicateObj(methodNamePtr);
+	    result = oPtr->mapMethodNameProc(interp, (Tcl_Object) oPtr,
+		    (Tcl_Class *) startClsPtr, methodNamePtr);
+	    if (result != TCL_OK) {
+		if (result == TCL_ERROR) {
+		    Tcl_AddErrorInfo(interp,
+			    "\n    (while mapping method name)");
+		}
+		Tcl_DecrRefCount(methodNamePtr);
+		return result;
 	    }
+	    if (isPure) {
+		TclOOStashMappedMethodName(oPtr, objv[1], methodNamePtr,
+			startCls);
+	    }
+	}
+    }
+    Tcl_IncrRefCount(methodNamePtr);
+
+    /*
+     * Most method calls are of a method with a single implementation, no
+     * filters and no special start point. If we've already got a chain for
+     * one of those, skip all the bookkeeping of a general call.
+     */
+
+    if (startCls == NULL && !(oPtr->flags & FILTER_HANDLING)) {
+	CallChain *callPtr =
+		TclOOGetCachedCallChain(oPtr, methodNamePtr, flags);
+
+	if (callPtr != NULL && (callPtr->flags & TRIVIAL_CHAIN)) {
+	    result = TclOOInvokeTrivialChain(interp, oPtr, callPtr, objc,
+		    objv);
 	    Tcl_DecrRefCount(methodNamePtr);
 	    return result;
 	}
     }
-    Tcl_IncrRefCount(methodNamePtr);
 
     /*
      * Get the call chain.
@@ -2304,22 +2718,15 @@ TclOOObjectCmdCore(
      */
 
     if (startCls != NULL) {
-	while (contextPtr->index < contextPtr->callPtr->numChain) {
-	    register struct MInvoke *miPtr =
-		    &contextPtr->callPtr->chain[contextPtr->index];
+	int index = TclOOGetChainIndex(contextPtr->callPtr, startCls);
 
-	    if (miPtr->isFilter || miPtr->mPtr->declaringClassPtr!=startCls) {
-		contextPtr->index++;
-	    } else {
-		break;
-	    }
-	}
-	if (contextPtr->index >= contextPtr->callPtr->numChain) {
+	if (index < contextPtr->index) {
 	    result = TCL_ERROR;
 	    Tcl_SetResult(interp, "no valid method implementation",
 		    TCL_STATIC);
 	    goto disposeChain;
 	}
+	contextPtr->index = index;
     }
 
     /*
@@ -2338,6 +2745,191 @@ TclOOObjectCmdCore(
     return result;
 }
 
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOInvokeMany --
+ *
+ *	Invokes the same public method with the same arguments on each of a
+ *	collection of objects. This is cheaper than invoking the objects one
+ *	at a time because each distinct class gets its own copy of the method
+ *	name, so the call chain cached in that copy stays valid for all the
+ *	instances of that class, and the argument array is only built once.
+ *	Objects deleted before their turn are skipped.
+ *
+ *	The objv[0] element is replaced by the name of each object in turn and
+ *	objv[1] is the name of the method. Unless the flags say otherwise, the
+ *	first call that fails stops the invocation and its result is returned;
+ *	with INVOKE_COLLECT_ERRORS, the name and result of each failing call
+ *	are appended to errorsObj (if not NULL) instead. The interpreter
+ *	result is reset unless a call stopped the invocation.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+TclOOInvokeMany(
+    Tcl_Interp *interp,		/* Interpreter for commands, variables,
+				 * results, error reporting, etc. */
+    int numObjects,		/* Number of objects to invoke. */
+    Tcl_Object *const *objects,	/* Array of objects to invoke. */
+    int flags,			/* Combination of INVOKE_* flags. */
+    int objc,			/* Number of arguments. */
+    Tcl_Obj *const *objv,	/* Array of argument objects. */
+    Tcl_Obj *errorsObj)		/* Unshared list to add failures to, or NULL
+				 * if they are to be discarded. */
+{
+    Object **order, *oPtr;
+    Tcl_Obj **args, *otherNameObj = NULL;
+    Class *firstCls = NULL;
+    Tcl_HashTable names;
+    Tcl_HashEntry *hPtr;
+    Tcl_HashSearch search;
+    int i, isNew, code, result = TCL_OK;
+
+    if (numObjects < 1) {
+	Tcl_ResetResult(interp);
+	return TCL_OK;
+    }
+    Tcl_InitHashTable(&names, TCL_ONE_WORD_KEYS);
+
+    /*
+     * Work out the order in which to call the objects. When grouping, the
+     * classes come in the order in which they are first seen and the order
+     * of the objects of each class is preserved.
+     */
+
+    order = (Object **) ckalloc(sizeof(Object *) * numObjects);
+    if (flags & INVOKE_GROUP_BY_CLASS) {
+	int numGroups = 0, *groupStart;
+
+	for (i=0 ; i<numObjects ; i++) {
+	    hPtr = Tcl_CreateHashEntry(&names,
+		    (char *) ((Object *) objects[i])->selfCls, &isNew);
+	    if (isNew) {
+		Tcl_SetHashValue(hPtr, INT2PTR(numGroups++));
+	    }
+	}
+	groupStart = (int *) ckalloc(sizeof(int) * (numGroups + 1));
+	memset(groupStart, 0, sizeof(int) * (numGroups + 1));
+	for (i=0 ; i<numObjects ; i++) {
+	    hPtr = Tcl_FindHashEntry(&names,
+		    (char *) ((Object *) objects[i])->selfCls);
+	    groupStart[PTR2INT(Tcl_GetHashValue(hPtr)) + 1]++;
+	}
+	for (i=1 ; i<numGroups ; i++) {
+	    groupStart[i] += groupStart[i-1];
+	}
+	for (i=0 ; i<numObjects ; i++) {
+	    hPtr = Tcl_FindHashEntry(&names,
+		    (char *) ((Object *) objects[i])->selfCls);
+	    order[groupStart[PTR2INT(Tcl_GetHashValue(hPtr))]++] =
+		    (Object *) objects[i];
+	}
+	ckfree((char *) groupStart);
+	Tcl_DeleteHashTable(&names);
+	Tcl_InitHashTable(&names, TCL_ONE_WORD_KEYS);
+    } else {
+	memcpy(order, objects, sizeof(Object *) * numObjects);
+    }
+
+    /*
+     * Lock the objects so that calling one can't make the others vanish out
+     * from under us.
+     */
+
+    for (i=0 ; i<numObjects ; i++) {
+	AddRef(order[i]);
+    }
+    args = (Tcl_Obj **) ckalloc(sizeof(Tcl_Obj *) * objc);
+    memcpy(args, objv, sizeof(Tcl_Obj *) * objc);
+
+    for (i=0 ; i<numObjects ; i++) {
+	oPtr = order[i];
+	if (Deleted(oPtr) || result != TCL_OK) {
+	    continue;
+	}
+
+	/*
+	 * Choose which copy of the method name to use. Objects whose chains
+	 * are per-object share a copy of their own, so that they do not
+	 * disturb the chains cached for whole classes.
+	 */
+
+	if (!(oPtr->flags & USE_CLASS_CACHE)) {
+	    if (otherNameObj == NULL) {
+		otherNameObj = Tcl_NewStringObj(TclGetString(objv[1]), -1);
+		Tcl_IncrRefCount(otherNameObj);
+	    }
+	    args[1] = otherNameObj;
+	} else if (firstCls == NULL || oPtr->selfCls == firstCls) {
+	    firstCls = oPtr->selfCls;
+	    args[1] = objv[1];
+	} else {
+	    hPtr = Tcl_CreateHashEntry(&names, (char *) oPtr->selfCls, &isNew);
+	    if (isNew) {
+		Tcl_Obj *nameObj = Tcl_NewStringObj(TclGetString(objv[1]), -1);
+
+		Tcl_IncrRefCount(nameObj);
+		Tcl_SetHashValue(hPtr, nameObj);
+	    }
+	    args[1] = Tcl_GetHashValue(hPtr);
+	}
+
+	/*
+	 * Make the call. The object's name is locked in case the call
+	 * deletes the object.
+	 */
+
+	args[0] = TclOOObjectName(interp, oPtr);
+	Tcl_IncrRefCount(args[0]);
+	code = TclOOObjectCmdCore(oPtr, interp, objc, args, PUBLIC_METHOD,
+		NULL);
+	if (code != TCL_OK) {
+	    if (flags & INVOKE_COLLECT_ERRORS) {
+		if (errorsObj != NULL) {
+		    Tcl_ListObjAppendElement(NULL, errorsObj, args[0]);
+		    Tcl_ListObjAppendElement(NULL, errorsObj,
+			    Tcl_GetObjResult(interp));
+		}
+		Tcl_ResetResult(interp);
+	    } else if (flags & INVOKE_IGNORE_ERRORS) {
+		Tcl_ResetResult(interp);
+	    } else {
+		if (code == TCL_ERROR) {
+		    Tcl_AppendObjToErrorInfo(interp, Tcl_ObjPrintf(
+			    "\n    (while invoking \"%s\")",
+			    TclGetString(args[0])));
+		}
+		result = code;
+	    }
+	}
+	Tcl_DecrRefCount(args[0]);
+    }
+
+    /*
+     * Release everything.
+     */
+
+    for (i=0 ; i<numObjects ; i++) {
+	DelRef(order[i]);
+    }
+    ckfree((char *) order);
+    ckfree((char *) args);
+    for (hPtr=Tcl_FirstHashEntry(&names, &search) ; hPtr!=NULL ;
+	    hPtr=Tcl_NextHashEntry(&search)) {
+	Tcl_DecrRefCount((Tcl_Obj *) Tcl_GetHashValue(hPtr));
+    }
+    Tcl_DeleteHashTable(&names);
+    if (otherNameObj != NULL) {
+	Tcl_DecrRefCount(otherNameObj);
+    }
+    if (result == TCL_OK) {
+	Tcl_ResetResult(interp);
+    }
+    return result;
+}
+
 /*
  * ----------------------------------------------------------------------
  *
@@ -2454,6 +3046,104 @@ Tcl_GetObjectFromObj(
     return NULL;
 }
 
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOGetClassFromObj --
+ *
+ *	Utility function to get a class from a Tcl_Obj containing its name,
+ *	remembering the result in the value if the name is fully qualified
+ *	(and so does not depend on the current namespace). Used where class
+ *	names are looked up repeatedly, such as by [nextto].
+ *
+ * ----------------------------------------------------------------------
+ */
+
+Class *
+TclOOGetClassFromObj(
+    Tcl_Interp *interp,		/* Interpreter in which to locate the class.
+				 * Will have an error message placed in it if
+				 * the name does not refer to a class. */
+    Tcl_Obj *objPtr)		/* The name of the class to look up. */
+{
+    Object *oPtr;
+    const char *name;
+
+    /*
+     * The remembered class is only good for the interpreter that it belongs
+     * to; the same value may be used in several interpreters of a thread.
+     */
+
+    if (objPtr->typePtr == &classNameType) {
+	oPtr = objPtr->internalRep.twoPtrValue.ptr1;
+	if (oPtr->command != NULL && oPtr->fPtr->interp == interp
+		&& oPtr->classPtr != NULL
+		&& ((Command *) oPtr->command)->cmdEpoch ==
+		PTR2INT(objPtr->internalRep.twoPtrValue.ptr2)) {
+	    return oPtr->classPtr;
+	}
+    }
+
+    oPtr = (Object *) Tcl_GetObjectFromObj(interp, objPtr);
+    if (oPtr == NULL) {
+	return NULL;
+    }
+    if (oPtr->classPtr == NULL) {
+	Tcl_AppendResult(interp, "\"", TclGetString(objPtr),
+		"\" is not a class", NULL);
+	return NULL;
+    }
+
+    /*
+     * Only remember the class if the name could not mean anything else from
+     * some other namespace, and if the name refers directly to the class
+     * (and not to an alias or import of it, whose lifetime we can't track).
+     * Also don't trample on other interpretations of the value if we've been
+     * asked not to.
+     */
+
+    name = TclGetString(objPtr);
+    if (name[0] != ':' || name[1] != ':' || oPtr->command == NULL
+	    || Tcl_GetCommandFromObj(interp, objPtr) != oPtr->command) {
+	return oPtr->classPtr;
+    }
+    if (objPtr->typePtr != NULL && objPtr->typePtr != &classNameType
+	    && (oPtr->fPtr->cacheFlags & CACHE_NO_SHIMMER)) {
+	return oPtr->classPtr;
+    }
+    AddRef(oPtr);
+    if (objPtr->typePtr != NULL && objPtr->typePtr->freeIntRepProc != NULL) {
+	objPtr->typePtr->freeIntRepProc(objPtr);
+    }
+    objPtr->typePtr = &classNameType;
+    objPtr->internalRep.twoPtrValue.ptr1 = oPtr;
+    objPtr->internalRep.twoPtrValue.ptr2 =
+	    INT2PTR(((Command *) oPtr->command)->cmdEpoch);
+    return oPtr->classPtr;
+}
+
+static void
+DupClassNameRep(
+    Tcl_Obj *srcPtr,
+    Tcl_Obj *dstPtr)
+{
+    Object *oPtr = srcPtr->internalRep.twoPtrValue.ptr1;
+
+    AddRef(oPtr);
+    dstPtr->typePtr = &classNameType;
+    dstPtr->internalRep.twoPtrValue = srcPtr->internalRep.twoPtrValue;
+}
+
+static void
+FreeClassNameRep(
+    Tcl_Obj *objPtr)
+{
+    Object *oPtr = objPtr->internalRep.twoPtrValue.ptr1;
+
+    DelRef(oPtr);
+    objPtr->typePtr = NULL;
+}
+
 /*
  * ----------------------------------------------------------------------
  *
@@ -2532,6 +3222,313 @@ Tcl_GetObjectName(
     return TclOOObjectName(interp, (Object *) object);
 }
 
+/*
+ * ----------------------------------------------------------------------
+ *
+ * FirstInstanceList --
+ *
+ *	An object is on the instance list of its class and of each class
+ *	mixed into it, so when the instances of several classes are gathered
+ *	up, one with mixins may be found more than once. This works out which
+ *	of the classes being looked at (mapped by the table to their positions
+ *	in the order they are looked at) is the first whose list has the
+ *	object, so that it can be taken from that list only.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+FirstInstanceList(
+    Tcl_HashTable *classTablePtr,
+    Object *oPtr)
+{
+    Tcl_HashEntry *hPtr;
+    Class *mixinPtr;
+    int i, idx, first = INT_MAX;
+
+    hPtr = Tcl_FindHashEntry(classTablePtr, (char *) oPtr->selfCls);
+    if (hPtr != NULL) {
+	first = PTR2INT(Tcl_GetHashValue(hPtr));
+    }
+    FOREACH(mixinPtr, oPtr->mixins) {
+	if (mixinPtr == NULL) {
+	    continue;
+	}
+	hPtr = Tcl_FindHashEntry(classTablePtr, (char *) mixinPtr);
+	if (hPtr != NULL) {
+	    idx = PTR2INT(Tcl_GetHashValue(hPtr));
+	    if (idx < first) {
+		first = idx;
+	    }
+	}
+    }
+    return first;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * Tcl_ClassForeachInstance --
+ *
+ *	Calls a function for each instance of a class (and, if the flags
+ *	include TCL_OO_SUBCLASS_INSTANCES, each instance of its subclasses)
+ *	without building a list of their names. The set of instances is fixed
+ *	when iteration starts; instances deleted before their turn are skipped
+ *	and instances created during the iteration are not visited. Each
+ *	object is visited at most once. If the function returns TCL_BREAK,
+ *	the iteration stops and TCL_OK is returned; any other result other
+ *	than TCL_OK or TCL_CONTINUE stops the iteration and is returned.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+Tcl_ClassForeachInstance(
+    Tcl_Class clazz,
+    int flags,
+    Tcl_ObjectIteratorProc *iterProc,
+    ClientData clientData)
+{
+    Class *clsPtr = (Class *) clazz, *subPtr;
+    Class **classes, *classSpace[8];
+    Object **objects, *instPtr;
+    Tcl_HashTable seen;
+    Tcl_HashEntry *hPtr;
+    int i, j, isNew, numClasses = 1, classSize = 8, numObjects = 0;
+    int result = TCL_OK;
+
+    /*
+     * Work out which classes to look at. Subclasses can be reached by more
+     * than one route when there is multiple inheritance, so remember which
+     * classes have already been seen, and where in the list they are.
+     */
+
+    classes = classSpace;
+    classes[0] = clsPtr;
+    if (flags & TCL_OO_SUBCLASS_INSTANCES) {
+	Tcl_InitHashTable(&seen, TCL_ONE_WORD_KEYS);
+	hPtr = Tcl_CreateHashEntry(&seen, (char *) clsPtr, &isNew);
+	Tcl_SetHashValue(hPtr, INT2PTR(0));
+	for (j=0 ; j<numClasses ; j++) {
+	    FOREACH(subPtr, classes[j]->subclasses) {
+		if (subPtr == NULL) {
+		    continue;
+		}
+		hPtr = Tcl_CreateHashEntry(&seen, (char *) subPtr, &isNew);
+		if (!isNew) {
+		    continue;
+		}
+		Tcl_SetHashValue(hPtr, INT2PTR(numClasses));
+		if (numClasses == classSize) {
+		    classSize *= 2;
+		    if (classes == classSpace) {
+			classes = (Class **)
+				ckalloc(sizeof(Class *) * classSize);
+			memcpy(classes, classSpace, sizeof(classSpace));
+		    } else {
+			classes = (Class **) ckrealloc((char *) classes,
+				sizeof(Class *) * classSize);
+		    }
+		}
+		classes[numClasses++] = subPtr;
+	    }
+	}
+    }
+
+    /*
+     * Take a snapshot of the instances, locking each so that it stays
+     * inspectable even if it is deleted before we get to it. Only the
+     * pointers are copied; names are only generated by whoever wants them.
+     */
+
+    for (i=0,j=0 ; j<numClasses ; j++) {
+	i += classes[j]->instances.num;
+    }
+    objects = (Object **) ckalloc(sizeof(Object *) * (i + 1));
+    for (j=0 ; j<numClasses ; j++) {
+	FOREACH(instPtr, classes[j]->instances) {
+	    if (instPtr == NULL || Deleted(instPtr)) {
+		continue;
+	    }
+	    if ((flags & TCL_OO_SUBCLASS_INSTANCES)
+		    && instPtr->mixins.num > 0
+		    && FirstInstanceList(&seen, instPtr) != j) {
+		continue;
+	    }
+	    AddRef(instPtr);
+	    objects[numObjects++] = instPtr;
+	}
+    }
+    if (flags & TCL_OO_SUBCLASS_INSTANCES) {
+	Tcl_DeleteHashTable(&seen);
+    }
+    if (classes != classSpace) {
+	ckfree((char *) classes);
+    }
+
+    /*
+     * Now walk the snapshot.
+     */
+
+    for (i=0 ; i<numObjects ; i++) {
+	instPtr = objects[i];
+	if (result == TCL_OK && !Deleted(instPtr)) {
+	    result = iterProc(clientData, (Tcl_Object) instPtr);
+	    if (result == TCL_CONTINUE) {
+		result = TCL_OK;
+	    }
+	}
+	DelRef(instPtr);
+    }
+    ckfree((char *) objects);
+    if (result == TCL_BREAK) {
+	result = TCL_OK;
+    }
+    return result;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * Tcl_DeferObjectDeletion, Tcl_DrainDeferredDeletions --
+ *
+ *	Delete an object in two halves. The object's command goes at once, so
+ *	the object can no longer be reached by name, but running its
+ *	destructors and tearing down its namespace and other structures is
+ *	put off until the interpreter is next idle, when it is done in
+ *	batches of at most DEFER_BATCH_SIZE objects at a time so that the
+ *	event loop stays responsive. Tcl_DrainDeferredDeletions finishes off
+ *	everything still waiting straight away, returning how many objects
+ *	that was. Classes may not be deleted this way, as their subclasses and
+ *	instances would be left hanging on to them in the meantime.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+Tcl_DeferObjectDeletion(
+    Tcl_Interp *interp,
+    Tcl_Object object)
+{
+    Object *oPtr = (Object *) object;
+
+    if (Deleted(oPtr)) {
+	return TCL_OK;
+    }
+    if (oPtr->classPtr != NULL) {
+	Tcl_AppendResult(interp, "may not defer the destruction of a class",
+		NULL);
+	return TCL_ERROR;
+    }
+
+    /*
+     * Make sure the object's name is remembered for its destructor, as it
+     * can't be worked out from the command once that has gone.
+     */
+
+    (void) TclOOObjectName(interp, oPtr);
+    oPtr->flags |= DEFERRED_DELETE;
+    Tcl_DeleteCommandFromToken(interp, oPtr->command);
+    return TCL_OK;
+}
+
+int
+Tcl_DrainDeferredDeletions(
+    Tcl_Interp *interp)
+{
+    return FinishDeferred(TclOOGetFoundation(interp), 0);
+}
+
+static void
+DeferredWhenIdle(
+    ClientData clientData)	/* The foundation of the object system. */
+{
+    Foundation *fPtr = clientData;
+
+    fPtr->deferPending = 0;
+    FinishDeferred(fPtr, DEFER_BATCH_SIZE);
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * FinishDeferred --
+ *
+ *	Finish off the objects whose destruction has been deferred, oldest
+ *	first. Destructors may defer the destruction of further objects (or
+ *	drain the queue themselves), so the queue is reread each time round.
+ *
+ * Results:
+ *	The number of objects finished off.
+ *
+ * Side effects:
+ *	If a limit is given and objects are left over, finishing them off is
+ *	rescheduled for when the interpreter is next idle.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+FinishDeferred(
+    Foundation *fPtr,
+    int limit)			/* The most objects to finish off, or 0 for
+				 * no limit. */
+{
+    Object *oPtr;
+    int count = 0;
+
+    while (fPtr->deferredHead < fPtr->deferred.num
+	    && (limit == 0 || count < limit)) {
+	oPtr = fPtr->deferred.list[fPtr->deferredHead++];
+
+	/*
+	 * If the object's namespace has already been deleted, so has the
+	 * object and there is nothing left to do but let go of it.
+	 */
+
+	if (oPtr->flags & DEFERRED_DELETE) {
+	    oPtr->flags &= ~DEFERRED_DELETE;
+	    FinishObjectDeletion(fPtr->interp, oPtr);
+	    count++;
+	}
+	DelRef(oPtr);
+    }
+
+    if (fPtr->deferredHead >= fPtr->deferred.num) {
+	if (fPtr->deferred.list != NULL) {
+	    ckfree((char *) fPtr->deferred.list);
+	    fPtr->deferred.list = NULL;
+	}
+	fPtr->deferred.num = 0;
+	fPtr->deferred.size = 0;
+	fPtr->deferredHead = 0;
+	if (fPtr->deferPending) {
+	    fPtr->deferPending = 0;
+	    Tcl_CancelIdleCall(DeferredWhenIdle, fPtr);
+	}
+	return count;
+    }
+
+    /*
+     * Once most of the queue has been dealt with, move what is left to the
+     * front so that the space can be reused instead of the queue growing
+     * without limit while objects keep being added.
+     */
+
+    if (fPtr->deferredHead > fPtr->deferred.num / 2) {
+	fPtr->deferred.num -= fPtr->deferredHead;
+	memmove(fPtr->deferred.list,
+		fPtr->deferred.list + fPtr->deferredHead,
+		sizeof(Object *) * fPtr->deferred.num);
+	fPtr->deferredHead = 0;
+    }
+    if (!fPtr->deferPending) {
+	fPtr->deferPending = 1;
+	Tcl_DoWhenIdle(DeferredWhenIdle, fPtr);
+    }
+    return count;
+}
+
 /*
  * ----------------------------------------------------------------------
  *
@@ -2618,6 +3615,16 @@ Tcl_ObjectSetMethodNameMapper(
     Tcl_ObjectMapMethodNameProc *mapMethodNameProc)
 {
     ((Object *) object)->mapMethodNameProc = mapMethodNameProc;
+    ((Object *) object)->flags &= ~PURE_NAME_MAPPER;
+}
+
+void
+Tcl_ObjectSetPureMethodNameMapper(
+    Tcl_Object object,
+    Tcl_ObjectMapMethodNameProc *mapMethodNameProc)
+{
+    ((Object *) object)->mapMethodNameProc = mapMethodNameProc;
+    ((Object *) object)->flags |= PURE_NAME_MAPPER;
 }
 
 /*
@@ -58,6 +58,10 @@ typedef int (Tcl_CloneProc)(Tcl_Interp *interp, ClientData oldClientData,
 typedef void (Tcl_ObjectMetadataDeleteProc)(ClientData clientData);
 typedef int (Tcl_ObjectMapMethodNameProc)(Tcl_Interp *interp,
 	Tcl_Object object, Tcl_Class *startClsPtr, Tcl_Obj *methodNameObj);
+typedef int (Tcl_ObjectFilterGuardProc)(ClientData clientData,
+	Tcl_Obj *methodNameObj, int isPublic);
+typedef int (Tcl_ObjectIteratorProc)(ClientData clientData,
+	Tcl_Object object);
 
 /*
  * The type of a method implementation. This describes how to call the method
@@ -116,6 +120,13 @@ typedef struct {
  */
 
 #define TCL_OO_METADATA_VERSION_CURRENT 1
+
+/*
+ * Flags for Tcl_ClassForeachInstance. TCL_OO_SUBCLASS_INSTANCES requests that
+ * the instances of all subclasses of the class are visited as well.
+ */
+
+#define TCL_OO_SUBCLASS_INSTANCES 1
 
 /*
  * Include all the public API, generated from tclOO.decls.
@@ -0,0 +1,228 @@
+/*
+ * tclOOArena.c --
+ *
+ *	This file contains the arenas that the records of the instances of a
+ *	class can be allocated from, so that they lie close together in memory
+ *	and can be released in bulk, together with the [oo::define ... arena]
+ *	command that turns them on.
+ *
+ *	Only Object records go in an arena. The Class record of a class made
+ *	by a metaclass with an arena is still allocated by itself: it is a
+ *	different size, it is not on the instance lists that the arena is
+ *	there to speed up, and classes are few and long-lived enough that
+ *	scattering them costs little.
+ *
+ * Copyright (c) 2026 by agent
+ *
+ * See the file "license.terms" for information on usage and redistribution of
+ * this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "tclInt.h"
+#include "tclOOInt.h"
+
+/*
+ * The first word of an unused record is used to chain the free list.
+ */
+
+#define NextFree(oPtr)	(*((Object **) (oPtr)))
+
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOONewArena --
+ *
+ *	Make an arena for a class to allocate the records of its instances
+ *	from. The arena starts with one reference, which belongs to the class.
+ *	No memory is allocated for records until the first is asked for.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+ObjectArena *
+TclOONewArena(
+    int blockSize)		/* Number of records to allocate at a time. */
+{
+    ObjectArena *arenaPtr = (ObjectArena *) ckalloc(sizeof(ObjectArena));
+
+    arenaPtr->refCount = 1;
+    arenaPtr->blockSize = blockSize;
+    arenaPtr->blocksPtr = NULL;
+    arenaPtr->freePtr = NULL;
+    return arenaPtr;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOArenaAlloc --
+ *
+ *	Allocate an object record from an arena, adding a new block to the
+ *	arena if all its records are in use. The records of a new block are
+ *	handed out in address order.
+ *
+ * Results:
+ *	The (uninitialized) record. It holds a reference to the arena, and must
+ *	be given back with TclOOArenaFree.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+Object *
+TclOOArenaAlloc(
+    ObjectArena *arenaPtr)
+{
+    Object *oPtr;
+
+    if (arenaPtr->freePtr == NULL) {
+	ArenaBlock *blockPtr = (ArenaBlock *) ckalloc(sizeof(ArenaBlock)
+		+ sizeof(Object) * arenaPtr->blockSize);
+	Object *records = (Object *) (blockPtr + 1);
+	int i;
+
+	blockPtr->numRecords = arenaPtr->blockSize;
+	blockPtr->nextPtr = arenaPtr->blocksPtr;
+	arenaPtr->blocksPtr = blockPtr;
+	for (i=blockPtr->numRecords-1 ; i>=0 ; i--) {
+	    NextFree(&records[i]) = arenaPtr->freePtr;
+	    arenaPtr->freePtr = &records[i];
+	}
+    }
+
+    oPtr = arenaPtr->freePtr;
+    arenaPtr->freePtr = NextFree(oPtr);
+    arenaPtr->refCount++;
+    return oPtr;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOArenaFree --
+ *
+ *	Give an object record back to the arena it was allocated from. Called
+ *	from DelRef when the last reference to the object goes.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+void
+TclOOArenaFree(
+    Object *oPtr)
+{
+    ObjectArena *arenaPtr = oPtr->arenaPtr;
+
+    NextFree(oPtr) = arenaPtr->freePtr;
+    arenaPtr->freePtr = oPtr;
+    TclOOReleaseArena(arenaPtr);
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOReleaseArena --
+ *
+ *	Drop a reference to an arena. Once nothing refers to it (neither the
+ *	class nor any of the records allocated from it), all its blocks are
+ *	freed at once.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+void
+TclOOReleaseArena(
+    ObjectArena *arenaPtr)
+{
+    ArenaBlock *blockPtr, *nextPtr;
+
+    if (--arenaPtr->refCount > 0) {
+	return;
+    }
+    for (blockPtr=arenaPtr->blocksPtr ; blockPtr!=NULL ; blockPtr=nextPtr) {
+	nextPtr = blockPtr->nextPtr;
+	ckfree((char *) blockPtr);
+    }
+    ckfree((char *) arenaPtr);
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOODefineArenaObjCmd --
+ *	Implementation of the "arena" subcommand of the "oo::define" command.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+TclOODefineArenaObjCmd(
+    ClientData clientData,
+    Tcl_Interp *interp,
+    int objc,
+    Tcl_Obj *const *objv)
+{
+    Object *oPtr;
+    Class *clsPtr;
+    int blockSize = ARENA_DEFAULT_SIZE;
+
+    if (objc > 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "?blockSize?");
+	return TCL_ERROR;
+    }
+
+    oPtr = (Object *) TclOOGetDefineCmdContext(interp);
+    if (oPtr == NULL) {
+	return TCL_ERROR;
+    }
+    clsPtr = oPtr->classPtr;
+    if (clsPtr == NULL) {
+	Tcl_AppendResult(interp, "attempt to misuse API", NULL);
+	return TCL_ERROR;
+    }
+    if (objc == 2
+	    && Tcl_GetIntFromObj(interp, objv[1], &blockSize) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    if (blockSize < 0) {
+	Tcl_AppendResult(interp, "arena block size may not be negative",
+		NULL);
+	return TCL_ERROR;
+    }
+    if (blockSize > ARENA_MAX_SIZE) {
+	char buf[TCL_INTEGER_SPACE];
+
+	sprintf(buf, "%d", ARENA_MAX_SIZE);
+	Tcl_AppendResult(interp, "arena block size may not be more than ",
+		buf, NULL);
+	return TCL_ERROR;
+    }
+
+    /*
+     * Only affects the objects made from now on; existing records stay where
+     * they are (keeping any arena they are in alive) until they are freed.
+     */
+
+    if (blockSize == 0) {
+	if (clsPtr->arenaPtr != NULL) {
+	    TclOOReleaseArena(clsPtr->arenaPtr);
+	    clsPtr->arenaPtr = NULL;
+	}
+    } else if (clsPtr->arenaPtr != NULL) {
+	clsPtr->arenaPtr->blockSize = blockSize;
+    } else {
+	clsPtr->arenaPtr = TclOONewArena(blockSize);
+    }
+    return TCL_OK;
+}
+
+/*
+ * Local Variables:
+ * mode: c
+ * c-basic-offset: 4
+ * fill-column: 78
+ * End:
+ */
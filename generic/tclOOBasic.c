@@ -15,6 +15,12 @@
 #endif
 #include "tclInt.h"
 #include "tclOOInt.h"
+
+/*
+ * Function declarations for things defined in this file.
+ */
+
+static void		CollectWhenIdle(ClientData clientData);
 
 /*
  * ----------------------------------------------------------------------
@@ -237,6 +243,7 @@ TclOO_Class_New(
 {
     Object *oPtr = (Object *) Tcl_ObjectContextObject(context);
     Tcl_Object newObject;
+    Tcl_Obj *nameObj;
 
     /*
      * Sanity check; should not be possible to invoke this method on a
@@ -260,10 +267,124 @@ TclOO_Class_New(
     if (newObject == NULL) {
 	return TCL_ERROR;
     }
-    Tcl_SetObjResult(interp, TclOOObjectName(interp, (Object *) newObject));
+    nameObj = TclOOObjectName(interp, (Object *) newObject);
+    Tcl_SetObjResult(interp, nameObj);
+
+    /*
+     * If the class's instances are destroyed automatically, the name we
+     * return is the handle that decides how long the object lives. Looking
+     * for objects to destroy only happens when the interpreter is idle (or
+     * in [oo::collect]), never here, so that destructors do not run in the
+     * middle of whatever code called [new].
+     */
+
+    if (oPtr->classPtr->flags & AUTO_DESTROY) {
+	Foundation *fPtr = oPtr->fPtr;
+	Tcl_HashEntry *hPtr;
+	int isNew;
+
+	hPtr = Tcl_CreateHashEntry(&fPtr->autoTable, (char *) newObject,
+		&isNew);
+	if (isNew) {
+	    AddRef((Object *) newObject);
+	} else {
+	    /*
+	     * A pooled object, reused before its old handle was let go of.
+	     */
+
+	    Tcl_DecrRefCount((Tcl_Obj *) Tcl_GetHashValue(hPtr));
+	}
+	Tcl_IncrRefCount(nameObj);
+	Tcl_SetHashValue(hPtr, nameObj);
+	if (!fPtr->collectPending) {
+	    fPtr->collectPending = 1;
+	    Tcl_DoWhenIdle(CollectWhenIdle, fPtr);
+	}
+    }
     return TCL_OK;
 }
 
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOCollectObjects, CollectWhenIdle --
+ *
+ *	Destroy the objects made by [new] from classes whose instances are
+ *	destroyed automatically, once nothing refers to their handles. An
+ *	object is only taken to be unused if the only references to its
+ *	handle are our own and the object's cached name, and if nothing has
+ *	locked the object (as calling a method does).
+ *
+ * Results:
+ *	The number of objects destroyed.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+TclOOCollectObjects(
+    Foundation *fPtr,
+    int all)			/* Whether to just let go of all the objects,
+				 * as the interpreter is being deleted. */
+{
+    Tcl_HashEntry *hPtr;
+    Tcl_HashSearch search;
+    Object *oPtr, **garbage;
+    Tcl_Obj *handleObj;
+    int i, numGarbage = 0;
+
+    if (fPtr->collectPending) {
+	fPtr->collectPending = 0;
+	Tcl_CancelIdleCall(CollectWhenIdle, fPtr);
+    }
+    if (fPtr->autoTable.numEntries == 0) {
+	return 0;
+    }
+
+    /*
+     * Work out what to destroy before destroying any of it, as destructors
+     * can make and destroy other objects.
+     */
+
+    garbage = (Object **)
+	    ckalloc(sizeof(Object *) * fPtr->autoTable.numEntries);
+    for (hPtr=Tcl_FirstHashEntry(&fPtr->autoTable, &search); hPtr!=NULL;
+	    hPtr=Tcl_NextHashEntry(&search)) {
+	oPtr = (Object *) Tcl_GetHashKey(&fPtr->autoTable, hPtr);
+	handleObj = Tcl_GetHashValue(hPtr);
+	if (all || oPtr->command == NULL) {
+	    DelRef(oPtr);
+	} else if ((handleObj->refCount > 1 +
+		(oPtr->cachedNameObj == handleObj)) || (oPtr->refCount > 2)) {
+	    continue;
+	} else {
+	    garbage[numGarbage++] = oPtr;
+	}
+	Tcl_DecrRefCount(handleObj);
+	Tcl_DeleteHashEntry(hPtr);
+    }
+
+    for (i=0 ; i<numGarbage ; i++) {
+	oPtr = garbage[i];
+	if (oPtr->command != NULL) {
+	    Tcl_DeleteCommandFromToken(fPtr->interp, oPtr->command);
+	}
+	DelRef(oPtr);
+    }
+    ckfree((char *) garbage);
+    return numGarbage;
+}
+
+static void
+CollectWhenIdle(
+    ClientData clientData)	/* The foundation of the object system. */
+{
+    Foundation *fPtr = clientData;
+
+    fPtr->collectPending = 0;
+    TclOOCollectObjects(fPtr, 0);
+}
+
 /*
  * ----------------------------------------------------------------------
  *
@@ -284,11 +405,13 @@ TclOO_Object_Destroy(
     Tcl_Obj *const *objv)	/* The actual arguments. */
 {
     Object *oPtr = (Object *) Tcl_ObjectContextObject(context);
+    int skip = Tcl_ObjectContextSkippedArgs(context);
     int result = TCL_OK;
 
-    if (objc != Tcl_ObjectContextSkippedArgs(context)) {
-	Tcl_WrongNumArgs(interp, Tcl_ObjectContextSkippedArgs(context), objv,
-		NULL);
+    if (objc == skip+1 && !strcmp(TclGetString(objv[skip]), "-deferred")) {
+	return Tcl_DeferObjectDeletion(interp, (Tcl_Object) oPtr);
+    } else if (objc != skip) {
+	Tcl_WrongNumArgs(interp, skip, objv, "?-deferred?");
 	return TCL_ERROR;
     }
     AddRef(oPtr);
@@ -303,7 +426,8 @@ TclOO_Object_Destroy(
 	    TclOODeleteContext(contextPtr);
 	}
     }
-    if (oPtr->command) {
+    if (oPtr->command && (result != TCL_OK || oPtr->selfCls->poolSize == 0
+	    || !TclOOParkObject(interp, oPtr))) {
 	Tcl_DeleteCommandFromToken(interp, oPtr->command);
     }
     DelRef(oPtr);
@@ -732,8 +856,7 @@ TclOONextToObjCmd(
     CallFrame *framePtr = iPtr->varFramePtr;
     Class *classPtr;
     CallContext *contextPtr;
-    int i;
-    Tcl_Object object;
+    int index;
 
     /*
      * Start with sanity checks on the calling context to make sure that we
@@ -756,43 +879,34 @@ TclOONextToObjCmd(
 	Tcl_WrongNumArgs(interp, 1, objv, "class ?arg...?");
 	return TCL_ERROR;
     }
-    object = Tcl_GetObjectFromObj(interp, objv[1]);
-    if (object == NULL) {
-	return TCL_ERROR;
-    }
-    classPtr = ((Object *)object)->classPtr;
+    classPtr = TclOOGetClassFromObj(interp, objv[1]);
     if (classPtr == NULL) {
-	Tcl_AppendResult(interp, "\"", TclGetString(objv[1]),
-		"\" is not a class", NULL);
 	return TCL_ERROR;
     }
 
     /*
-     * Search for an implementation of a method associated with the current
-     * call on the call chain past the point where we currently are. Do not
-     * allow jumping backwards!
+     * Find the implementation of a method associated with the current call
+     * on the call chain past the point where we currently are. Do not allow
+     * jumping backwards!
      */
 
-    for (i=contextPtr->index+1 ; i<contextPtr->callPtr->numChain ; i++) {
-	struct MInvoke *miPtr = contextPtr->callPtr->chain + i;
-
-	if (!miPtr->isFilter && miPtr->mPtr->declaringClassPtr == classPtr) {
-	    /*
-	     * Invoke the (advanced) method call context in the caller
-	     * context. Note that this is like [uplevel 1] and not [eval].
-	     */
+    index = TclOOGetChainIndex(contextPtr->callPtr, classPtr);
+    if (index > contextPtr->index) {
+	/*
+	 * Invoke the (advanced) method call context in the caller context.
+	 * Note that this is like [uplevel 1] and not [eval].
+	 */
 
-	    int savedDepth = contextPtr->index;
-	    int result;
+	int savedDepth = contextPtr->index;
+	int result;
 
-	    contextPtr->index = i - 1;
-	    iPtr->varFramePtr = framePtr->callerVarPtr;
-	    result = Tcl_ObjectContextInvokeNext(interp,
-		    (Tcl_ObjectContext) contextPtr, objc, objv, 2);
-	    iPtr->varFramePtr = framePtr;
-	    contextPtr->index = savedDepth;
-	    return result;
-	}
+	contextPtr->index = index - 1;
+	iPtr->varFramePtr = framePtr->callerVarPtr;
+	result = Tcl_ObjectContextInvokeNext(interp,
+		(Tcl_ObjectContext) contextPtr, objc, objv, 2);
+	iPtr->varFramePtr = framePtr;
+	contextPtr->index = savedDepth;
+	return result;
     }
 
     /*
@@ -800,15 +914,10 @@ TclOONextToObjCmd(
      * is on the chain but unreachable, or not on the chain at all.
      */
 
-    for (i=contextPtr->index ; i>=0 ; i--) {
-	struct MInvoke *miPtr = contextPtr->callPtr->chain + i;
-
-	if (!miPtr->isFilter && miPtr->mPtr->declaringClassPtr == classPtr) {
-	    Tcl_AppendResult(interp, "method implementation by \"",
-		    TclGetString(objv[1]), "\" not reachable from here",
-		    NULL);
-	    return TCL_ERROR;
-	}
+    if (index >= 0) {
+	Tcl_AppendResult(interp, "method implementation by \"",
+		TclGetString(objv[1]), "\" not reachable from here", NULL);
+	return TCL_ERROR;
     }
     Tcl_AppendResult(interp, "method has no non-filter implementation by \"",
 	    TclGetString(objv[1]), "\"", NULL);
@@ -1042,6 +1151,166 @@ TclOOSelfObjCmd(
     return TCL_ERROR;
 }
 
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOCollectObjCmd --
+ *
+ *	Implementation of the [oo::collect] command, which finishes off the
+ *	objects whose destruction was deferred and destroys the
+ *	automatically-destroyed objects that are no longer referred to now,
+ *	rather than waiting until the interpreter is next idle.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+TclOOCollectObjCmd(
+    ClientData clientData,
+    Tcl_Interp *interp,
+    int objc,
+    Tcl_Obj *const *objv)
+{
+    Foundation *fPtr = TclOOGetFoundation(interp);
+    int count;
+
+    if (objc != 1) {
+	Tcl_WrongNumArgs(interp, 1, objv, NULL);
+	return TCL_ERROR;
+    }
+    count = Tcl_DrainDeferredDeletions(interp);
+    count += TclOOCollectObjects(fPtr, 0);
+    Tcl_SetObjResult(interp, Tcl_NewIntObj(count));
+    return TCL_OK;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOCacheObjCmd --
+ *
+ *	Implementation of the [oo::cache] command, which allows inspection
+ *	and tuning of how method call chains are cached.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+TclOOCacheObjCmd(
+    ClientData clientData,
+    Tcl_Interp *interp,
+    int objc,
+    Tcl_Obj *const *objv)
+{
+    static const char *subcmds[] = {
+	"mode", "rewarm", "stats", NULL
+    };
+    enum CacheSubcmds {
+	CACHE_MODE, CACHE_REWARM_SUBCMD, CACHE_STATS
+    };
+    static const char *modes[] = {
+	"intrep", "table", NULL
+    };
+    Foundation *fPtr = TclOOGetFoundation(interp);
+    Tcl_Obj *resultObj;
+    int idx;
+
+    if (objc < 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "subcommand ?arg ...?");
+	return TCL_ERROR;
+    }
+    if (Tcl_GetIndexFromObj(interp, objv[1], subcmds, "subcommand", 0,
+	    &idx) != TCL_OK) {
+	return TCL_ERROR;
+    }
+
+    switch ((enum CacheSubcmds) idx) {
+    case CACHE_MODE:
+	if (objc > 3) {
+	    Tcl_WrongNumArgs(interp, 2, objv, "?mode?");
+	    return TCL_ERROR;
+	}
+	if (objc == 3) {
+	    int mode;
+
+	    if (Tcl_GetIndexFromObj(interp, objv[2], modes, "mode", 0,
+		    &mode) != TCL_OK) {
+		return TCL_ERROR;
+	    }
+	    if (mode) {
+		fPtr->cacheFlags |= CACHE_NO_SHIMMER;
+	    } else {
+		fPtr->cacheFlags &= ~CACHE_NO_SHIMMER;
+	    }
+	}
+	Tcl_SetObjResult(interp, Tcl_NewStringObj(
+		modes[(fPtr->cacheFlags & CACHE_NO_SHIMMER) ? 1 : 0], -1));
+	return TCL_OK;
+
+    case CACHE_REWARM_SUBCMD:
+	if (objc > 3) {
+	    Tcl_WrongNumArgs(interp, 2, objv, "?boolean?");
+	    return TCL_ERROR;
+	}
+	if (objc == 3) {
+	    int rewarm;
+
+	    if (Tcl_GetBooleanFromObj(interp, objv[2], &rewarm) != TCL_OK) {
+		return TCL_ERROR;
+	    }
+	    if (rewarm) {
+		fPtr->cacheFlags |= CACHE_REWARM;
+	    } else {
+		fPtr->cacheFlags &= ~CACHE_REWARM;
+		TclOOCancelRewarm(fPtr);
+	    }
+	}
+	Tcl_SetObjResult(interp,
+		Tcl_NewBooleanObj(fPtr->cacheFlags & CACHE_REWARM));
+	return TCL_OK;
+
+    case CACHE_STATS:
+	if (objc == 3 && !strcmp(TclGetString(objv[2]), "-reset")) {
+	    memset(&fPtr->cacheStats, 0, sizeof(CacheStats));
+	} else if (objc != 2) {
+	    Tcl_WrongNumArgs(interp, 2, objv, "?-reset?");
+	    return TCL_ERROR;
+	}
+	resultObj = Tcl_NewObj();
+	Tcl_ListObjAppendElement(NULL, resultObj,
+		Tcl_NewStringObj("stashes", -1));
+	Tcl_ListObjAppendElement(NULL, resultObj,
+		Tcl_NewLongObj(fPtr->cacheStats.stashes));
+	Tcl_ListObjAppendElement(NULL, resultObj,
+		Tcl_NewStringObj("shimmers", -1));
+	Tcl_ListObjAppendElement(NULL, resultObj,
+		Tcl_NewLongObj(fPtr->cacheStats.shimmers));
+	Tcl_ListObjAppendElement(NULL, resultObj,
+		Tcl_NewStringObj("avoided", -1));
+	Tcl_ListObjAppendElement(NULL, resultObj,
+		Tcl_NewLongObj(fPtr->cacheStats.avoided));
+	Tcl_ListObjAppendElement(NULL, resultObj,
+		Tcl_NewStringObj("tablehits", -1));
+	Tcl_ListObjAppendElement(NULL, resultObj,
+		Tcl_NewLongObj(fPtr->cacheStats.tableHits));
+	Tcl_ListObjAppendElement(NULL, resultObj,
+		Tcl_NewStringObj("epochs", -1));
+	Tcl_ListObjAppendElement(NULL, resultObj,
+		Tcl_NewLongObj(fPtr->cacheStats.epochs));
+	Tcl_ListObjAppendElement(NULL, resultObj,
+		Tcl_NewStringObj("rewarms", -1));
+	Tcl_ListObjAppendElement(NULL, resultObj,
+		Tcl_NewLongObj(fPtr->cacheStats.rewarms));
+	Tcl_ListObjAppendElement(NULL, resultObj,
+		Tcl_NewStringObj("bodyshares", -1));
+	Tcl_ListObjAppendElement(NULL, resultObj,
+		Tcl_NewLongObj(fPtr->cacheStats.bodyShares));
+	Tcl_SetObjResult(interp, resultObj);
+	return TCL_OK;
+    }
+    return TCL_ERROR;
+}
+
 /*
  * ----------------------------------------------------------------------
  *
@@ -1116,6 +1385,872 @@ TclOOCopyObjectCmd(
     return TCL_OK;
 }
 
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOSerializeObjCmd, TclOODeserializeObjCmd --
+ *
+ *	Implementation of the [oo::serialize] and [oo::deserialize] commands,
+ *	which save the state of an object (the variables in its namespace and
+ *	its object-level mixins, filters and variable declarations) in a
+ *	compact binary form, and make a new object from such a saved state
+ *	without calling any constructor. The format is:
+ *
+ *	    "TOOS" version(1 byte) length(4 bytes) payload(length bytes)
+ *
+ *	where the payload is the counted list of mixin names, the counted list
+ *	of filter names, the counted list of declared variable names, and then
+ *	the counted list of variables, each of which is a name, a kind byte (0
+ *	for a scalar, 1 for an array) and then either the value or a counted
+ *	list of alternating element names and values. Strings are counted too,
+ *	and all counts are 4-byte big-endian unsigned integers.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+#define SERIAL_MAGIC		"TOOS"
+#define SERIAL_VERSION		1
+#define SERIAL_HEADER_SIZE	9
+#define SERIAL_SCALAR		0
+#define SERIAL_ARRAY		1
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOSerialPutWord, TclOOSerialPatchWord, TclOOSerialPutString,
+ * TclOOSerialGetWord, TclOOSerialGetCount, TclOOSerialGetString --
+ *
+ *	Helpers for writing and reading the counted, big-endian binary forms
+ *	used by [oo::serialize] and by class library images (see
+ *	tclOOShare.c). The readers return zero (or NULL) if the data runs out
+ *	or a count is impossibly large.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+void
+TclOOSerialPutWord(
+    Tcl_DString *dsPtr,
+    unsigned int value)
+{
+    char buf[4];
+
+    buf[0] = (char) (value >> 24);
+    buf[1] = (char) (value >> 16);
+    buf[2] = (char) (value >> 8);
+    buf[3] = (char) value;
+    Tcl_DStringAppend(dsPtr, buf, 4);
+}
+
+void
+TclOOSerialPatchWord(
+    Tcl_DString *dsPtr,
+    int pos,
+    unsigned int value)
+{
+    char *buf = Tcl_DStringValue(dsPtr) + pos;
+
+    buf[0] = (char) (value >> 24);
+    buf[1] = (char) (value >> 16);
+    buf[2] = (char) (value >> 8);
+    buf[3] = (char) value;
+}
+
+void
+TclOOSerialPutString(
+    Tcl_DString *dsPtr,
+    Tcl_Obj *objPtr)
+{
+    int length;
+    const char *bytes = Tcl_GetStringFromObj(objPtr, &length);
+
+    TclOOSerialPutWord(dsPtr, (unsigned) length);
+    Tcl_DStringAppend(dsPtr, bytes, length);
+}
+
+static unsigned int
+DecodeWord(
+    const unsigned char *p)
+{
+    return ((unsigned) p[0] << 24) | ((unsigned) p[1] << 16)
+	    | ((unsigned) p[2] << 8) | (unsigned) p[3];
+}
+
+int
+TclOOSerialGetWord(
+    SerialReader *rPtr,
+    unsigned int *valuePtr)
+{
+    if (rPtr->length - rPtr->pos < 4) {
+	return 0;
+    }
+    *valuePtr = DecodeWord(rPtr->bytes + rPtr->pos);
+    rPtr->pos += 4;
+    return 1;
+}
+
+int
+TclOOSerialGetCount(
+    SerialReader *rPtr,
+    unsigned int *countPtr)
+{
+    /*
+     * Every counted item takes at least four bytes, which puts a limit on
+     * how big a count can sensibly be.
+     */
+
+    return TclOOSerialGetWord(rPtr, countPtr)
+	    && *countPtr <= (unsigned) (rPtr->length - rPtr->pos) / 4;
+}
+
+Tcl_Obj *
+TclOOSerialGetString(
+    SerialReader *rPtr)
+{
+    unsigned int length;
+    Tcl_Obj *objPtr;
+
+    if (!TclOOSerialGetWord(rPtr, &length)
+	    || length > (unsigned) (rPtr->length - rPtr->pos)) {
+	return NULL;
+    }
+    objPtr = Tcl_NewStringObj((const char *) rPtr->bytes + rPtr->pos,
+	    (int) length);
+    Tcl_IncrRefCount(objPtr);
+    rPtr->pos += length;
+    return objPtr;
+}
+
+static int
+CheckSerialHeader(
+    Tcl_Interp *interp,
+    const unsigned char *header,
+    unsigned int *lengthPtr)
+{
+    if (memcmp(header, SERIAL_MAGIC, 4) != 0) {
+	Tcl_AppendResult(interp, "not a serialized object", NULL);
+	return TCL_ERROR;
+    }
+    if (header[4] != SERIAL_VERSION) {
+	char buf[TCL_INTEGER_SPACE];
+
+	sprintf(buf, "%d", header[4]);
+	Tcl_AppendResult(interp, "unsupported serialized object version ",
+		buf, NULL);
+	return TCL_ERROR;
+    }
+    *lengthPtr = DecodeWord(header + 5);
+    return TCL_OK;
+}
+
+int
+TclOOSerializeObjCmd(
+    ClientData clientData,
+    Tcl_Interp *interp,
+    int objc,
+    Tcl_Obj *const *objv)
+{
+    Object *oPtr;
+    Class *mixinPtr;
+    Tcl_Channel chan = NULL;
+    Tcl_DString buffer;
+    Tcl_HashTable *tablePtr;
+    Tcl_HashEntry *hPtr, *elemPtr;
+    Tcl_HashSearch search, elemSearch;
+    Tcl_Obj *objPtr;
+    Var *varPtr, *elemVarPtr;
+    int i, mode, count, countPos, numElems, numElemsPos;
+    char kind;
+
+    if (objc < 2 || objc > 3) {
+	Tcl_WrongNumArgs(interp, 1, objv, "objectName ?channelId?");
+	return TCL_ERROR;
+    }
+    oPtr = (Object *) Tcl_GetObjectFromObj(interp, objv[1]);
+    if (oPtr == NULL) {
+	return TCL_ERROR;
+    }
+    if (objc == 3) {
+	chan = Tcl_GetChannel(interp, TclGetString(objv[2]), &mode);
+	if (chan == NULL) {
+	    return TCL_ERROR;
+	}
+	if (!(mode & TCL_WRITABLE)) {
+	    Tcl_AppendResult(interp, "channel \"", TclGetString(objv[2]),
+		    "\" wasn't opened for writing", NULL);
+	    return TCL_ERROR;
+	}
+    }
+
+    Tcl_DStringInit(&buffer);
+    Tcl_DStringAppend(&buffer, SERIAL_MAGIC, 4);
+    kind = SERIAL_VERSION;
+    Tcl_DStringAppend(&buffer, &kind, 1);
+    TclOOSerialPutWord(&buffer, 0);
+
+    TclOOSerialPutWord(&buffer, (unsigned) oPtr->mixins.num);
+    FOREACH(mixinPtr, oPtr->mixins) {
+	TclOOSerialPutString(&buffer,
+		TclOOObjectName(interp, mixinPtr->thisPtr));
+    }
+    TclOOSerialPutWord(&buffer, (unsigned) oPtr->filters.num);
+    FOREACH(objPtr, oPtr->filters) {
+	TclOOSerialPutString(&buffer, objPtr);
+    }
+    TclOOSerialPutWord(&buffer, (unsigned) oPtr->variables.num);
+    FOREACH(objPtr, oPtr->variables) {
+	TclOOSerialPutString(&buffer, objPtr);
+    }
+
+    /*
+     * Walk the variables of the object's namespace directly. Links to other
+     * variables are not part of the object's state, and values are read
+     * without triggering any traces.
+     */
+
+    countPos = Tcl_DStringLength(&buffer);
+    TclOOSerialPutWord(&buffer, 0);
+    count = 0;
+    tablePtr = TclVarTable(oPtr->namespacePtr);
+    for (hPtr=Tcl_FirstHashEntry(tablePtr, &search) ; hPtr!=NULL ;
+	    hPtr=Tcl_NextHashEntry(&search)) {
+	varPtr = (Var *) TclVarHashGetValue(hPtr);
+	if (TclIsVarUndefined(varPtr) || TclIsVarLink(varPtr)) {
+	    continue;
+	}
+	TclOOSerialPutString(&buffer, TclVarHashGetKey(hPtr));
+	if (TclIsVarArray(varPtr)) {
+	    kind = SERIAL_ARRAY;
+	    Tcl_DStringAppend(&buffer, &kind, 1);
+	    numElemsPos = Tcl_DStringLength(&buffer);
+	    TclOOSerialPutWord(&buffer, 0);
+	    numElems = 0;
+	    for (elemPtr=Tcl_FirstHashEntry(&varPtr->value.tablePtr->table,
+		    &elemSearch) ; elemPtr!=NULL ;
+		    elemPtr=Tcl_NextHashEntry(&elemSearch)) {
+		elemVarPtr = (Var *) TclVarHashGetValue(elemPtr);
+		if (TclIsVarUndefined(elemVarPtr)
+			|| !TclIsVarScalar(elemVarPtr)) {
+		    continue;
+		}
+		TclOOSerialPutString(&buffer, TclVarHashGetKey(elemPtr));
+		TclOOSerialPutString(&buffer, elemVarPtr->value.objPtr);
+		numElems++;
+	    }
+	    TclOOSerialPatchWord(&buffer, numElemsPos, (unsigned) numElems);
+	} else {
+	    kind = SERIAL_SCALAR;
+	    Tcl_DStringAppend(&buffer, &kind, 1);
+	    TclOOSerialPutString(&buffer, varPtr->value.objPtr);
+	}
+	count++;
+    }
+    TclOOSerialPatchWord(&buffer, countPos, (unsigned) count);
+    TclOOSerialPatchWord(&buffer, 5, (unsigned)
+	    (Tcl_DStringLength(&buffer) - SERIAL_HEADER_SIZE));
+
+    /*
+     * Hand the result back, either as a byte array or by writing it to the
+     * channel.
+     */
+
+    if (chan == NULL) {
+	Tcl_SetObjResult(interp, Tcl_NewByteArrayObj((unsigned char *)
+		Tcl_DStringValue(&buffer), Tcl_DStringLength(&buffer)));
+	i = TCL_OK;
+    } else if (Tcl_Write(chan, Tcl_DStringValue(&buffer),
+	    Tcl_DStringLength(&buffer)) < 0) {
+	Tcl_AppendResult(interp, "error writing \"", TclGetString(objv[2]),
+		"\": ", Tcl_PosixError(interp), NULL);
+	i = TCL_ERROR;
+    } else {
+	i = TCL_OK;
+    }
+    Tcl_DStringFree(&buffer);
+    return i;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * IsLocalVariableName --
+ *
+ *	Says whether a variable name from a serialized object is a plain name
+ *	that refers to a variable in the object's namespace, and not to one
+ *	in some other namespace or to an array element.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+IsLocalVariableName(
+    const char *name)
+{
+    return (name[0] != '\0' && strstr(name, "::") == NULL
+	    && strchr(name, '(') == NULL);
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * RestoreObjectState --
+ *
+ *	Apply the payload of a serialized object to an object, or (if oPtr is
+ *	NULL) just check that it could be applied, leaving an error message in
+ *	the interpreter if not.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+RestoreObjectState(
+    Tcl_Interp *interp,
+    Object *oPtr,
+    SerialReader *rPtr)
+{
+    Tcl_CallFrame frame;
+    Tcl_Obj **objs = NULL, *nameObj, *keyObj, *valueObj;
+    Class **mixins;
+    unsigned int i, j, count, numElems;
+    int result = TCL_ERROR;
+
+    /*
+     * Mixins, which must still be classes.
+     */
+
+    if (!TclOOSerialGetCount(rPtr, &count)) {
+	goto malformed;
+    }
+    mixins = (Class **) ckalloc(sizeof(Class *) * (count + 1));
+    for (i=0 ; i<count ; i++) {
+	nameObj = TclOOSerialGetString(rPtr);
+	if (nameObj == NULL) {
+	    ckfree((char *) mixins);
+	    goto malformed;
+	}
+	mixins[i] = TclOOGetClassFromObj(interp, nameObj);
+	Tcl_DecrRefCount(nameObj);
+	if (mixins[i] == NULL) {
+	    ckfree((char *) mixins);
+	    return TCL_ERROR;
+	}
+    }
+    if (oPtr != NULL && count > 0) {
+	TclOOObjectSetMixins(oPtr, (int) count, mixins);
+    }
+    ckfree((char *) mixins);
+
+    /*
+     * Filters and declared variables, which are just lists of names.
+     */
+
+    if (!TclOOSerialGetCount(rPtr, &count)) {
+	goto malformed;
+    }
+    objs = (Tcl_Obj **) ckalloc(sizeof(Tcl_Obj *) * (count + 1));
+    for (i=0 ; i<count ; i++) {
+	objs[i] = TclOOSerialGetString(rPtr);
+	if (objs[i] == NULL) {
+	    goto freeObjs;
+	}
+    }
+    if (oPtr != NULL && count > 0) {
+	TclOOObjectSetFilters(oPtr, (int) count, objs);
+    }
+    for (j=0 ; j<count ; j++) {
+	Tcl_DecrRefCount(objs[j]);
+    }
+    ckfree((char *) objs);
+
+    if (!TclOOSerialGetCount(rPtr, &count)) {
+	goto malformed;
+    }
+    objs = (Tcl_Obj **) ckalloc(sizeof(Tcl_Obj *) * (count + 1));
+    for (i=0 ; i<count ; i++) {
+	objs[i] = TclOOSerialGetString(rPtr);
+	if (objs[i] == NULL) {
+	    goto freeObjs;
+	}
+	if (!IsLocalVariableName(TclGetString(objs[i]))) {
+	    Tcl_DecrRefCount(objs[i]);
+	    goto freeObjs;
+	}
+    }
+    if (oPtr != NULL && count > 0) {
+	oPtr->variables.list = objs;
+	oPtr->variables.num = (int) count;
+    } else {
+	for (j=0 ; j<count ; j++) {
+	    Tcl_DecrRefCount(objs[j]);
+	}
+	ckfree((char *) objs);
+    }
+    objs = NULL;
+
+    /*
+     * The variables themselves, which are set in the context of the object's
+     * namespace. Their names were checked to be plain names, so they cannot
+     * reach variables outside it.
+     */
+
+    if (!TclOOSerialGetCount(rPtr, &count)) {
+	goto malformed;
+    }
+    if (oPtr != NULL) {
+	(void) Tcl_PushCallFrame(interp, &frame, oPtr->namespacePtr, 0);
+    }
+    for (i=0 ; i<count ; i++) {
+	if ((nameObj = TclOOSerialGetString(rPtr)) == NULL) {
+	    goto malformedInFrame;
+	}
+	if (!IsLocalVariableName(TclGetString(nameObj))) {
+	    Tcl_DecrRefCount(nameObj);
+	    goto malformedInFrame;
+	}
+	if (rPtr->pos >= rPtr->length) {
+	    Tcl_DecrRefCount(nameObj);
+	    goto malformedInFrame;
+	}
+	switch (rPtr->bytes[rPtr->pos++]) {
+	case SERIAL_SCALAR:
+	    if ((valueObj = TclOOSerialGetString(rPtr)) == NULL) {
+		Tcl_DecrRefCount(nameObj);
+		goto malformedInFrame;
+	    }
+	    if (oPtr != NULL && Tcl_ObjSetVar2(interp, nameObj, NULL,
+		    valueObj, TCL_NAMESPACE_ONLY|TCL_LEAVE_ERR_MSG) == NULL) {
+		Tcl_DecrRefCount(nameObj);
+		Tcl_DecrRefCount(valueObj);
+		goto errorInFrame;
+	    }
+	    Tcl_DecrRefCount(valueObj);
+	    break;
+	case SERIAL_ARRAY:
+	    if (!TclOOSerialGetCount(rPtr, &numElems)) {
+		Tcl_DecrRefCount(nameObj);
+		goto malformedInFrame;
+	    }
+	    if (oPtr != NULL && numElems == 0) {
+		/*
+		 * There's no public way to make an empty array directly.
+		 */
+
+		valueObj = Tcl_NewObj();
+		Tcl_IncrRefCount(valueObj);
+		if (Tcl_ObjSetVar2(interp, nameObj, valueObj, valueObj,
+			TCL_NAMESPACE_ONLY|TCL_LEAVE_ERR_MSG) == NULL) {
+		    Tcl_DecrRefCount(nameObj);
+		    Tcl_DecrRefCount(valueObj);
+		    goto errorInFrame;
+		}
+		Tcl_UnsetVar2(interp, TclGetString(nameObj), "",
+			TCL_NAMESPACE_ONLY);
+		Tcl_DecrRefCount(valueObj);
+	    }
+	    for (j=0 ; j<numElems ; j++) {
+		if ((keyObj = TclOOSerialGetString(rPtr)) == NULL) {
+		    Tcl_DecrRefCount(nameObj);
+		    goto malformedInFrame;
+		}
+		if ((valueObj = TclOOSerialGetString(rPtr)) == NULL) {
+		    Tcl_DecrRefCount(nameObj);
+		    Tcl_DecrRefCount(keyObj);
+		    goto malformedInFrame;
+		}
+		if (oPtr != NULL && Tcl_ObjSetVar2(interp, nameObj, keyObj,
+			valueObj, TCL_NAMESPACE_ONLY|TCL_LEAVE_ERR_MSG)
+			== NULL) {
+		    Tcl_DecrRefCount(nameObj);
+		    Tcl_DecrRefCount(keyObj);
+		    Tcl_DecrRefCount(valueObj);
+		    goto errorInFrame;
+		}
+		Tcl_DecrRefCount(keyObj);
+		Tcl_DecrRefCount(valueObj);
+	    }
+	    break;
+	default:
+	    Tcl_DecrRefCount(nameObj);
+	    goto malformedInFrame;
+	}
+	Tcl_DecrRefCount(nameObj);
+    }
+    if (rPtr->pos != rPtr->length) {
+	goto malformedInFrame;
+    }
+    result = TCL_OK;
+    goto errorInFrame;
+
+  freeObjs:
+    for (j=0 ; j<i ; j++) {
+	Tcl_DecrRefCount(objs[j]);
+    }
+    ckfree((char *) objs);
+  malformed:
+    Tcl_AppendResult(interp, "malformed serialized object", NULL);
+    return TCL_ERROR;
+
+  malformedInFrame:
+    Tcl_AppendResult(interp, "malformed serialized object", NULL);
+  errorInFrame:
+    if (oPtr != NULL) {
+	Tcl_PopCallFrame(interp);
+    }
+    return result;
+}
+
+int
+TclOODeserializeObjCmd(
+    ClientData clientData,
+    Tcl_Interp *interp,
+    int objc,
+    Tcl_Obj *const *objv)
+{
+    static const char *options[] = {
+	"-channel", NULL
+    };
+    Class *clsPtr;
+    Tcl_Object object;
+    Tcl_Channel chan;
+    SerialReader reader;
+    unsigned char header[SERIAL_HEADER_SIZE];
+    unsigned char *buffer = NULL;
+    unsigned int length;
+    int first = 1, useChannel = 0, mode, idx, result = TCL_ERROR;
+
+    if (objc > 1 && TclGetString(objv[1])[0] == '-') {
+	if (Tcl_GetIndexFromObj(interp, objv[1], options, "option", 0,
+		&idx) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	useChannel = 1;
+	first = 2;
+    }
+    if (objc < first+2 || objc > first+3) {
+	Tcl_WrongNumArgs(interp, 1, objv,
+		"?-channel? className source ?objectName?");
+	return TCL_ERROR;
+    }
+    clsPtr = TclOOGetClassFromObj(interp, objv[first]);
+    if (clsPtr == NULL) {
+	return TCL_ERROR;
+    }
+
+    /*
+     * Get hold of the payload, reading it from the channel if necessary.
+     */
+
+    if (useChannel) {
+	chan = Tcl_GetChannel(interp, TclGetString(objv[first+1]), &mode);
+	if (chan == NULL) {
+	    return TCL_ERROR;
+	}
+	if (!(mode & TCL_READABLE)) {
+	    Tcl_AppendResult(interp, "channel \"", TclGetString(objv[first+1]),
+		    "\" wasn't opened for reading", NULL);
+	    return TCL_ERROR;
+	}
+	idx = Tcl_Read(chan, (char *) header, SERIAL_HEADER_SIZE);
+	if (idx < 0) {
+	    goto readError;
+	} else if (idx < SERIAL_HEADER_SIZE) {
+	    goto truncated;
+	}
+	if (CheckSerialHeader(interp, header, &length) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+
+	/*
+	 * The length comes from the stream, so it cannot be trusted. Don't
+	 * let a silly one wrap around or make Tcl panic; if it is more than
+	 * the stream holds, the read finds that out.
+	 */
+
+	if (length >= (unsigned) INT_MAX) {
+	    goto truncated;
+	}
+	buffer = (unsigned char *) attemptckalloc(length + 1);
+	if (buffer == NULL) {
+	    goto truncated;
+	}
+	idx = Tcl_Read(chan, (char *) buffer, (int) length);
+	if (idx < 0) {
+	    goto readError;
+	} else if (idx < (int) length) {
+	    goto truncated;
+	}
+	reader.bytes = buffer;
+    } else {
+	int numBytes;
+	const unsigned char *bytes =
+		Tcl_GetByteArrayFromObj(objv[first+1], &numBytes);
+
+	if (numBytes < SERIAL_HEADER_SIZE) {
+	    goto truncated;
+	}
+	if (CheckSerialHeader(interp, bytes, &length) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	if (length != (unsigned) (numBytes - SERIAL_HEADER_SIZE)) {
+	    goto truncated;
+	}
+	reader.bytes = bytes + SERIAL_HEADER_SIZE;
+    }
+    reader.length = (int) length;
+
+    /*
+     * Check the whole payload before making the object, so that a bad one
+     * does not leave a half-made object behind.
+     */
+
+    reader.pos = 0;
+    if (RestoreObjectState(interp, NULL, &reader) != TCL_OK) {
+	goto done;
+    }
+
+    /*
+     * Make the object without running its constructor. As with [oo::copy],
+     * a relative name is resolved with respect to the current namespace.
+     */
+
+    if (objc == first+2) {
+	object = Tcl_NewObjectInstance(interp, (Tcl_Class) clsPtr, NULL,
+		NULL, -1, NULL, 0);
+    } else {
+	const char *name = TclGetString(objv[first+2]);
+	Tcl_DString nameBuf;
+
+	Tcl_DStringInit(&nameBuf);
+	if (name[0]!=':' || name[1]!=':') {
+	    Interp *iPtr = (Interp *) interp;
+
+	    if (iPtr->varFramePtr != NULL) {
+		Tcl_DStringAppend(&nameBuf,
+			iPtr->varFramePtr->nsPtr->fullName, -1);
+	    }
+	    Tcl_DStringAppend(&nameBuf, "::", 2);
+	    Tcl_DStringAppend(&nameBuf, name, -1);
+	    name = Tcl_DStringValue(&nameBuf);
+	}
+	object = Tcl_NewObjectInstance(interp, (Tcl_Class) clsPtr, name,
+		NULL, -1, NULL, 0);
+	Tcl_DStringFree(&nameBuf);
+    }
+    if (object == NULL) {
+	goto done;
+    }
+
+    reader.pos = 0;
+    if (RestoreObjectState(interp, (Object *) object, &reader) != TCL_OK) {
+	Tcl_DeleteCommandFromToken(interp, ((Object *) object)->command);
+	goto done;
+    }
+    Tcl_SetObjResult(interp, TclOOObjectName(interp, (Object *) object));
+    result = TCL_OK;
+    goto done;
+
+  readError:
+    Tcl_AppendResult(interp, "error reading \"", TclGetString(objv[first+1]),
+	    "\": ", Tcl_PosixError(interp), NULL);
+    goto done;
+  truncated:
+    Tcl_AppendResult(interp, "truncated serialized object", NULL);
+  done:
+    if (buffer != NULL) {
+	ckfree((char *) buffer);
+    }
+    return result;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOForeachInstanceObjCmd --
+ *
+ *	Implementation of the [oo::foreachInstance] command, which runs a
+ *	script for each instance of a class without first making a list of
+ *	the names of all of them.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+typedef struct {
+    Tcl_Interp *interp;		/* Where to run the body. */
+    Tcl_Obj *varNameObj;	/* The variable to hold each object's name. */
+    Tcl_Obj *bodyObj;		/* The script to run for each object. */
+} ForeachInstanceState;
+
+static int
+ForeachInstanceStep(
+    ClientData clientData,
+    Tcl_Object object)
+{
+    ForeachInstanceState *statePtr = clientData;
+    Tcl_Interp *interp = statePtr->interp;
+    int result;
+
+    if (Tcl_ObjSetVar2(interp, statePtr->varNameObj, NULL,
+	    TclOOObjectName(interp, (Object *) object),
+	    TCL_LEAVE_ERR_MSG) == NULL) {
+	return TCL_ERROR;
+    }
+    result = Tcl_EvalObjEx(interp, statePtr->bodyObj, 0);
+    if (result == TCL_ERROR) {
+	Tcl_AppendObjToErrorInfo(interp, Tcl_ObjPrintf(
+		"\n    (\"oo::foreachInstance\" body line %d)",
+		interp->errorLine));
+    }
+    return result;
+}
+
+int
+TclOOForeachInstanceObjCmd(
+    ClientData clientData,
+    Tcl_Interp *interp,
+    int objc,
+    Tcl_Obj *const *objv)
+{
+    static const char *options[] = {
+	"-subclasses", NULL
+    };
+    ForeachInstanceState state;
+    Class *clsPtr;
+    int idx, flags = 0, result;
+
+    if (objc == 5) {
+	if (Tcl_GetIndexFromObj(interp, objv[3], options, "option", 0,
+		&idx) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	flags |= TCL_OO_SUBCLASS_INSTANCES;
+    } else if (objc != 4) {
+	Tcl_WrongNumArgs(interp, 1, objv,
+		"varName className ?-subclasses? body");
+	return TCL_ERROR;
+    }
+    clsPtr = TclOOGetClassFromObj(interp, objv[2]);
+    if (clsPtr == NULL) {
+	return TCL_ERROR;
+    }
+
+    state.interp = interp;
+    state.varNameObj = objv[1];
+    state.bodyObj = objv[objc-1];
+    result = Tcl_ClassForeachInstance((Tcl_Class) clsPtr, flags,
+	    ForeachInstanceStep, &state);
+    if (result == TCL_OK) {
+	Tcl_ResetResult(interp);
+    }
+    return result;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOBroadcastObjCmd --
+ *
+ *	Implementation of the [oo::broadcast] command, which invokes the same
+ *	method with the same arguments on each of a list of objects.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+TclOOBroadcastObjCmd(
+    ClientData clientData,
+    Tcl_Interp *interp,
+    int objc,
+    Tcl_Obj *const *objv)
+{
+    static const char *options[] = {
+	"-grouped", "-onerror", NULL
+    };
+    static const char *policies[] = {
+	"stop", "collect", "ignore", NULL
+    };
+    enum Options { OPT_GROUPED, OPT_ONERROR };
+    enum Policies { POLICY_STOP, POLICY_COLLECT, POLICY_IGNORE };
+    Tcl_Object *objects;
+    Tcl_Obj **names, *errorsObj = NULL;
+    int i, idx, policy, flags = 0, numNames, numObjects = 0, result;
+
+    for (i=1 ; i<objc-2 && TclGetString(objv[i])[0] == '-' ; i++) {
+	if (Tcl_GetIndexFromObj(interp, objv[i], options, "option", 0,
+		&idx) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	switch ((enum Options) idx) {
+	case OPT_GROUPED:
+	    flags |= INVOKE_GROUP_BY_CLASS;
+	    break;
+	case OPT_ONERROR:
+	    if (i+1 >= objc-2) {
+		goto wrongArgs;
+	    }
+	    if (Tcl_GetIndexFromObj(interp, objv[++i], policies, "policy", 0,
+		    &policy) != TCL_OK) {
+		return TCL_ERROR;
+	    }
+	    flags &= ~(INVOKE_COLLECT_ERRORS|INVOKE_IGNORE_ERRORS);
+	    if (policy == POLICY_COLLECT) {
+		flags |= INVOKE_COLLECT_ERRORS;
+	    } else if (policy == POLICY_IGNORE) {
+		flags |= INVOKE_IGNORE_ERRORS;
+	    }
+	    break;
+	}
+    }
+    if (i > objc-2) {
+    wrongArgs:
+	Tcl_WrongNumArgs(interp, 1, objv,
+		"?-onerror policy? ?-grouped? objectList method ?arg ...?");
+	return TCL_ERROR;
+    }
+    if (Tcl_ListObjGetElements(interp, objv[i], &numNames,
+	    &names) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    if (flags & INVOKE_COLLECT_ERRORS) {
+	errorsObj = Tcl_NewObj();
+	Tcl_IncrRefCount(errorsObj);
+    }
+
+    /*
+     * Look up all the objects before calling any of them. A name that is
+     * not an object counts as a failed call.
+     */
+
+    objects = (Tcl_Object *) ckalloc(sizeof(Tcl_Object) * (numNames + 1));
+    for (idx=0 ; idx<numNames ; idx++) {
+	objects[numObjects] = Tcl_GetObjectFromObj(interp, names[idx]);
+	if (objects[numObjects] != NULL) {
+	    numObjects++;
+	} else if (errorsObj != NULL) {
+	    Tcl_ListObjAppendElement(NULL, errorsObj, names[idx]);
+	    Tcl_ListObjAppendElement(NULL, errorsObj,
+		    Tcl_GetObjResult(interp));
+	} else if (!(flags & INVOKE_IGNORE_ERRORS)) {
+	    ckfree((char *) objects);
+	    return TCL_ERROR;
+	}
+    }
+
+    /*
+     * The first argument is just a placeholder for the object name.
+     */
+
+    result = TclOOInvokeMany(interp, numObjects,
+	    (Tcl_Object *const *) objects, flags, objc-i, objv+i, errorsObj);
+    ckfree((char *) objects);
+    if (errorsObj != NULL) {
+	if (result == TCL_OK) {
+	    Tcl_SetObjResult(interp, errorsObj);
+	}
+	Tcl_DecrRefCount(errorsObj);
+    }
+    return result;
+}
+
 /*
  * Local Variables:
  * mode: c
@@ -28,8 +28,30 @@ struct ChainBuilder {
 				 * main call chain. */
     Object *oPtr;		/* The object that we are building the chain
 				 * for. */
+    Tcl_Obj *methodNameObj;	/* The name of the method that the chain is
+				 * being built for, used when applying filter
+				 * guards. */
 };
 
+/*
+ * Structure recording the result of applying a pure method name mapper (see
+ * Tcl_ObjectSetPureMethodNameMapper) to a method name, so that the mapping
+ * need not be repeated while the class structure stays the same.
+ */
+
+typedef struct MappedName {
+    Tcl_Obj *mappedNameObj;	/* The name that the method name maps to. The
+				 * call chain gets cached in this. */
+    Object *startObjPtr;	/* The object of the class to start the call
+				 * chain from, or NULL for the whole chain. A
+				 * reference is held to this. */
+    Tcl_ObjectMapMethodNameProc *mapProc;
+				/* The mapper that produced this mapping. */
+    int objectCreationEpoch;	/* The object that the mapping was done for. */
+    int epoch;			/* Global epoch when the mapping was done. */
+    int objectEpoch;		/* Object epoch when the mapping was done. */
+} MappedName;
+
 /*
  * Extra flags used for call chain management.
  */
@@ -63,11 +85,23 @@ static void		AddSimpleClassChainToCallContext(Class *classPtr,
 			    Tcl_HashTable *const doneFilters, int flags,
 			    Class *const filterDecl);
 static int		CmpStr(const void *ptr1, const void *ptr2);
+static void		DupMappedNameRep(Tcl_Obj *srcPtr, Tcl_Obj *dstPtr);
 static void		DupMethodNameRep(Tcl_Obj *srcPtr, Tcl_Obj *dstPtr);
+static int		FilterGuardPermits(Tcl_HashTable *guardsPtr,
+			    Tcl_Obj *filterObj,
+			    struct ChainBuilder *const cbPtr);
+static void		FreeMappedNameRep(Tcl_Obj *objPtr);
 static void		FreeMethodNameRep(Tcl_Obj *objPtr);
 static inline int	IsStillValid(CallChain *callPtr, Object *oPtr,
 			    int flags, int reuseMask);
+static void		RewarmChains(ClientData clientData);
+static void		RewarmClassChains(Class *clsPtr,
+			    Tcl_HashTable *doneTablePtr);
+static inline int	MayStash(Foundation *fPtr, Tcl_Obj *objPtr,
+			    const Tcl_ObjType *typePtr);
 static inline void	StashCallChain(Tcl_Obj *objPtr, CallChain *callPtr);
+static inline void	StashWithPolicy(Foundation *fPtr, Tcl_Obj *objPtr,
+			    CallChain *callPtr);
 
 /*
  * Object type used to manage type caches attached to method names.
@@ -80,6 +114,18 @@ static Tcl_ObjType methodNameType = {
     NULL,
     NULL
 };
+
+/*
+ * Object type used to remember how a pure method name mapper mapped a name.
+ */
+
+static Tcl_ObjType mappedNameType = {
+    "TclOO mapped method name",
+    FreeMappedNameRep,
+    DupMappedNameRep,
+    NULL,
+    NULL
+};
 
 /*
  * ----------------------------------------------------------------------
@@ -150,9 +196,75 @@ TclOODeleteChain(
     if (callPtr->chain != callPtr->staticChain) {
 	ckfree((char *) callPtr->chain);
     }
+    if (callPtr->classIndex != NULL) {
+	Tcl_DeleteHashTable(callPtr->classIndex);
+	ckfree((char *) callPtr->classIndex);
+    }
     ckfree((char *) callPtr);
 }
 
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOGetChainIndex --
+ *
+ *	Finds where in a call chain the (non-filter) implementation of the
+ *	method provided by a particular class is. Used by [nextto] and for
+ *	invoking from a given start class. Short chains are just searched;
+ *	longer ones get an index built the first time it is wanted, which
+ *	lives as long as the chain does.
+ *
+ * Results:
+ *	The index into the chain, or -1 if the class does not provide a
+ *	non-filter implementation in the chain.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+TclOOGetChainIndex(
+    CallChain *callPtr,
+    Class *clsPtr)
+{
+    Tcl_HashEntry *hPtr;
+    int i, isNew;
+
+    if (callPtr->numChain <= CALL_CHAIN_STATIC_SIZE) {
+	for (i=0 ; i<callPtr->numChain ; i++) {
+	    struct MInvoke *miPtr = callPtr->chain + i;
+
+	    if (!miPtr->isFilter && miPtr->mPtr->declaringClassPtr==clsPtr) {
+		return i;
+	    }
+	}
+	return -1;
+    }
+
+    if (callPtr->classIndex == NULL) {
+	callPtr->classIndex = (Tcl_HashTable *)
+		ckalloc(sizeof(Tcl_HashTable));
+	Tcl_InitHashTable(callPtr->classIndex, TCL_ONE_WORD_KEYS);
+	for (i=0 ; i<callPtr->numChain ; i++) {
+	    struct MInvoke *miPtr = callPtr->chain + i;
+
+	    if (miPtr->isFilter || miPtr->mPtr->declaringClassPtr == NULL) {
+		continue;
+	    }
+	    hPtr = Tcl_CreateHashEntry(callPtr->classIndex,
+		    (char *) miPtr->mPtr->declaringClassPtr, &isNew);
+	    if (isNew) {
+		Tcl_SetHashValue(hPtr, INT2PTR(i));
+	    }
+	}
+    }
+
+    hPtr = Tcl_FindHashEntry(callPtr->classIndex, (char *) clsPtr);
+    if (hPtr == NULL) {
+	return -1;
+    }
+    return PTR2INT(Tcl_GetHashValue(hPtr));
+}
+
 /*
  * ----------------------------------------------------------------------
  *
@@ -185,6 +297,52 @@ TclOOStashContext(
     StashCallChain(objPtr, contextPtr->callPtr);
 }
 
+/*
+ * ----------------------------------------------------------------------
+ *
+ * MayStash, StashWithPolicy --
+ *
+ *	Decide whether to steal the internal representation of a method name
+ *	to cache something of the given type in it, keeping count of what was
+ *	decided. Replacing a representation of that same type (or none at
+ *	all) is always allowed; replacing some other one causes thrashing
+ *	with the other use of the same value (e.g., as a list element or
+ *	command name), so is only done if we have not been told to avoid it.
+ *	The caller's tables still hold what is cached, so the only cost of
+ *	not stashing it is a hash lookup.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static inline int
+MayStash(
+    Foundation *fPtr,
+    Tcl_Obj *objPtr,		/* The method name. */
+    const Tcl_ObjType *typePtr)	/* The type to be stashed in it. */
+{
+    if (objPtr->typePtr == NULL || objPtr->typePtr == typePtr) {
+	fPtr->cacheStats.stashes++;
+	return 1;
+    } else if (fPtr->cacheFlags & CACHE_NO_SHIMMER) {
+	fPtr->cacheStats.avoided++;
+	return 0;
+    }
+    fPtr->cacheStats.stashes++;
+    fPtr->cacheStats.shimmers++;
+    return 1;
+}
+
+static inline void
+StashWithPolicy(
+    Foundation *fPtr,
+    Tcl_Obj *objPtr,
+    CallChain *callPtr)
+{
+    if (MayStash(fPtr, objPtr, &methodNameType)) {
+	StashCallChain(objPtr, callPtr);
+    }
+}
+
 /*
  * ----------------------------------------------------------------------
  *
@@ -219,6 +377,114 @@ FreeMethodNameRep(
     objPtr->typePtr = NULL;
 }
 
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOGetMappedMethodName, TclOOStashMappedMethodName --
+ *
+ *	Look up and save the result of mapping a method name with a pure
+ *	method name mapper. The result is held in the internal representation
+ *	of the method name as given by the caller, and is valid for as long
+ *	as the object, its mapper and the class structure are unchanged. The
+ *	mapped name keeps the call chain cached in its own internal
+ *	representation in turn, so a mapped call needs neither the mapper nor
+ *	a fresh chain.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+TclOOGetMappedMethodName(
+    Object *oPtr,		/* The object being invoked. */
+    Tcl_Obj *methodNameObj,	/* The method name as given by the caller. */
+    Tcl_Obj **mappedNamePtr,	/* Where to write the mapped name. */
+    Class **startClsPtr)	/* Where to write the start class. */
+{
+    MappedName *mnPtr;
+
+    if (methodNameObj->typePtr != &mappedNameType) {
+	return 0;
+    }
+    mnPtr = methodNameObj->internalRep.otherValuePtr;
+    TclOOSyncEpoch(oPtr->fPtr);
+    if (mnPtr->objectCreationEpoch != oPtr->creationEpoch
+	    || mnPtr->epoch != oPtr->fPtr->epoch
+	    || mnPtr->objectEpoch != oPtr->epoch
+	    || mnPtr->mapProc != oPtr->mapMethodNameProc
+	    || (mnPtr->startObjPtr != NULL
+		    && mnPtr->startObjPtr->command == NULL)) {
+	return 0;
+    }
+    *mappedNamePtr = mnPtr->mappedNameObj;
+    *startClsPtr = (mnPtr->startObjPtr ? mnPtr->startObjPtr->classPtr : NULL);
+    return 1;
+}
+
+void
+TclOOStashMappedMethodName(
+    Object *oPtr,		/* The object being invoked. */
+    Tcl_Obj *methodNameObj,	/* The method name as given by the caller. */
+    Tcl_Obj *mappedNameObj,	/* The name it was mapped to. */
+    Class *startCls)		/* The start class it was mapped to. */
+{
+    Foundation *fPtr = oPtr->fPtr;
+    MappedName *mnPtr;
+
+    if (!MayStash(fPtr, methodNameObj, &mappedNameType)) {
+	return;
+    }
+
+    mnPtr = (MappedName *) ckalloc(sizeof(MappedName));
+    mnPtr->mappedNameObj = mappedNameObj;
+    Tcl_IncrRefCount(mappedNameObj);
+    mnPtr->startObjPtr = (startCls ? startCls->thisPtr : NULL);
+    if (mnPtr->startObjPtr != NULL) {
+	AddRef(mnPtr->startObjPtr);
+    }
+    mnPtr->mapProc = oPtr->mapMethodNameProc;
+    mnPtr->objectCreationEpoch = oPtr->creationEpoch;
+    mnPtr->epoch = fPtr->epoch;
+    mnPtr->objectEpoch = oPtr->epoch;
+
+    if (methodNameObj->typePtr && methodNameObj->typePtr->freeIntRepProc) {
+	methodNameObj->typePtr->freeIntRepProc(methodNameObj);
+    }
+    methodNameObj->typePtr = &mappedNameType;
+    methodNameObj->internalRep.otherValuePtr = mnPtr;
+}
+
+static void
+DupMappedNameRep(
+    Tcl_Obj *srcPtr,
+    Tcl_Obj *dstPtr)
+{
+    MappedName *srcMnPtr = srcPtr->internalRep.otherValuePtr;
+    MappedName *mnPtr = (MappedName *) ckalloc(sizeof(MappedName));
+
+    *mnPtr = *srcMnPtr;
+    Tcl_IncrRefCount(mnPtr->mappedNameObj);
+    if (mnPtr->startObjPtr != NULL) {
+	AddRef(mnPtr->startObjPtr);
+    }
+    dstPtr->typePtr = &mappedNameType;
+    dstPtr->internalRep.otherValuePtr = mnPtr;
+}
+
+static void
+FreeMappedNameRep(
+    Tcl_Obj *objPtr)
+{
+    MappedName *mnPtr = objPtr->internalRep.otherValuePtr;
+
+    Tcl_DecrRefCount(mnPtr->mappedNameObj);
+    if (mnPtr->startObjPtr != NULL) {
+	DelRef(mnPtr->startObjPtr);
+    }
+    ckfree((char *) mnPtr);
+    objPtr->internalRep.otherValuePtr = NULL;
+    objPtr->typePtr = NULL;
+}
+
 /*
  * ----------------------------------------------------------------------
  *
@@ -310,6 +576,57 @@ TclOOInvokeContext(
     return result;
 }
 
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOInvokeTrivialChain --
+ *
+ *	Invokes a call chain marked with TRIVIAL_CHAIN. This is what
+ *	TclOOGetCallContext followed by TclOOInvokeContext would do, but
+ *	without the filter state juggling (the caller must ensure that the
+ *	object is not processing a filter) and with the call context placed
+ *	on the C stack, since there is only the one step to make. The context
+ *	is still a real one, so [next], [self call] and so on work in the
+ *	method as normal.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+TclOOInvokeTrivialChain(
+    Tcl_Interp *interp,		/* Interpreter for error reporting, etc. */
+    Object *oPtr,		/* The object being invoked. */
+    CallChain *callPtr,		/* The chain to invoke; must be trivial. */
+    int objc,			/* The number of arguments. */
+    Tcl_Obj *const *objv)	/* The arguments as actually seen. */
+{
+    Method *mPtr = callPtr->chain[0].mPtr;
+    CallContext context;
+    int result;
+
+    context.oPtr = oPtr;
+    context.callPtr = callPtr;
+    context.index = 0;
+    context.skip = 2;
+
+    /*
+     * Preserve everything against deletion during the call, just as using a
+     * heap-allocated context would.
+     */
+
+    AddRef(oPtr);
+    callPtr->refCount++;
+    AddRef(mPtr);
+
+    result = mPtr->typePtr->callProc(mPtr->clientData, interp,
+	    (Tcl_ObjectContext) &context, objc, objv);
+
+    TclOODelMethodRef(mPtr);
+    TclOODeleteChain(callPtr);
+    DelRef(oPtr);
+    return result;
+}
+
 /*
  * ----------------------------------------------------------------------
  *
@@ -801,16 +1118,21 @@ InitCallChain(
 {
     callPtr->flags = flags &
 	    (PUBLIC_METHOD | PRIVATE_METHOD | SPECIAL | FILTER_HANDLING);
+    callPtr->epoch = oPtr->fPtr->epoch;
     if (oPtr->flags & USE_CLASS_CACHE) {
 	oPtr = oPtr->selfCls->thisPtr;
 	callPtr->flags |= USE_CLASS_CACHE;
+	if ((oPtr->classPtr->flags & FROZEN_CLASS) && !(flags & SPECIAL)) {
+	    callPtr->flags |= PERMANENT_CHAIN;
+	    callPtr->epoch = oPtr->fPtr->frozenEpoch;
+	}
     }
-    callPtr->epoch = oPtr->fPtr->epoch;
     callPtr->objectCreationEpoch = oPtr->creationEpoch;
     callPtr->objectEpoch = oPtr->epoch;
     callPtr->refCount = 1;
     callPtr->numChain = 0;
     callPtr->chain = callPtr->staticChain;
+    callPtr->classIndex = NULL;
 }
 
 /*
@@ -821,10 +1143,15 @@ InitCallChain(
  *	method for the given object. The condition on a chain from a cached
  *	location being reusable is:
  *	- Refers to the same object (same creation epoch), and
- *	- Still across the same class structure (same global epoch), and
+ *	- Still across the same class structure (same global epoch, or same
+ *	  frozen epoch for a chain of the pure instances of a frozen class),
+ *	  and
  *	- Still across the same object strucutre (same local epoch), and
  *	- No public/private/filter magic leakage (same flags, modulo the fact
- *	  that a public chain will satisfy a non-public call).
+ *	  that a public chain will satisfy a non-public call, except when the
+ *	  chain is to the unknown method handler, as a non-public call may
+ *	  well find a method where a public one does not, or when a filter
+ *	  guard looked at whether the call was public).
  *
  * ----------------------------------------------------------------------
  */
@@ -840,12 +1167,76 @@ IsStillValid(
 	oPtr = oPtr->selfCls->thisPtr;
 	flags |= USE_CLASS_CACHE;
     }
+    if (callPtr->flags & (OO_UNKNOWN_METHOD | FILTER_GUARDED)) {
+	flags |= callPtr->flags & (OO_UNKNOWN_METHOD | FILTER_GUARDED);
+	mask = ~0;
+    }
+    mask &= ~(TRIVIAL_CHAIN | PERMANENT_CHAIN);
     return ((callPtr->objectCreationEpoch == oPtr->creationEpoch)
-	    && (callPtr->epoch == oPtr->fPtr->epoch)
+	    && (callPtr->epoch == ((callPtr->flags & PERMANENT_CHAIN)
+		    ? oPtr->fPtr->frozenEpoch : oPtr->fPtr->epoch))
 	    && (callPtr->objectEpoch == oPtr->epoch)
 	    && ((callPtr->flags & mask) == (flags & mask)));
 }
 
+/*
+ * ----------------------------------------------------------------------
+ *
+ * MarkIfTrivial --
+ *	Record whether a freshly built method call chain is simple enough to
+ *	be invoked without the machinery of a full call context; see
+ *	TclOOInvokeTrivialChain.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static inline void
+MarkIfTrivial(
+    CallChain *callPtr)
+{
+    if (callPtr->numChain == 1 && !callPtr->chain[0].isFilter
+	    && !(callPtr->flags & (OO_UNKNOWN_METHOD | FILTER_HANDLING))) {
+	callPtr->flags |= TRIVIAL_CHAIN;
+    }
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOGetCachedCallChain --
+ *
+ *	Get the call chain for a method from the place where it is most
+ *	cheaply cached, the internal representation of the method name, if it
+ *	is there and still valid. This does not build chains or look in the
+ *	per-object or per-class tables; TclOOGetCallContext does that.
+ *
+ * Results:
+ *	The call chain, or NULL if there is none cached. No reference is
+ *	added to the chain.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+CallChain *
+TclOOGetCachedCallChain(
+    Object *oPtr,		/* The object to get the chain for. */
+    Tcl_Obj *methodNameObj,	/* The name of the method. */
+    int flags)			/* PUBLIC_METHOD or PRIVATE_METHOD (or 0). */
+{
+    CallChain *callPtr;
+
+    if (methodNameObj->typePtr != &methodNameType) {
+	return NULL;
+    }
+    TclOOSyncEpoch(oPtr->fPtr);
+    callPtr = methodNameObj->internalRep.otherValuePtr;
+    if (!IsStillValid(callPtr, oPtr, flags,
+	    ((flags & PUBLIC_METHOD) ? ~0 : ~PUBLIC_METHOD))) {
+	return NULL;
+    }
+    return callPtr;
+}
+
 /*
  * ----------------------------------------------------------------------
  *
@@ -876,6 +1267,7 @@ TclOOGetCallContext(
     Tcl_HashEntry *hPtr;
     Tcl_HashTable doneFilters;
 
+    TclOOSyncEpoch(oPtr->fPtr);
     if (flags&(SPECIAL|FILTER_HANDLING) || (oPtr->flags&FILTER_HANDLING)) {
 	hPtr = NULL;
 	doFilters = 0;
@@ -939,6 +1331,7 @@ TclOOGetCallContext(
 	if (hPtr != NULL && Tcl_GetHashValue(hPtr) != NULL) {
 	    callPtr = Tcl_GetHashValue(hPtr);
 	    if (IsStillValid(callPtr, oPtr, flags, reuseMask)) {
+		oPtr->fPtr->cacheStats.tableHits++;
 		callPtr->refCount++;
 		goto returnContext;
 	    }
@@ -955,6 +1348,7 @@ TclOOGetCallContext(
     cb.callChainPtr = callPtr;
     cb.filterLength = 0;
     cb.oPtr = oPtr;
+    cb.methodNameObj = methodNameObj;
 
     /*
      * If we're working with a forced use of unknown, do that now.
@@ -988,8 +1382,10 @@ TclOOGetCallContext(
 	    AddClassFiltersToCallContext(oPtr, mixinPtr, &cb, &doneFilters);
 	}
 	FOREACH(filterObj, oPtr->filters) {
-	    AddSimpleChainToCallContext(oPtr, filterObj, &cb, &doneFilters, 0,
-		    NULL);
+	    if (FilterGuardPermits(oPtr->filterGuards, filterObj, &cb)) {
+		AddSimpleChainToCallContext(oPtr, filterObj, &cb,
+			&doneFilters, 0, NULL);
+	    }
 	}
 	AddClassFiltersToCallContext(oPtr, oPtr->selfCls, &cb, &doneFilters);
 	Tcl_DeleteHashTable(&doneFilters);
@@ -1021,12 +1417,22 @@ TclOOGetCallContext(
 	AddSimpleChainToCallContext(oPtr, oPtr->fPtr->unknownMethodNameObj,
 		&cb, NULL, 0, NULL);
 	callPtr->flags |= OO_UNKNOWN_METHOD;
-	callPtr->epoch = -1;
 	if (count == callPtr->numChain) {
 	    TclOODeleteChain(callPtr);
 	    return NULL;
 	}
-    } else if (doFilters) {
+    }
+
+    MarkIfTrivial(callPtr);
+
+    /*
+     * Cache the chain, whether or not it goes to the unknown method handler;
+     * proxies and the like resolve everything through that handler, and
+     * adding a real method of the requested name advances an epoch so the
+     * cached chain will be rebuilt.
+     */
+
+    if (doFilters) {
 	if (hPtr == NULL) {
 	    if (oPtr->flags & USE_CLASS_CACHE) {
 		if (oPtr->selfCls->classChainCache == NULL) {
@@ -1050,7 +1456,8 @@ TclOOGetCallContext(
 	}
 	callPtr->refCount++;
 	Tcl_SetHashValue(hPtr, callPtr);
-	StashCallChain(methodNameObj, callPtr);
+
+	StashWithPolicy(oPtr->fPtr, methodNameObj, callPtr);
     } else if (flags & CONSTRUCTOR) {
 	if (oPtr->selfCls->constructorChainPtr) {
 	    TclOODeleteChain(oPtr->selfCls->constructorChainPtr);
@@ -1111,6 +1518,7 @@ TclOOGetStereotypeCallChain(
      * machinery to produce the stereotypical call chain.
      */
 
+    TclOOSyncEpoch(fPtr);
     memset(&obj, 0, sizeof(Object));
     obj.fPtr = fPtr;
     obj.selfCls = clsPtr;
@@ -1145,16 +1553,12 @@ TclOOGetStereotypeCallChain(
 
     callPtr = (CallChain *) ckalloc(sizeof(CallChain));
     memset(callPtr, 0, sizeof(CallChain));
-    callPtr->flags = flags & (PUBLIC_METHOD|PRIVATE_METHOD|FILTER_HANDLING);
-    callPtr->epoch = fPtr->epoch;
-    callPtr->objectCreationEpoch = fPtr->tsdPtr->nsCount;
-    callPtr->objectEpoch = clsPtr->thisPtr->epoch;
-    callPtr->refCount = 1;
-    callPtr->chain = callPtr->staticChain;
+    InitCallChain(callPtr, &obj, flags);
 
     cb.callChainPtr = callPtr;
     cb.filterLength = 0;
     cb.oPtr = &obj;
+    cb.methodNameObj = methodNameObj;
 
     /*
      * Add all defined filters (if any, and if we're going to be processing
@@ -1189,6 +1593,7 @@ TclOOGetStereotypeCallChain(
 	    return NULL;
 	}
     } else {
+	MarkIfTrivial(callPtr);
 	if (hPtr == NULL) {
 	    if (clsPtr->classChainCache == NULL) {
 		clsPtr->classChainCache = (Tcl_HashTable *)
@@ -1201,11 +1606,130 @@ TclOOGetStereotypeCallChain(
 	}
 	callPtr->refCount++;
 	Tcl_SetHashValue(hPtr, callPtr);
-	StashCallChain(methodNameObj, callPtr);
+	StashWithPolicy(fPtr, methodNameObj, callPtr);
     }
     return callPtr;
 }
 
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOWarmClassChains --
+ *
+ *	Build (and cache) the call chains that a stereotypical instance of a
+ *	class would use for each of the methods whose names match a pattern,
+ *	so that the first call of such a method does not have to build them.
+ *	Methods that are not exported get the chain used when calling them
+ *	via [my].
+ *
+ * ----------------------------------------------------------------------
+ */
+
+void
+TclOOWarmClassChains(
+    Class *clsPtr,		/* The class to build the chains for. */
+    const char *pattern)	/* Pattern that selects which methods to
+				 * build chains for, or NULL for all. */
+{
+    const char **names;
+    int i, numNames;
+    Tcl_Obj *nameObj;
+    CallChain *callPtr;
+
+    numNames = TclOOGetSortedClassMethodList(clsPtr, 0, &names);
+    for (i=0 ; i<numNames ; i++) {
+	if (pattern != NULL && !Tcl_StringMatch(names[i], pattern)) {
+	    continue;
+	}
+	nameObj = Tcl_NewStringObj(names[i], -1);
+	Tcl_IncrRefCount(nameObj);
+	callPtr = TclOOGetStereotypeCallChain(clsPtr, nameObj, PUBLIC_METHOD);
+	if (callPtr != NULL && (callPtr->flags & OO_UNKNOWN_METHOD)) {
+	    TclOODeleteChain(callPtr);
+	    callPtr = TclOOGetStereotypeCallChain(clsPtr, nameObj, 0);
+	}
+	if (callPtr != NULL) {
+	    TclOODeleteChain(callPtr);
+	}
+	Tcl_DecrRefCount(nameObj);
+    }
+    if (numNames > 0) {
+	ckfree((char *) names);
+    }
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOScheduleRewarm, TclOOCancelRewarm, RewarmChains --
+ *
+ *	When the global epoch advances, every cached call chain becomes
+ *	invalid. If asked to (with [oo::cache rewarm]), we rebuild the chains
+ *	of the classes that have been precompiled once the interpreter is
+ *	next idle, rather than leaving it to the next call of each method.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+void
+TclOOScheduleRewarm(
+    Foundation *fPtr)
+{
+    if (!(fPtr->cacheFlags & CACHE_REWARM_PENDING)) {
+	fPtr->cacheFlags |= CACHE_REWARM_PENDING;
+	Tcl_DoWhenIdle(RewarmChains, fPtr);
+    }
+}
+
+void
+TclOOCancelRewarm(
+    Foundation *fPtr)
+{
+    if (fPtr->cacheFlags & CACHE_REWARM_PENDING) {
+	fPtr->cacheFlags &= ~CACHE_REWARM_PENDING;
+	Tcl_CancelIdleCall(RewarmChains, fPtr);
+    }
+}
+
+static void
+RewarmChains(
+    ClientData clientData)	/* The foundation of the object system. */
+{
+    Foundation *fPtr = clientData;
+    Tcl_HashTable doneTable;
+
+    fPtr->cacheFlags &= ~CACHE_REWARM_PENDING;
+    if (!(fPtr->cacheFlags & CACHE_REWARM)
+	    || fPtr->objectCls->thisPtr->command == NULL) {
+	return;
+    }
+    fPtr->cacheStats.rewarms++;
+    Tcl_InitHashTable(&doneTable, TCL_ONE_WORD_KEYS);
+    RewarmClassChains(fPtr->objectCls, &doneTable);
+    Tcl_DeleteHashTable(&doneTable);
+}
+
+static void
+RewarmClassChains(
+    Class *clsPtr,
+    Tcl_HashTable *doneTablePtr)/* Classes already processed, to cope with
+				 * diamond inheritance. */
+{
+    Class *subPtr;
+    int i, isNew;
+
+    (void) Tcl_CreateHashEntry(doneTablePtr, (char *) clsPtr, &isNew);
+    if (!isNew) {
+	return;
+    }
+    if (clsPtr->warmPatternObj != NULL) {
+	TclOOWarmClassChains(clsPtr, TclGetString(clsPtr->warmPatternObj));
+    }
+    FOREACH(subPtr, clsPtr->subclasses) {
+	RewarmClassChains(subPtr, doneTablePtr);
+    }
+}
+
 /*
  * ----------------------------------------------------------------------
  *
@@ -1255,6 +1779,9 @@ AddClassFiltersToCallContext(
     FOREACH(filterObj, clsPtr->filters) {
 	int isNew;
 
+	if (!FilterGuardPermits(clsPtr->filterGuards, filterObj, cbPtr)) {
+	    continue;
+	}
 	(void) Tcl_CreateHashEntry(doneFilters, (char *) filterObj, &isNew);
 	if (isNew) {
 	    AddSimpleChainToCallContext(oPtr, filterObj, cbPtr, doneFilters,
@@ -1279,6 +1806,86 @@ AddClassFiltersToCallContext(
     }
 }
 
+/*
+ * ----------------------------------------------------------------------
+ *
+ * FilterGuardPermits --
+ *
+ *	Decide whether a filter is to be applied to the method whose call
+ *	chain is being built, according to any guard attached to the filter by
+ *	the class or object that declares it. Filters that are not permitted
+ *	are left out of the chain altogether, so they cost nothing at all when
+ *	the method is called.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+FilterGuardPermits(
+    Tcl_HashTable *guardsPtr,	/* Table of guards of the class or object
+				 * that declares the filter, or NULL if it has
+				 * none. */
+    Tcl_Obj *filterObj,		/* The name of the filter. */
+    struct ChainBuilder *const cbPtr)
+				/* Context being filled with call chain
+				 * entries. */
+{
+    Tcl_HashEntry *hPtr;
+    FilterGuard *guardPtr;
+    int isPublic;
+
+    if (guardsPtr == NULL || cbPtr->methodNameObj == NULL) {
+	return 1;
+    }
+    hPtr = Tcl_FindHashEntry(guardsPtr, (char *) filterObj);
+    if (hPtr == NULL) {
+	return 1;
+    }
+    guardPtr = Tcl_GetHashValue(hPtr);
+    isPublic = (cbPtr->callChainPtr->flags & PUBLIC_METHOD) != 0;
+
+    /*
+     * If the outcome depends on whether the call is public, the chain must
+     * not be reused for a call of the other kind.
+     */
+
+    if (guardPtr->calls != GUARD_ALL_CALLS || guardPtr->guardProc != NULL) {
+	cbPtr->callChainPtr->flags |= FILTER_GUARDED;
+    }
+    if (!(guardPtr->calls &
+	    (isPublic ? GUARD_PUBLIC_CALLS : GUARD_PRIVATE_CALLS))) {
+	return 0;
+    }
+
+    if (guardPtr->patternsObj != NULL) {
+	const char *methodName = TclGetString(cbPtr->methodNameObj);
+	Tcl_Obj **patterns;
+	int i, numPatterns, matched = 0;
+
+	/*
+	 * The list was checked when the guard was set, so this cannot fail.
+	 */
+
+	Tcl_ListObjGetElements(NULL, guardPtr->patternsObj, &numPatterns,
+		&patterns);
+	for (i=0 ; i<numPatterns ; i++) {
+	    if (Tcl_StringMatch(methodName, TclGetString(patterns[i]))) {
+		matched = 1;
+		break;
+	    }
+	}
+	if (!matched) {
+	    return 0;
+	}
+    }
+
+    if (guardPtr->guardProc != NULL) {
+	return guardPtr->guardProc(guardPtr->clientData, cbPtr->methodNameObj,
+		isPublic);
+    }
+    return 1;
+}
+
 /*
  * ----------------------------------------------------------------------
  *
@@ -191,6 +191,38 @@ EXTERN void		Tcl_ClassSetDestructor(Tcl_Interp *interp,
 EXTERN Tcl_Obj *	Tcl_GetObjectName(Tcl_Interp *interp,
 				Tcl_Object object);
 #endif
+#ifndef Tcl_ObjectSetPureMethodNameMapper_TCL_DECLARED
+#define Tcl_ObjectSetPureMethodNameMapper_TCL_DECLARED
+/* 29 */
+EXTERN void		Tcl_ObjectSetPureMethodNameMapper(Tcl_Object object,
+				Tcl_ObjectMapMethodNameProc *mapMethodNameProc);
+#endif
+#ifndef Tcl_ClassSetFilterGuard_TCL_DECLARED
+#define Tcl_ClassSetFilterGuard_TCL_DECLARED
+/* 30 */
+EXTERN void		Tcl_ClassSetFilterGuard(Tcl_Class clazz,
+				Tcl_Obj *filterNameObj,
+				Tcl_ObjectFilterGuardProc *guardProc,
+				ClientData clientData);
+#endif
+#ifndef Tcl_ClassForeachInstance_TCL_DECLARED
+#define Tcl_ClassForeachInstance_TCL_DECLARED
+/* 31 */
+EXTERN int		Tcl_ClassForeachInstance(Tcl_Class clazz, int flags,
+				Tcl_ObjectIteratorProc *iterProc,
+				ClientData clientData);
+#endif
+#ifndef Tcl_DeferObjectDeletion_TCL_DECLARED
+#define Tcl_DeferObjectDeletion_TCL_DECLARED
+/* 32 */
+EXTERN int		Tcl_DeferObjectDeletion(Tcl_Interp *interp,
+				Tcl_Object object);
+#endif
+#ifndef Tcl_DrainDeferredDeletions_TCL_DECLARED
+#define Tcl_DrainDeferredDeletions_TCL_DECLARED
+/* 33 */
+EXTERN int		Tcl_DrainDeferredDeletions(Tcl_Interp *interp);
+#endif
 
 typedef struct TclOOStubHooks {
     const struct TclOOIntStubs *tclOOIntStubs;
@@ -229,6 +261,11 @@ typedef struct TclOOStubs {
     void (*tcl_ClassSetConstructor) (Tcl_Interp *interp, Tcl_Class clazz, Tcl_Method method); /* 26 */
     void (*tcl_ClassSetDestructor) (Tcl_Interp *interp, Tcl_Class clazz, Tcl_Method method); /* 27 */
     Tcl_Obj * (*tcl_GetObjectName) (Tcl_Interp *interp, Tcl_Object object); /* 28 */
+    void (*tcl_ObjectSetPureMethodNameMapper) (Tcl_Object object, Tcl_ObjectMapMethodNameProc *mapMethodNameProc); /* 29 */
+    void (*tcl_ClassSetFilterGuard) (Tcl_Class clazz, Tcl_Obj *filterNameObj, Tcl_ObjectFilterGuardProc *guardProc, ClientData clientData); /* 30 */
+    int (*tcl_ClassForeachInstance) (Tcl_Class clazz, int flags, Tcl_ObjectIteratorProc *iterProc, ClientData clientData); /* 31 */
+    int (*tcl_DeferObjectDeletion) (Tcl_Interp *interp, Tcl_Object object); /* 32 */
+    int (*tcl_DrainDeferredDeletions) (Tcl_Interp *interp); /* 33 */
 } TclOOStubs;
 
 #if defined(USE_TCLOO_STUBS) && !defined(USE_TCLOO_STUB_PROCS)
@@ -357,6 +394,26 @@ extern const TclOOStubs *tclOOStubsPtr;
 #define Tcl_GetObjectName \
 	(tclOOStubsPtr->tcl_GetObjectName) /* 28 */
 #endif
+#ifndef Tcl_ObjectSetPureMethodNameMapper
+#define Tcl_ObjectSetPureMethodNameMapper \
+	(tclOOStubsPtr->tcl_ObjectSetPureMethodNameMapper) /* 29 */
+#endif
+#ifndef Tcl_ClassSetFilterGuard
+#define Tcl_ClassSetFilterGuard \
+	(tclOOStubsPtr->tcl_ClassSetFilterGuard) /* 30 */
+#endif
+#ifndef Tcl_ClassForeachInstance
+#define Tcl_ClassForeachInstance \
+	(tclOOStubsPtr->tcl_ClassForeachInstance) /* 31 */
+#endif
+#ifndef Tcl_DeferObjectDeletion
+#define Tcl_DeferObjectDeletion \
+	(tclOOStubsPtr->tcl_DeferObjectDeletion) /* 32 */
+#endif
+#ifndef Tcl_DrainDeferredDeletions
+#define Tcl_DrainDeferredDeletions \
+	(tclOOStubsPtr->tcl_DrainDeferredDeletions) /* 33 */
+#endif
 
 #endif /* defined(USE_TCLOO_STUBS) && !defined(USE_TCLOO_STUB_PROCS) */
 
@@ -31,22 +31,28 @@ struct DeclaredSlot {
     const char *name;
     const Tcl_MethodType getterType;
     const Tcl_MethodType setterType;
+    const char *defaultOpPrefix;	/* Forward prefix for the slot's
+					 * default operation, or NULL to use
+					 * that of oo::Slot (appending). */
 };
 
-#define SLOT(name,getter,setter)					\
+#define SLOT(name,getter,setter,defOp)					\
     {"::oo::" name,							\
 	    {TCL_OO_METHOD_VERSION_CURRENT, "core method: " name " Getter", \
 		    getter, NULL, NULL},				\
 	    {TCL_OO_METHOD_VERSION_CURRENT, "core method: " name " Setter", \
-		    setter, NULL, NULL}}
+		    setter, NULL, NULL}, defOp}
 
 /*
  * Forward declarations.
  */
 
 static inline void	BumpGlobalEpoch(Tcl_Interp *interp, Class *classPtr);
+static void		FreezeClass(Class *clsPtr);
 static Tcl_Command	FindCommand(Tcl_Interp *interp, Tcl_Obj *stringObj,
 			    Tcl_Namespace *const namespacePtr);
+static FilterGuard *	GetFilterGuard(Tcl_HashTable **guardsPtrPtr,
+			    Tcl_Obj *filterObj);
 static void		GenerateErrorInfo(Tcl_Interp *interp, Object *oPtr,
 			    Tcl_Obj *savedNameObj, const char *typeOfSubject);
 static inline Class *	GetClassInOuterContext(Tcl_Interp *interp,
@@ -55,9 +61,26 @@ static inline int	InitDefineContext(Tcl_Interp *interp,
 			    Tcl_Namespace *namespacePtr, Object *oPtr,
 			    int objc, Tcl_Obj *const objv[]);
 static inline void	RecomputeClassCacheFlag(Object *oPtr);
+static void		TidyFilterGuard(Tcl_HashTable **guardsPtrPtr,
+			    Tcl_Obj *filterObj);
 static int		RenameDeleteMethod(Tcl_Interp *interp, Object *oPtr,
 			    int useClass, Tcl_Obj *const fromPtr,
 			    Tcl_Obj *const toPtr);
+static int		InvokeSlotMethod(Tcl_Interp *interp,
+			    Tcl_ObjectContext context, Tcl_Obj *methodNameObj,
+			    int objc, Tcl_Obj *const *objv);
+static int		SlotAppend(ClientData clientData,
+			    Tcl_Interp *interp, Tcl_ObjectContext context,
+			    int objc, Tcl_Obj *const *objv);
+static int		SlotClear(ClientData clientData,
+			    Tcl_Interp *interp, Tcl_ObjectContext context,
+			    int objc, Tcl_Obj *const *objv);
+static int		SlotSet(ClientData clientData,
+			    Tcl_Interp *interp, Tcl_ObjectContext context,
+			    int objc, Tcl_Obj *const *objv);
+static int		SlotUnknown(ClientData clientData,
+			    Tcl_Interp *interp, Tcl_ObjectContext context,
+			    int objc, Tcl_Obj *const *objv);
 static int		ClassFilterGet(ClientData clientData,
 			    Tcl_Interp *interp, Tcl_ObjectContext context,
 			    int objc, Tcl_Obj *const *objv);
@@ -106,15 +129,43 @@ static int		ObjVarsSet(ClientData clientData,
  */
 
 static const struct DeclaredSlot slots[] = {
-    SLOT("define::filter",	ClassFilterGet, ClassFilterSet),
-    SLOT("define::mixin",	ClassMixinGet,  ClassMixinSet),
-    SLOT("define::superclass",  ClassSuperGet,  ClassSuperSet),
-    SLOT("define::variable",    ClassVarsGet,   ClassVarsSet),
-    SLOT("objdefine::filter",   ObjFilterGet,   ObjFilterSet),
-    SLOT("objdefine::mixin",    ObjMixinGet,    ObjMixinSet),
-    SLOT("objdefine::variable", ObjVarsGet,     ObjVarsSet),
+    SLOT("define::filter",	ClassFilterGet, ClassFilterSet, NULL),
+    SLOT("define::mixin",	ClassMixinGet,  ClassMixinSet,  "my -set"),
+    SLOT("define::superclass",  ClassSuperGet,  ClassSuperSet,  "my -set"),
+    SLOT("define::variable",    ClassVarsGet,   ClassVarsSet,   NULL),
+    SLOT("objdefine::filter",   ObjFilterGet,   ObjFilterSet,   NULL),
+    SLOT("objdefine::mixin",    ObjMixinGet,    ObjMixinSet,    "my -set"),
+    SLOT("objdefine::variable", ObjVarsGet,     ObjVarsSet,     NULL),
+    {NULL}
+};
+
+/*
+ * The standard operations supported by all slots.
+ */
+
+#define SLOTOP(name,visibility,proc) \
+    {name,visibility,\
+	{TCL_OO_METHOD_VERSION_CURRENT,"core method: slot "name,proc,\
+		NULL,NULL}}
+
+static const DeclaredClassMethod slotMethods[] = {
+    SLOTOP("-append", 1,	SlotAppend),
+    SLOTOP("-clear", 1,	SlotClear),
+    SLOTOP("-set", 1,		SlotSet),
+    SLOTOP("unknown", 0,	SlotUnknown),
     {NULL}
 };
+
+/*
+ * The parts of oo::Slot that are meant to be overridden by subclasses. These
+ * are what [oo::define oo::Slot] would make from:
+ *	method Get {} {error unimplemented}
+ *	method Set list {error unimplemented}
+ *	forward --default-operation my -append
+ */
+
+static const char *slotUnimplementedBody = "error unimplemented";
+static const char *slotDefaultOpPrefix = "my -append";
 
 /*
  * ----------------------------------------------------------------------
@@ -157,7 +208,8 @@ BumpGlobalEpoch(
      * in use. Force regeneration of call chains.
      */
 
-    TclOOGetFoundation(interp)->epoch++;
+    TclOOBumpEpoch(TclOOGetFoundation(interp));
+    TclOOBumpFrozenEpoch(TclOOGetFoundation(interp), classPtr);
 }
 
 /*
@@ -182,6 +234,61 @@ RecomputeClassCacheFlag(
     }
 }
 
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOCheckNotFrozen --
+ *	Produce an error if a class may not be changed because it has been
+ *	frozen. Also used by Tcl_NewMethod, which may be given no interpreter.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+TclOOCheckNotFrozen(
+    Tcl_Interp *interp,
+    Class *clsPtr)
+{
+    if (!(clsPtr->flags & FROZEN_CLASS)) {
+	return TCL_OK;
+    }
+    if (interp != NULL) {
+	Tcl_AppendResult(interp, "may not modify frozen class \"",
+		TclGetString(TclOOObjectName(interp, clsPtr->thisPtr)), "\"",
+		NULL);
+    }
+    return TCL_ERROR;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * FreezeClass --
+ *	Freeze a class and everything that it inherits from or mixes in,
+ *	other than the root classes, which are never frozen.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static void
+FreezeClass(
+    Class *clsPtr)
+{
+    Class *otherPtr;
+    int i;
+
+    if (clsPtr->flags & (FROZEN_CLASS | ROOT_OBJECT | ROOT_CLASS)) {
+	return;
+    }
+    clsPtr->flags |= FROZEN_CLASS;
+    FOREACH(otherPtr, clsPtr->superclasses) {
+	FreezeClass(otherPtr);
+    }
+    FOREACH(otherPtr, clsPtr->mixins) {
+	FreezeClass(otherPtr);
+    }
+}
+
 /*
  * ----------------------------------------------------------------------
  *
@@ -304,6 +411,124 @@ TclOOClassSetFilters(
     BumpGlobalEpoch(interp, classPtr);
 }
 
+/*
+ * ----------------------------------------------------------------------
+ *
+ * GetFilterGuard, TidyFilterGuard --
+ *	Get the guard on a filter, creating it (and the table of guards) if
+ *	necessary, and throw it away again once it no longer restricts where
+ *	the filter is applied.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static FilterGuard *
+GetFilterGuard(
+    Tcl_HashTable **guardsPtrPtr,
+    Tcl_Obj *filterObj)
+{
+    Tcl_HashEntry *hPtr;
+    FilterGuard *guardPtr;
+    int isNew;
+
+    if (*guardsPtrPtr == NULL) {
+	*guardsPtrPtr = (Tcl_HashTable *) ckalloc(sizeof(Tcl_HashTable));
+	Tcl_InitObjHashTable(*guardsPtrPtr);
+    }
+    hPtr = Tcl_CreateHashEntry(*guardsPtrPtr, (char *) filterObj, &isNew);
+    if (!isNew) {
+	return Tcl_GetHashValue(hPtr);
+    }
+    guardPtr = (FilterGuard *) ckalloc(sizeof(FilterGuard));
+    guardPtr->patternsObj = NULL;
+    guardPtr->calls = GUARD_ALL_CALLS;
+    guardPtr->guardProc = NULL;
+    guardPtr->clientData = NULL;
+    Tcl_SetHashValue(hPtr, guardPtr);
+    return guardPtr;
+}
+
+static void
+TidyFilterGuard(
+    Tcl_HashTable **guardsPtrPtr,
+    Tcl_Obj *filterObj)
+{
+    Tcl_HashEntry *hPtr;
+    FilterGuard *guardPtr;
+
+    hPtr = Tcl_FindHashEntry(*guardsPtrPtr, (char *) filterObj);
+    guardPtr = Tcl_GetHashValue(hPtr);
+    if (guardPtr->patternsObj != NULL || guardPtr->calls != GUARD_ALL_CALLS
+	    || guardPtr->guardProc != NULL) {
+	return;
+    }
+    ckfree((char *) guardPtr);
+    Tcl_DeleteHashEntry(hPtr);
+    if ((*guardsPtrPtr)->numEntries == 0) {
+	Tcl_DeleteHashTable(*guardsPtrPtr);
+	ckfree((char *) *guardsPtrPtr);
+	*guardsPtrPtr = NULL;
+    }
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOCopyFilterGuards, TclOODeleteFilterGuards --
+ *	Duplicate and dispose of a table of filter guards, as used when
+ *	copying and deleting classes and objects.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+Tcl_HashTable *
+TclOOCopyFilterGuards(
+    Tcl_HashTable *guardsPtr)
+{
+    Tcl_HashTable *copyPtr = NULL;
+    Tcl_HashSearch search;
+    Tcl_HashEntry *hPtr;
+    FilterGuard *guardPtr, *guard2Ptr;
+
+    if (guardsPtr == NULL) {
+	return NULL;
+    }
+    for (hPtr = Tcl_FirstHashEntry(guardsPtr, &search); hPtr != NULL;
+	    hPtr = Tcl_NextHashEntry(&search)) {
+	guardPtr = Tcl_GetHashValue(hPtr);
+	guard2Ptr = GetFilterGuard(&copyPtr,
+		(Tcl_Obj *) Tcl_GetHashKey(guardsPtr, hPtr));
+	*guard2Ptr = *guardPtr;
+	if (guard2Ptr->patternsObj != NULL) {
+	    Tcl_IncrRefCount(guard2Ptr->patternsObj);
+	}
+    }
+    return copyPtr;
+}
+
+void
+TclOODeleteFilterGuards(
+    Tcl_HashTable *guardsPtr)
+{
+    Tcl_HashSearch search;
+    Tcl_HashEntry *hPtr;
+    FilterGuard *guardPtr;
+
+    if (guardsPtr == NULL) {
+	return;
+    }
+    for (hPtr = Tcl_FirstHashEntry(guardsPtr, &search); hPtr != NULL;
+	    hPtr = Tcl_NextHashEntry(&search)) {
+	guardPtr = Tcl_GetHashValue(hPtr);
+	if (guardPtr->patternsObj != NULL) {
+	    Tcl_DecrRefCount(guardPtr->patternsObj);
+	}
+	ckfree((char *) guardPtr);
+    }
+    Tcl_DeleteHashTable(guardsPtr);
+    ckfree((char *) guardsPtr);
+}
+
 /*
  * ----------------------------------------------------------------------
  *
@@ -778,6 +1003,38 @@ GenerateErrorInfo(
 	    (overflow ? "..." : ""), interp->errorLine));
 }
 
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOBeginDefinitions, TclOOCommitDefinitions --
+ *	Bracket a batch of changes to the structure of classes and objects,
+ *	so that the invalidation of cached call chains that they cause is
+ *	only done once instead of once per change. Batches may nest; the
+ *	invalidation happens when the outermost batch is committed, or
+ *	earlier if a method is called in the middle of the batch (so that no
+ *	stale call chain can ever be used).
+ *
+ * ----------------------------------------------------------------------
+ */
+
+void
+TclOOBeginDefinitions(
+    Tcl_Interp *interp)
+{
+    TclOOGetFoundation(interp)->defineDepth++;
+}
+
+void
+TclOOCommitDefinitions(
+    Tcl_Interp *interp)
+{
+    Foundation *fPtr = TclOOGetFoundation(interp);
+
+    if (fPtr->defineDepth > 0 && --fPtr->defineDepth == 0) {
+	TclOOSyncEpoch(fPtr);
+    }
+}
+
 /*
  * ----------------------------------------------------------------------
  *
@@ -827,6 +1084,7 @@ TclOODefineObjCmd(
     }
 
     AddRef(oPtr);
+    TclOOBeginDefinitions(interp);
     if (objc == 3) {
 	Tcl_Obj *objNameObj = TclOOObjectName(interp, oPtr);
 
@@ -887,6 +1145,7 @@ TclOODefineObjCmd(
 	result = Tcl_EvalObjv(interp, objc-2, objs, TCL_EVAL_INVOKE);
 	Tcl_DecrRefCount(objPtr);
     }
+    TclOOCommitDefinitions(interp);
     DelRef(oPtr);
 
     /*
@@ -941,6 +1200,7 @@ TclOOObjDefObjCmd(
     }
 
     AddRef(oPtr);
+    TclOOBeginDefinitions(interp);
     if (objc == 3) {
 	Tcl_Obj *objNameObj = TclOOObjectName(interp, oPtr);
 
@@ -1001,6 +1261,7 @@ TclOOObjDefObjCmd(
 	result = Tcl_EvalObjv(interp, objc-2, objs, TCL_EVAL_INVOKE);
 	Tcl_DecrRefCount(objPtr);
     }
+    TclOOCommitDefinitions(interp);
     DelRef(oPtr);
 
     /*
@@ -1055,6 +1316,7 @@ TclOODefineSelfObjCmd(
     }
 
     AddRef(oPtr);
+    TclOOBeginDefinitions(interp);
     if (objc == 2) {
 	Tcl_Obj *objNameObj = TclOOObjectName(interp, oPtr);
 
@@ -1115,6 +1377,7 @@ TclOODefineSelfObjCmd(
 	result = Tcl_EvalObjv(interp, objc-1, objs, TCL_EVAL_INVOKE);
 	Tcl_DecrRefCount(objPtr);
     }
+    TclOOCommitDefinitions(interp);
     DelRef(oPtr);
 
     /*
@@ -1125,6 +1388,57 @@ TclOODefineSelfObjCmd(
     return result;
 }
 
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOODefineAutoDestroyObjCmd --
+ *	Implementation of the "autodestroy" subcommand of the "oo::define"
+ *	command.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+TclOODefineAutoDestroyObjCmd(
+    ClientData clientData,
+    Tcl_Interp *interp,
+    int objc,
+    Tcl_Obj *const *objv)
+{
+    Object *oPtr;
+    int autoDestroy;
+
+    if (objc != 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "boolean");
+	return TCL_ERROR;
+    }
+
+    oPtr = (Object *) TclOOGetDefineCmdContext(interp);
+    if (oPtr == NULL) {
+	return TCL_ERROR;
+    }
+    if (oPtr->classPtr == NULL) {
+	Tcl_AppendResult(interp, "attempt to misuse API", NULL);
+	return TCL_ERROR;
+    }
+    if (TclOOCheckNotFrozen(interp, oPtr->classPtr) != TCL_OK
+	    || Tcl_GetBooleanFromObj(interp, objv[1],
+		    &autoDestroy) != TCL_OK) {
+	return TCL_ERROR;
+    }
+
+    /*
+     * Only affects the objects that [new] makes from now on.
+     */
+
+    if (autoDestroy) {
+	oPtr->classPtr->flags |= AUTO_DESTROY;
+    } else {
+	oPtr->classPtr->flags &= ~AUTO_DESTROY;
+    }
+    return TCL_OK;
+}
+
 /*
  * ----------------------------------------------------------------------
  *
@@ -1246,6 +1560,9 @@ TclOODefineConstructorObjCmd(
 	return TCL_ERROR;
     }
     clsPtr = oPtr->classPtr;
+    if (TclOOCheckNotFrozen(interp, clsPtr) != TCL_OK) {
+	return TCL_ERROR;
+    }
 
     Tcl_GetStringFromObj(objv[2], &bodyLength);
     if (bodyLength > 0) {
@@ -1311,6 +1628,10 @@ TclOODefineDeleteMethodObjCmd(
 	Tcl_AppendResult(interp, "attempt to misuse API", NULL);
 	return TCL_ERROR;
     }
+    if (!isInstanceDeleteMethod
+	    && TclOOCheckNotFrozen(interp, oPtr->classPtr) != TCL_OK) {
+	return TCL_ERROR;
+    }
 
     for (i=1 ; i<objc ; i++) {
 	/*
@@ -1363,6 +1684,9 @@ TclOODefineDestructorObjCmd(
 	return TCL_ERROR;
     }
     clsPtr = oPtr->classPtr;
+    if (TclOOCheckNotFrozen(interp, clsPtr) != TCL_OK) {
+	return TCL_ERROR;
+    }
 
     Tcl_GetStringFromObj(objv[1], &bodyLength);
     if (bodyLength > 0) {
@@ -1433,6 +1757,10 @@ TclOODefineExportObjCmd(
 	Tcl_AppendResult(interp, "attempt to misuse API", NULL);
 	return TCL_ERROR;
     }
+    if (!isInstanceExport
+	    && TclOOCheckNotFrozen(interp, clsPtr) != TCL_OK) {
+	return TCL_ERROR;
+    }
 
     for (i=1 ; i<objc ; i++) {
 	/*
@@ -1488,6 +1816,112 @@ TclOODefineExportObjCmd(
     return TCL_OK;
 }
 
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOODefineFilterGuardObjCmd --
+ *	Implementation of the "filterguard" subcommand of the "oo::define"
+ *	and "oo::objdefine" commands.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+TclOODefineFilterGuardObjCmd(
+    ClientData clientData,
+    Tcl_Interp *interp,
+    int objc,
+    Tcl_Obj *const *objv)
+{
+    static const char *options[] = {
+	"-calls", "-methods", NULL
+    };
+    enum GuardOpts {
+	GUARD_CALLS, GUARD_METHODS
+    };
+    static const char *callKinds[] = {
+	"all", "public", "private", NULL
+    };
+    static const int callFlags[] = {
+	GUARD_ALL_CALLS, GUARD_PUBLIC_CALLS, GUARD_PRIVATE_CALLS
+    };
+    int isInstanceGuard = PTR2INT(clientData);
+    Object *oPtr;
+    Tcl_HashTable **guardsPtrPtr;
+    FilterGuard *guardPtr;
+    Tcl_Obj *patternsObj = NULL;
+    int i, idx, len, calls = GUARD_ALL_CALLS;
+
+    if (objc < 2 || (objc & 1)) {
+	Tcl_WrongNumArgs(interp, 1, objv,
+		"filterName ?-methods patternList? ?-calls kind?");
+	return TCL_ERROR;
+    }
+
+    oPtr = (Object *) TclOOGetDefineCmdContext(interp);
+    if (oPtr == NULL) {
+	return TCL_ERROR;
+    }
+    if (!isInstanceGuard && !oPtr->classPtr) {
+	Tcl_AppendResult(interp, "attempt to misuse API", NULL);
+	return TCL_ERROR;
+    }
+    if (!isInstanceGuard
+	    && TclOOCheckNotFrozen(interp, oPtr->classPtr) != TCL_OK) {
+	return TCL_ERROR;
+    }
+
+    for (i=2 ; i<objc ; i+=2) {
+	if (Tcl_GetIndexFromObj(interp, objv[i], options, "option", 0,
+		&idx) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	switch ((enum GuardOpts) idx) {
+	case GUARD_CALLS:
+	    if (Tcl_GetIndexFromObj(interp, objv[i+1], callKinds, "kind", 0,
+		    &idx) != TCL_OK) {
+		return TCL_ERROR;
+	    }
+	    calls = callFlags[idx];
+	    break;
+	case GUARD_METHODS:
+	    if (Tcl_ListObjLength(interp, objv[i+1], &len) != TCL_OK) {
+		return TCL_ERROR;
+	    }
+	    patternsObj = objv[i+1];
+	    break;
+	}
+    }
+
+    /*
+     * Install the guard. Giving no options removes the guard, though any
+     * guard function installed from C is left alone.
+     */
+
+    if (isInstanceGuard) {
+	guardsPtrPtr = &oPtr->filterGuards;
+    } else {
+	guardsPtrPtr = &oPtr->classPtr->filterGuards;
+    }
+    guardPtr = GetFilterGuard(guardsPtrPtr, objv[1]);
+    if (patternsObj != NULL) {
+	Tcl_IncrRefCount(patternsObj);
+    }
+    if (guardPtr->patternsObj != NULL) {
+	Tcl_DecrRefCount(guardPtr->patternsObj);
+    }
+    guardPtr->patternsObj = patternsObj;
+    guardPtr->calls = calls;
+    TidyFilterGuard(guardsPtrPtr, objv[1]);
+
+    if (isInstanceGuard) {
+	oPtr->epoch++;
+    } else {
+	BumpGlobalEpoch(interp, oPtr->classPtr);
+    }
+    return TCL_OK;
+}
+
 /*
  * ----------------------------------------------------------------------
  *
@@ -1524,6 +1958,10 @@ TclOODefineForwardObjCmd(
 	Tcl_AppendResult(interp, "attempt to misuse API", NULL);
 	return TCL_ERROR;
     }
+    if (!isInstanceForward
+	    && TclOOCheckNotFrozen(interp, oPtr->classPtr) != TCL_OK) {
+	return TCL_ERROR;
+    }
     isPublic = Tcl_StringMatch(TclGetString(objv[1]), "[a-z]*")
 	    ? PUBLIC_METHOD : 0;
 
@@ -1549,26 +1987,23 @@ TclOODefineForwardObjCmd(
 /*
  * ----------------------------------------------------------------------
  *
- * TclOODefineMethodObjCmd --
- *	Implementation of the "method" subcommand of the "oo::define" and
- *	"oo::objdefine" commands.
+ * TclOODefineFreezeObjCmd --
+ *	Implementation of the "freeze" subcommand of the "oo::define" command.
  *
  * ----------------------------------------------------------------------
  */
 
 int
-TclOODefineMethodObjCmd(
+TclOODefineFreezeObjCmd(
     ClientData clientData,
     Tcl_Interp *interp,
     int objc,
     Tcl_Obj *const *objv)
 {
-    int isInstanceMethod = PTR2INT(clientData);
     Object *oPtr;
-    int isPublic;
 
-    if (objc != 4) {
-	Tcl_WrongNumArgs(interp, 1, objv, "name args body");
+    if (objc != 1) {
+	Tcl_WrongNumArgs(interp, 1, objv, NULL);
 	return TCL_ERROR;
     }
 
@@ -1576,37 +2011,383 @@ TclOODefineMethodObjCmd(
     if (oPtr == NULL) {
 	return TCL_ERROR;
     }
-    if (!isInstanceMethod && !oPtr->classPtr) {
+    if (oPtr->classPtr == NULL) {
 	Tcl_AppendResult(interp, "attempt to misuse API", NULL);
 	return TCL_ERROR;
     }
-    isPublic = Tcl_StringMatch(TclGetString(objv[1]), "[a-z]*")
-	    ? PUBLIC_METHOD : 0;
+    if (oPtr->flags & (ROOT_OBJECT | ROOT_CLASS)) {
+	Tcl_AppendResult(interp, "may not freeze a root class", NULL);
+	return TCL_ERROR;
+    }
 
     /*
-     * Create the method by using the right back-end API.
+     * Nothing about how methods are resolved changes, but the chains that
+     * the pure instances are using were not made permanent, so make them be
+     * rebuilt.
      */
 
-    if (isInstanceMethod) {
-	if (TclOONewProcInstanceMethod(interp, oPtr, isPublic, objv[1],
-		objv[2], objv[3], NULL) == NULL) {
-	    return TCL_ERROR;
-	}
-    } else {
-	if (TclOONewProcMethod(interp, oPtr->classPtr, isPublic, objv[1],
-		objv[2], objv[3], NULL) == NULL) {
-	    return TCL_ERROR;
-	}
-    }
+    FreezeClass(oPtr->classPtr);
+    oPtr->epoch++;
     return TCL_OK;
 }
 
 /*
  * ----------------------------------------------------------------------
  *
- * TclOODefineRenameMethodObjCmd --
- *	Implementation of the "renamemethod" subcommand of the "oo::define"
- *	and "oo::objdefine" commands.
+ * TclOODefineMemoizeObjCmd --
+ *	Implementation of the "memoize" subcommand of the "oo::define" and
+ *	"oo::objdefine" commands.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+TclOODefineMemoizeObjCmd(
+    ClientData clientData,
+    Tcl_Interp *interp,
+    int objc,
+    Tcl_Obj *const *objv)
+{
+    static const char *options[] = {
+	"-invalidate-on", "-key", NULL
+    };
+    enum MemoOpts {
+	MEMO_INVALIDATE, MEMO_KEY
+    };
+    int isInstanceMemoize = PTR2INT(clientData);
+    Object *oPtr;
+    Tcl_HashEntry *hPtr;
+    Tcl_Obj *keysObj = NULL, *varsObj = NULL;
+    Method *mPtr;
+    int i, idx;
+
+    if (objc < 2 || (objc & 1)) {
+	Tcl_WrongNumArgs(interp, 1, objv,
+		"name ?-key argNames? ?-invalidate-on varNames?");
+	return TCL_ERROR;
+    }
+
+    oPtr = (Object *) TclOOGetDefineCmdContext(interp);
+    if (oPtr == NULL) {
+	return TCL_ERROR;
+    }
+    if (!isInstanceMemoize && !oPtr->classPtr) {
+	Tcl_AppendResult(interp, "attempt to misuse API", NULL);
+	return TCL_ERROR;
+    }
+    if (!isInstanceMemoize
+	    && TclOOCheckNotFrozen(interp, oPtr->classPtr) != TCL_OK) {
+	return TCL_ERROR;
+    }
+
+    for (i=2 ; i<objc ; i+=2) {
+	if (Tcl_GetIndexFromObj(interp, objv[i], options, "option", 0,
+		&idx) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	switch ((enum MemoOpts) idx) {
+	case MEMO_INVALIDATE:
+	    varsObj = objv[i+1];
+	    break;
+	case MEMO_KEY:
+	    keysObj = objv[i+1];
+	    break;
+	}
+    }
+
+    /*
+     * Find the method, which must already have been defined here.
+     */
+
+    if (isInstanceMemoize) {
+	hPtr = (oPtr->methodsPtr == NULL ? NULL :
+		Tcl_FindHashEntry(oPtr->methodsPtr, (char *) objv[1]));
+    } else {
+	hPtr = Tcl_FindHashEntry(&oPtr->classPtr->classMethods,
+		(char *) objv[1]);
+    }
+    if (hPtr == NULL || (mPtr = Tcl_GetHashValue(hPtr))->typePtr == NULL) {
+	Tcl_AppendResult(interp, "method \"", TclGetString(objv[1]),
+		"\" does not exist", NULL);
+	return TCL_ERROR;
+    }
+    return TclOOMemoizeMethod(interp, mPtr, keysObj, varsObj);
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOODefineMethodObjCmd --
+ *	Implementation of the "method" subcommand of the "oo::define" and
+ *	"oo::objdefine" commands.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+TclOODefineMethodObjCmd(
+    ClientData clientData,
+    Tcl_Interp *interp,
+    int objc,
+    Tcl_Obj *const *objv)
+{
+    int isInstanceMethod = PTR2INT(clientData);
+    Object *oPtr;
+    int isPublic;
+
+    if (objc != 4) {
+	Tcl_WrongNumArgs(interp, 1, objv, "name args body");
+	return TCL_ERROR;
+    }
+
+    oPtr = (Object *) TclOOGetDefineCmdContext(interp);
+    if (oPtr == NULL) {
+	return TCL_ERROR;
+    }
+    if (!isInstanceMethod && !oPtr->classPtr) {
+	Tcl_AppendResult(interp, "attempt to misuse API", NULL);
+	return TCL_ERROR;
+    }
+    if (!isInstanceMethod
+	    && TclOOCheckNotFrozen(interp, oPtr->classPtr) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    isPublic = Tcl_StringMatch(TclGetString(objv[1]), "[a-z]*")
+	    ? PUBLIC_METHOD : 0;
+
+    /*
+     * Create the method by using the right back-end API.
+     */
+
+    if (isInstanceMethod) {
+	if (TclOONewProcInstanceMethod(interp, oPtr, isPublic, objv[1],
+		objv[2], objv[3], NULL) == NULL) {
+	    return TCL_ERROR;
+	}
+    } else {
+	if (TclOONewProcMethod(interp, oPtr->classPtr, isPublic, objv[1],
+		objv[2], objv[3], NULL) == NULL) {
+	    return TCL_ERROR;
+	}
+    }
+    return TCL_OK;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOODefinePoolObjCmd --
+ *	Implementation of the "pool" subcommand of the "oo::define" command.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+TclOODefinePoolObjCmd(
+    ClientData clientData,
+    Tcl_Interp *interp,
+    int objc,
+    Tcl_Obj *const *objv)
+{
+    Object *oPtr;
+    int poolSize = POOL_DEFAULT_SIZE;
+
+    if (objc > 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "?maxSize?");
+	return TCL_ERROR;
+    }
+
+    oPtr = (Object *) TclOOGetDefineCmdContext(interp);
+    if (oPtr == NULL) {
+	return TCL_ERROR;
+    }
+    if (oPtr->classPtr == NULL) {
+	Tcl_AppendResult(interp, "attempt to misuse API", NULL);
+	return TCL_ERROR;
+    }
+    if (objc == 2
+	    && Tcl_GetIntFromObj(interp, objv[1], &poolSize) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    if (poolSize < 0) {
+	Tcl_AppendResult(interp, "pool size may not be negative", NULL);
+	return TCL_ERROR;
+    }
+
+    /*
+     * Shrinking the pool finishes off the objects that no longer fit.
+     */
+
+    oPtr->classPtr->poolSize = poolSize;
+    TclOOTrimPool(interp, oPtr->classPtr, poolSize);
+    return TCL_OK;
+}
+
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOODefinePrecompileObjCmd --
+ *	Implementation of the "precompile" subcommand of the "oo::define"
+ *	command.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+TclOODefinePrecompileObjCmd(
+    ClientData clientData,
+    Tcl_Interp *interp,
+    int objc,
+    Tcl_Obj *const *objv)
+{
+    Object *oPtr;
+    Class *clsPtr;
+    Tcl_Obj *patternObj;
+
+    if (objc > 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "?pattern?");
+	return TCL_ERROR;
+    }
+
+    oPtr = (Object *) TclOOGetDefineCmdContext(interp);
+    if (oPtr == NULL) {
+	return TCL_ERROR;
+    }
+    clsPtr = oPtr->classPtr;
+    if (clsPtr == NULL) {
+	Tcl_AppendResult(interp, "attempt to misuse API", NULL);
+	return TCL_ERROR;
+    }
+
+    patternObj = (objc == 2 ? objv[1] : Tcl_NewStringObj("*", 1));
+    Tcl_IncrRefCount(patternObj);
+    if (TclOOPrecompileClass(interp, clsPtr,
+	    TclGetString(patternObj)) != TCL_OK) {
+	Tcl_DecrRefCount(patternObj);
+	return TCL_ERROR;
+    }
+
+    /*
+     * Remember the pattern so that the chains can be rebuilt after they are
+     * next invalidated, if [oo::cache rewarm] is turned on.
+     */
+
+    if (clsPtr->warmPatternObj != NULL) {
+	Tcl_DecrRefCount(clsPtr->warmPatternObj);
+    }
+    clsPtr->warmPatternObj = patternObj;
+    return TCL_OK;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOODefinePropertyObjCmd --
+ *	Implementation of the "property" subcommand of the "oo::define" and
+ *	"oo::objdefine" commands.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+TclOODefinePropertyObjCmd(
+    ClientData clientData,
+    Tcl_Interp *interp,
+    int objc,
+    Tcl_Obj *const *objv)
+{
+    static const char *options[] = {
+	"-get", "-set", "-validate", NULL
+    };
+    enum PropOpts {
+	PROP_GET, PROP_SET, PROP_VALIDATE
+    };
+    int isInstanceProperty = PTR2INT(clientData);
+    Object *oPtr;
+    Method *mPtr;
+    int i, idx, isPublic, accessFlags = 0;
+    Tcl_Obj *validateObj = NULL;
+    const char *name;
+
+    if (objc < 2) {
+	Tcl_WrongNumArgs(interp, 1, objv,
+		"name ?-get? ?-set? ?-validate cmdPrefix?");
+	return TCL_ERROR;
+    }
+
+    oPtr = (Object *) TclOOGetDefineCmdContext(interp);
+    if (oPtr == NULL) {
+	return TCL_ERROR;
+    }
+    if (!isInstanceProperty && !oPtr->classPtr) {
+	Tcl_AppendResult(interp, "attempt to misuse API", NULL);
+	return TCL_ERROR;
+    }
+    if (!isInstanceProperty
+	    && TclOOCheckNotFrozen(interp, oPtr->classPtr) != TCL_OK) {
+	return TCL_ERROR;
+    }
+
+    /*
+     * The property is held in a variable of the same name, so that name had
+     * better be a simple one.
+     */
+
+    name = TclGetString(objv[1]);
+    if (name[0] == '\0' || strstr(name, "::") != NULL
+	    || strchr(name, '(') != NULL) {
+	Tcl_AppendResult(interp, "bad property name \"", name,
+		"\": must be a simple variable name", NULL);
+	return TCL_ERROR;
+    }
+
+    for (i=2 ; i<objc ; i++) {
+	if (Tcl_GetIndexFromObj(interp, objv[i], options, "option", 0,
+		&idx) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	switch ((enum PropOpts) idx) {
+	case PROP_GET:
+	    accessFlags |= PROPERTY_GET;
+	    break;
+	case PROP_SET:
+	    accessFlags |= PROPERTY_SET;
+	    break;
+	case PROP_VALIDATE:
+	    if (++i >= objc) {
+		Tcl_AppendResult(interp, "missing command prefix for ",
+			"-validate option", NULL);
+		return TCL_ERROR;
+	    }
+	    validateObj = objv[i];
+	    break;
+	}
+    }
+    if (accessFlags == 0) {
+	accessFlags = PROPERTY_GET | PROPERTY_SET;
+    }
+    isPublic = Tcl_StringMatch(name, "[a-z]*") ? PUBLIC_METHOD : 0;
+
+    /*
+     * Create the method structure.
+     */
+
+    mPtr = TclOONewPropertyMethod(interp, oPtr,
+	    (isInstanceProperty ? NULL : oPtr->classPtr), isPublic, objv[1],
+	    accessFlags, validateObj);
+    if (mPtr == NULL) {
+	return TCL_ERROR;
+    }
+    return TCL_OK;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOODefineRenameMethodObjCmd --
+ *	Implementation of the "renamemethod" subcommand of the "oo::define"
+ *	and "oo::objdefine" commands.
  *
  * ----------------------------------------------------------------------
  */
@@ -1634,6 +2415,10 @@ TclOODefineRenameMethodObjCmd(
 	Tcl_AppendResult(interp, "attempt to misuse API", NULL);
 	return TCL_ERROR;
     }
+    if (!isInstanceRenameMethod
+	    && TclOOCheckNotFrozen(interp, oPtr->classPtr) != TCL_OK) {
+	return TCL_ERROR;
+    }
 
     /*
      * Delete the method entry from the appropriate hash table, and transfer
@@ -1693,6 +2478,10 @@ TclOODefineUnexportObjCmd(
 	Tcl_AppendResult(interp, "attempt to misuse API", NULL);
 	return TCL_ERROR;
     }
+    if (!isInstanceUnexport
+	    && TclOOCheckNotFrozen(interp, clsPtr) != TCL_OK) {
+	return TCL_ERROR;
+    }
 
     for (i=1 ; i<objc ; i++) {
 	/*
@@ -1791,14 +2580,44 @@ Tcl_ClassSetDestructor(
 	BumpGlobalEpoch(interp, clsPtr);
     }
 }
+
+void
+Tcl_ClassSetFilterGuard(
+    Tcl_Class clazz,
+    Tcl_Obj *filterNameObj,
+    Tcl_ObjectFilterGuardProc *guardProc,
+    ClientData clientData)
+{
+    Class *clsPtr = (Class *) clazz;
+    FilterGuard *guardPtr;
+
+    if (guardProc == NULL && (clsPtr->filterGuards == NULL
+	    || Tcl_FindHashEntry(clsPtr->filterGuards,
+		    (char *) filterNameObj) == NULL)) {
+	return;
+    }
+    guardPtr = GetFilterGuard(&clsPtr->filterGuards, filterNameObj);
+    guardPtr->guardProc = guardProc;
+    guardPtr->clientData = clientData;
+    TidyFilterGuard(&clsPtr->filterGuards, filterNameObj);
+
+    /*
+     * There is no interpreter to hand, so go straight to the foundation.
+     */
+
+    TclOOBumpEpoch(clsPtr->thisPtr->fPtr);
+    TclOOBumpFrozenEpoch(clsPtr->thisPtr->fPtr, clsPtr);
+}
 
 int
 TclOODefineSlots(
     Foundation *fPtr)
 {
     const struct DeclaredSlot *slotInfoPtr;
-    Tcl_Obj *getName = Tcl_NewStringObj("Get", -1);
-    Tcl_Obj *setName = Tcl_NewStringObj("Set", -1);
+    const DeclaredClassMethod *mPtr;
+    Tcl_Obj *getName = fPtr->slotGetName;
+    Tcl_Obj *setName = fPtr->slotSetName;
+    Tcl_Obj *argsObj, *bodyObj;
     Class *slotCls;
 
     slotCls = ((Object *) Tcl_NewObjectInstance(fPtr->interp, (Tcl_Class)
@@ -1806,8 +2625,34 @@ TclOODefineSlots(
     if (slotCls == NULL) {
 	return TCL_ERROR;
     }
-    Tcl_IncrRefCount(getName);
-    Tcl_IncrRefCount(setName);
+    for (mPtr = slotMethods ; mPtr->name ; mPtr++) {
+	TclOONewBasicMethod(fPtr->interp, slotCls, mPtr);
+    }
+
+    /*
+     * Build the overridable methods directly rather than by evaluating a
+     * definition script, as this is done for every interpreter. The [destroy]
+     * method is unexported, as slots are not meant to be deleted.
+     */
+
+    argsObj = Tcl_NewObj();
+    bodyObj = Tcl_NewStringObj(slotUnimplementedBody, -1);
+    Tcl_IncrRefCount(argsObj);
+    Tcl_IncrRefCount(bodyObj);
+    TclOONewProcMethod(fPtr->interp, slotCls, 0, getName, argsObj, bodyObj,
+	    NULL);
+    Tcl_DecrRefCount(argsObj);
+    argsObj = Tcl_NewStringObj("list", 4);
+    Tcl_IncrRefCount(argsObj);
+    TclOONewProcMethod(fPtr->interp, slotCls, 0, setName, argsObj, bodyObj,
+	    NULL);
+    Tcl_DecrRefCount(argsObj);
+    Tcl_DecrRefCount(bodyObj);
+    TclOONewForwardMethod(fPtr->interp, slotCls, 0, fPtr->slotDefOpName,
+	    Tcl_NewStringObj(slotDefaultOpPrefix, -1));
+    Tcl_NewMethod(fPtr->interp, (Tcl_Class) slotCls,
+	    Tcl_NewStringObj("destroy", 7), 0, NULL, NULL);
+
     for (slotInfoPtr = slots ; slotInfoPtr->name ; slotInfoPtr++) {
 	Tcl_Object slotObject = Tcl_NewObjectInstance(fPtr->interp,
 		(Tcl_Class) slotCls, slotInfoPtr->name, NULL,-1,NULL,0);
@@ -1819,12 +2664,154 @@ TclOODefineSlots(
 		&slotInfoPtr->getterType, NULL);
 	Tcl_NewInstanceMethod(fPtr->interp, slotObject, setName, 0,
 		&slotInfoPtr->setterType, NULL);
+	if (slotInfoPtr->defaultOpPrefix != NULL) {
+	    TclOONewForwardInstanceMethod(fPtr->interp,
+		    (Object *) slotObject, 0, fPtr->slotDefOpName,
+		    Tcl_NewStringObj(slotInfoPtr->defaultOpPrefix, -1));
+	}
     }
-    Tcl_DecrRefCount(getName);
-    Tcl_DecrRefCount(setName);
     return TCL_OK;
 }
 
+/*
+ * ----------------------------------------------------------------------
+ *
+ * SlotSet, SlotAppend, SlotClear, SlotUnknown --
+ *	Implementations of the "-set", "-append" and "-clear" operations of
+ *	slots, and of the "unknown" method that makes anything that is not an
+ *	operation go to the slot's "--default-operation". They do their work
+ *	by calling the slot's "Get", "Set" and "--default-operation" methods,
+ *	so those remain the way to customize a slot. Being implemented in C,
+ *	these methods do not push a call frame, so the methods they call see
+ *	the same context (e.g., the [oo::define] that is in progress) as the
+ *	code that used the slot.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+InvokeSlotMethod(
+    Tcl_Interp *interp,
+    Tcl_ObjectContext context,	/* The context of the slot operation. */
+    Tcl_Obj *methodNameObj,	/* Name of the method of the slot to call. */
+    int objc,			/* Number of arguments to the method. */
+    Tcl_Obj *const *objv)	/* Arguments to the method. */
+{
+    Object *oPtr = (Object *) Tcl_ObjectContextObject(context);
+    Tcl_Obj **argObjs;
+    int result;
+
+    argObjs = TclStackAlloc(interp, sizeof(Tcl_Obj *) * (objc + 2));
+    argObjs[0] = TclOOObjectName(interp, oPtr);
+    argObjs[1] = methodNameObj;
+    if (objc > 0) {
+	memcpy(argObjs + 2, objv, sizeof(Tcl_Obj *) * objc);
+    }
+    Tcl_IncrRefCount(argObjs[0]);
+    result = TclOOObjectCmdCore(oPtr, interp, objc + 2, argObjs, 0, NULL);
+    Tcl_DecrRefCount(argObjs[0]);
+    TclStackFree(interp, argObjs);
+    return result;
+}
+
+static int
+SlotSet(
+    ClientData clientData,
+    Tcl_Interp *interp,
+    Tcl_ObjectContext context,
+    int objc,
+    Tcl_Obj *const *objv)
+{
+    Object *oPtr = (Object *) Tcl_ObjectContextObject(context);
+    int skip = Tcl_ObjectContextSkippedArgs(context);
+    Tcl_Obj *listObj = Tcl_NewListObj(objc - skip, objv + skip);
+    int result;
+
+    Tcl_IncrRefCount(listObj);
+    result = InvokeSlotMethod(interp, context, oPtr->fPtr->slotSetName, 1,
+	    &listObj);
+    Tcl_DecrRefCount(listObj);
+    return result;
+}
+
+static int
+SlotAppend(
+    ClientData clientData,
+    Tcl_Interp *interp,
+    Tcl_ObjectContext context,
+    int objc,
+    Tcl_Obj *const *objv)
+{
+    Object *oPtr = (Object *) Tcl_ObjectContextObject(context);
+    int skip = Tcl_ObjectContextSkippedArgs(context);
+    Tcl_Obj *listObj;
+    int length, result;
+
+    if (InvokeSlotMethod(interp, context, oPtr->fPtr->slotGetName, 0,
+	    NULL) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    listObj = Tcl_GetObjResult(interp);
+    if (Tcl_IsShared(listObj)) {
+	listObj = Tcl_DuplicateObj(listObj);
+    }
+    Tcl_IncrRefCount(listObj);
+    Tcl_ResetResult(interp);
+    if (Tcl_ListObjLength(interp, listObj, &length) != TCL_OK
+	    || Tcl_ListObjReplace(interp, listObj, length, 0, objc - skip,
+		    objv + skip) != TCL_OK) {
+	Tcl_DecrRefCount(listObj);
+	return TCL_ERROR;
+    }
+    result = InvokeSlotMethod(interp, context, oPtr->fPtr->slotSetName, 1,
+	    &listObj);
+    Tcl_DecrRefCount(listObj);
+    return result;
+}
+
+static int
+SlotClear(
+    ClientData clientData,
+    Tcl_Interp *interp,
+    Tcl_ObjectContext context,
+    int objc,
+    Tcl_Obj *const *objv)
+{
+    Object *oPtr = (Object *) Tcl_ObjectContextObject(context);
+    Tcl_Obj *listObj;
+    int result;
+
+    if (Tcl_ObjectContextSkippedArgs(context) != objc) {
+	Tcl_WrongNumArgs(interp, Tcl_ObjectContextSkippedArgs(context), objv,
+		NULL);
+	return TCL_ERROR;
+    }
+    listObj = Tcl_NewObj();
+    Tcl_IncrRefCount(listObj);
+    result = InvokeSlotMethod(interp, context, oPtr->fPtr->slotSetName, 1,
+	    &listObj);
+    Tcl_DecrRefCount(listObj);
+    return result;
+}
+
+static int
+SlotUnknown(
+    ClientData clientData,
+    Tcl_Interp *interp,
+    Tcl_ObjectContext context,
+    int objc,
+    Tcl_Obj *const *objv)
+{
+    Object *oPtr = (Object *) Tcl_ObjectContextObject(context);
+    int skip = Tcl_ObjectContextSkippedArgs(context);
+
+    if (skip == objc || TclGetString(objv[skip])[0] != '-') {
+	return InvokeSlotMethod(interp, context, oPtr->fPtr->slotDefOpName,
+		objc - skip, objv + skip);
+    }
+    return Tcl_ObjectContextInvokeNext(interp, context, objc, objv, skip);
+}
+
 static int
 ClassFilterGet(
     ClientData clientData,
@@ -1881,6 +2868,8 @@ ClassFilterSet(
     } else if (!oPtr->classPtr) {
 	Tcl_AppendResult(interp, "attempt to misuse API", NULL);
 	return TCL_ERROR;
+    } else if (TclOOCheckNotFrozen(interp, oPtr->classPtr) != TCL_OK) {
+	return TCL_ERROR;
     } else if (Tcl_ListObjGetElements(interp, objv[0], &filterc,
 	    &filterv) != TCL_OK) {
 	return TCL_ERROR;
@@ -1950,6 +2939,8 @@ ClassMixinSet(
     } else if (!oPtr->classPtr) {
 	Tcl_AppendResult(interp, "attempt to misuse API", NULL);
 	return TCL_ERROR;
+    } else if (TclOOCheckNotFrozen(interp, oPtr->classPtr) != TCL_OK) {
+	return TCL_ERROR;
     } else if (Tcl_ListObjGetElements(interp, objv[0], &mixinc,
 	    &mixinv) != TCL_OK) {
 	return TCL_ERROR;
@@ -2041,6 +3032,8 @@ ClassSuperSet(
 	Tcl_AppendResult(interp,
 		"may not modify the superclass of the root object", NULL);
 	return TCL_ERROR;
+    } else if (TclOOCheckNotFrozen(interp, oPtr->classPtr) != TCL_OK) {
+	return TCL_ERROR;
     } else if (Tcl_ListObjGetElements(interp, objv[0], &superc,
 	    &superv) != TCL_OK) {
 	return TCL_ERROR;
@@ -2173,6 +3166,8 @@ ClassVarsSet(
     } else if (!oPtr->classPtr) {
 	Tcl_AppendResult(interp, "attempt to misuse API", NULL);
 	return TCL_ERROR;
+    } else if (TclOOCheckNotFrozen(interp, oPtr->classPtr) != TCL_OK) {
+	return TCL_ERROR;
     } else if (Tcl_ListObjGetElements(interp, objv[0], &varc,
 	    &varv) != TCL_OK) {
 	return TCL_ERROR;
@@ -39,6 +39,7 @@ static Tcl_ObjCmdProc InfoClassInstancesCmd;
 static Tcl_ObjCmdProc InfoClassMethodsCmd;
 static Tcl_ObjCmdProc InfoClassMethodTypeCmd;
 static Tcl_ObjCmdProc InfoClassMixinsCmd;
+static Tcl_ObjCmdProc InfoClassPoolCmd;
 static Tcl_ObjCmdProc InfoClassSubsCmd;
 static Tcl_ObjCmdProc InfoClassSupersCmd;
 static Tcl_ObjCmdProc InfoClassVariablesCmd;
@@ -80,6 +81,7 @@ static const struct NameProcMap infoClassCmds[] = {
     {"::oo::InfoClass::methods",      InfoClassMethodsCmd},
     {"::oo::InfoClass::methodtype",   InfoClassMethodTypeCmd},
     {"::oo::InfoClass::mixins",	      InfoClassMixinsCmd},
+    {"::oo::InfoClass::pool",	      InfoClassPoolCmd},
     {"::oo::InfoClass::subclasses",   InfoClassSubsCmd},
     {"::oo::InfoClass::superclasses", InfoClassSupersCmd},
     {"::oo::InfoClass::variables",    InfoClassVariablesCmd},
@@ -1126,8 +1128,18 @@ InfoClassInstancesCmd(
 
     resultObj = Tcl_NewObj();
     FOREACH(oPtr, clsPtr->instances) {
-	Tcl_Obj *tmpObj = TclOOObjectName(interp, oPtr);
+	Tcl_Obj *tmpObj;
 
+	if (oPtr->command == NULL) {
+	    /*
+	     * Objects whose destruction has been deferred, and objects in the
+	     * class's pool, are still listed with their class, but they can't
+	     * be reached any more.
+	     */
+
+	    continue;
+	}
+	tmpObj = TclOOObjectName(interp, oPtr);
 	if (pattern && !Tcl_StringMatch(TclGetString(tmpObj), pattern)) {
 	    continue;
 	}
@@ -1308,6 +1320,53 @@ InfoClassMixinsCmd(
     Tcl_SetObjResult(interp, resultObj);
     return TCL_OK;
 }
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * InfoClassPoolCmd --
+ *
+ *	Implements [info class pool $clsName]
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+InfoClassPoolCmd(
+    ClientData clientData,
+    Tcl_Interp *interp,
+    int objc,
+    Tcl_Obj *const objv[])
+{
+    Class *clsPtr;
+    Tcl_Obj *resultObj;
+
+    if (objc != 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "className");
+	return TCL_ERROR;
+    }
+    clsPtr = GetClassFromObj(interp, objv[1]);
+    if (clsPtr == NULL) {
+	return TCL_ERROR;
+    }
+
+    resultObj = Tcl_NewObj();
+    Tcl_ListObjAppendElement(NULL, resultObj, Tcl_NewStringObj("size", -1));
+    Tcl_ListObjAppendElement(NULL, resultObj,
+	    Tcl_NewIntObj(clsPtr->poolSize));
+    Tcl_ListObjAppendElement(NULL, resultObj, Tcl_NewStringObj("pooled", -1));
+    Tcl_ListObjAppendElement(NULL, resultObj,
+	    Tcl_NewIntObj(clsPtr->pool.num));
+    Tcl_ListObjAppendElement(NULL, resultObj, Tcl_NewStringObj("hits", -1));
+    Tcl_ListObjAppendElement(NULL, resultObj,
+	    Tcl_NewLongObj(clsPtr->poolHits));
+    Tcl_ListObjAppendElement(NULL, resultObj, Tcl_NewStringObj("misses", -1));
+    Tcl_ListObjAppendElement(NULL, resultObj,
+	    Tcl_NewLongObj(clsPtr->poolMisses));
+    Tcl_SetObjResult(interp, resultObj);
+    return TCL_OK;
+}
+
 
 /*
  * ----------------------------------------------------------------------
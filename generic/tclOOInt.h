@@ -97,6 +97,23 @@ typedef struct ProcedureMethod {
     GetFrameInfoValueProc gfivProc;
 				/* Callback to allow for fine tuning of how
 				 * the method reports itself. */
+    int trivialKind;		/* What sort of trivial body the method has,
+				 * if any; one of the TRIVIAL_* values below.
+				 * Such methods can be run without a call
+				 * frame or bytecode. */
+    int trivialArg;		/* Index of the formal argument whose value a
+				 * TRIVIAL_ARG method returns. */
+    int minArgs, maxArgs;	/* How many arguments a trivial method can be
+				 * called with; maxArgs is -1 if there is no
+				 * limit. Other calls use the normal path so
+				 * that the errors are right. */
+    Tcl_Obj *trivialBodyObj;	/* The body that was found to be trivial. If
+				 * the procedure's body is replaced, the
+				 * method is no longer treated as trivial. */
+    const char *trivialCmdName;	/* The command that a trivial body uses
+				 * ("return" or "set"), or NULL if it uses
+				 * none. Only while that resolves to the
+				 * builtin can the body be skipped. */
 } ProcedureMethod;
 
 #define TCLOO_PROCEDURE_METHOD_VERSION 0
@@ -114,6 +131,15 @@ typedef struct ProcedureMethod {
 
 #define USE_DECLARER_NS		0x80
 
+/*
+ * Kinds of trivial procedure method body.
+ */
+
+#define TRIVIAL_NONE	0	/* Body must be executed normally. */
+#define TRIVIAL_EMPTY	1	/* Body is empty or just [return]. */
+#define TRIVIAL_ARG	2	/* Body is [return $arg] or [set arg] for one
+				 * of the method's formal arguments. */
+
 /*
  * Forwarded methods have the following extra information.
  */
@@ -130,6 +156,127 @@ typedef struct ForwardMethod {
 				 * object's namespace. */
 } ForwardMethod;
 
+/*
+ * Property accessor methods have the following extra information.
+ */
+
+typedef struct PropertyMethod {
+    Tcl_Obj *varNameObj;	/* The name of the variable, in the object's
+				 * namespace, that holds the property value. */
+    int flags;			/* Which accesses are permitted; a combination
+				 * of PROPERTY_GET and PROPERTY_SET. */
+    Tcl_Obj *validateObj;	/* Command prefix to call with a new value of
+				 * the property before it is stored, or NULL
+				 * if values are not checked. */
+} PropertyMethod;
+
+#define PROPERTY_GET	1	/* The property may be read. */
+#define PROPERTY_SET	2	/* The property may be written. */
+
+/*
+ * Memoized methods wrap another method implementation, remembering its
+ * results so that it need only be called when the arguments (or the state
+ * that the results depend upon) are new.
+ */
+
+typedef struct MemoMethod {
+    const Tcl_MethodType *innerTypePtr;
+				/* The type of the wrapped method, or NULL once
+				 * the wrapper is no longer in use. */
+    ClientData innerClientData;	/* The wrapped method's own data. */
+    int refCount;		/* Number of references to this structure:
+				 * one from the method while the wrapper is
+				 * installed, one from each cache of results,
+				 * and one from each call in progress. */
+    int numKeys;		/* Number of entries in keyIndices. */
+    int *keyIndices;		/* Indices of the arguments that the results
+				 * depend upon, or NULL if they depend upon
+				 * all of them. */
+    int restIndex;		/* Index of the first argument gathered into
+				 * the formal "args" parameter if that is part
+				 * of the key, or -1 if it is not. */
+    int minArgs, maxArgs;	/* Range of numbers of arguments that the
+				 * wrapped method accepts (maxArgs is -1 if
+				 * there is no limit), when keyIndices is
+				 * non-NULL. */
+    Tcl_Obj *varsObj;		/* List of names of object variables that the
+				 * results depend upon, or NULL if they do not
+				 * depend upon the object at all. */
+    Tcl_HashTable *classCachesPtr;
+				/* The caches of results used by all the
+				 * instances of each class when varsObj is
+				 * NULL, indexed by the class, or NULL if
+				 * there are none yet. */
+} MemoMethod;
+
+/*
+ * The state of reading a counted binary form, as written by [oo::serialize]
+ * and by [oo::share save].
+ */
+
+typedef struct SerialReader {
+    const unsigned char *bytes;	/* The payload being read. */
+    int length;			/* Number of bytes in the payload. */
+    int pos;			/* Offset of the next byte to read. */
+} SerialReader;
+
+/*
+ * The definition of a method as held in a library of classes shared between
+ * interpreters (see tclOOShare.c). It holds only plain string values, so that
+ * nothing in it depends on any interpreter; each interpreter that imports the
+ * library makes its own copies of whatever it needs. A procedure-like method
+ * made from one of these is only turned into a real procedure when first
+ * needed.
+ */
+
+typedef struct SharedMethod {
+    int refCount;		/* Number of references from libraries and
+				 * from methods not yet turned into
+				 * procedures. */
+    int kind;			/* What sort of method this is; one of the
+				 * SHARED_* values below. */
+    int flags;			/* PUBLIC_METHOD, PRIVATE_METHOD and
+				 * USE_DECLARER_NS, as appropriate. */
+    int accessFlags;		/* Permitted accesses of a property. */
+    Tcl_Obj *nameObj;		/* Name of the method, or NULL for a
+				 * constructor or destructor. */
+    Tcl_Obj *argsObj;		/* Formal arguments of a procedure-like
+				 * method. */
+    Tcl_Obj *bodyObj;		/* Body of a procedure-like method, prefix of
+				 * a forward, or validation prefix of a
+				 * property (possibly NULL). */
+} SharedMethod;
+
+#define SHARED_PROC	0	/* A procedure-like method. */
+#define SHARED_FORWARD	1	/* A forwarded method. */
+#define SHARED_PROPERTY	2	/* A property accessor method. */
+#define SHARED_FLAGS	3	/* Just the export status of an inherited
+				 * method. */
+
+/*
+ * A guard on a filter, which decides when the call chain for a method is
+ * built whether the filter is to be applied to calls of that method at all.
+ * Guards are held in a table, indexed by filter name, in the class or object
+ * that declares the filter.
+ */
+
+typedef struct FilterGuard {
+    Tcl_Obj *patternsObj;	/* List of glob patterns, one of which a
+				 * method name must match for the filter to be
+				 * applied, or NULL if all names match. */
+    int calls;			/* What kinds of calls the filter applies to;
+				 * a combination of GUARD_PUBLIC_CALLS and
+				 * GUARD_PRIVATE_CALLS. */
+    Tcl_ObjectFilterGuardProc *guardProc;
+				/* Function that makes the final decision, or
+				 * NULL if there is none. */
+    ClientData clientData;	/* Argument to guardProc. */
+} FilterGuard;
+
+#define GUARD_PUBLIC_CALLS	1	/* Apply filter to public calls. */
+#define GUARD_PRIVATE_CALLS	2	/* Apply filter to private calls. */
+#define GUARD_ALL_CALLS		3
+
 /*
  * Helper definitions that declare a "list" array. The two varieties are
  * either optimized for simplicity (in the case that the whole array is
@@ -168,6 +315,9 @@ typedef struct Object {
 				/* Classes mixed into this object. */
     LIST_STATIC(Tcl_Obj *) filters;
 				/* List of filter names. */
+    Tcl_HashTable *filterGuards;/* Mapping from filter name to FilterGuard*
+				 * for those filters of this object that are
+				 * guarded, or NULL if there are none. */
     struct Class *classPtr;	/* All classes have this non-NULL; it points
 				 * to the class structure. Everything else has
 				 * this NULL. */
@@ -193,6 +343,10 @@ typedef struct Object {
 				/* Function to allow remapping of method
 				 * names. For itcl-ng. */
     LIST_STATIC(Tcl_Obj *) variables;
+    struct ObjectArena *arenaPtr;
+				/* The arena that this object's record was
+				 * allocated from, if it has the ARENA_RECORD
+				 * flag. */
 } Object;
 
 #define OBJECT_DELETED	1	/* Flag to say that an object has been
@@ -216,6 +370,30 @@ typedef struct Object {
 				 * other spots). */
 #define FORCE_UNKNOWN 0x10000	/* States that we are *really* looking up the
 				 * unknown method handler at that point. */
+#define PURE_NAME_MAPPER 0x20000
+				/* Flag set to say that the object's method
+				 * name mapper always maps the same name to the
+				 * same result while the class structure is
+				 * unchanged, so the mapping can be cached. */
+#define FROZEN_CLASS 0x40000	/* Flag (on a class) to say that the class has
+				 * been frozen with [oo::define ... freeze],
+				 * so its definition (and that of everything
+				 * it inherits from, other than the root
+				 * classes) may no longer be changed. */
+#define AUTO_DESTROY 0x80000	/* Flag (on a class) to say that the objects
+				 * made by the class's [new] method are to be
+				 * destroyed once no value refers to them. */
+#define DEFERRED_DELETE 0x100000
+				/* Flag to say that the object's command has
+				 * been deleted but that the rest of its
+				 * destruction (destructor included) is queued
+				 * until the interpreter is next idle. */
+#define POOLED_OBJECT 0x200000	/* Flag to say that the object has been
+				 * destroyed but kept (with its namespace) in
+				 * its class's pool, to be reused by [new]. */
+#define ARENA_RECORD 0x400000	/* Flag to say that the object's record is in
+				 * an arena, and is to be given back to it
+				 * rather than freed. Never set on a class. */
 
 /*
  * And the definition of a class. Note that every class also has an associated
@@ -244,6 +422,9 @@ typedef struct Class {
     LIST_STATIC(Tcl_Obj *) filters;
 				/* List of filter names, used for generation
 				 * of method call chains. */
+    Tcl_HashTable *filterGuards;/* Mapping from filter name to FilterGuard*
+				 * for those filters of this class that are
+				 * guarded, or NULL if there are none. */
     LIST_STATIC(struct Class *) mixins;
 				/* List of mixin classes, used for generation
 				 * of method call chains. */
@@ -275,8 +456,59 @@ typedef struct Class {
 				 * (and filters and method implementations for
 				 * when getting method chains). */
     LIST_STATIC(Tcl_Obj *) variables;
+    Tcl_Obj *warmPatternObj;	/* If non-NULL, the pattern of the names of
+				 * the methods that were precompiled with
+				 * [oo::define ... precompile], and whose call
+				 * chains are to be rebuilt when idle after
+				 * they are invalidated. */
+    LIST_DYNAMIC(Object *) pool;/* Destroyed instances kept for reuse by
+				 * [new], most recently destroyed last. Each
+				 * holds a reference. */
+    int poolSize;		/* Most instances to keep in the pool, or 0 if
+				 * instances are not pooled. */
+    long poolHits;		/* Number of objects [new] made by reusing a
+				 * pooled instance. */
+    long poolMisses;		/* Number of objects [new] made from scratch
+				 * because the pool was empty. */
+    struct ObjectArena *arenaPtr;
+				/* Where the records of the instances of the
+				 * class are allocated, or NULL if they are
+				 * allocated individually. */
 } Class;
 
+#define POOL_DEFAULT_SIZE 64	/* Pool size used by [oo::define ... pool]
+				 * when none is given. */
+
+/*
+ * An arena is where the records of the objects made by one class are
+ * allocated, in blocks of many records each, so that the instances of a class
+ * are close together in memory rather than scattered across the heap. Records
+ * are recycled through a free list, and the blocks are only released (all at
+ * once) when the class and all the records allocated from them have gone.
+ */
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *nextPtr;	/* The next block of the arena. */
+    int numRecords;		/* Number of records in the block. The records
+				 * themselves follow this header. */
+} ArenaBlock;
+
+typedef struct ObjectArena {
+    int refCount;		/* Number of records in use, plus one while a
+				 * class makes its objects in the arena. */
+    int blockSize;		/* Number of records to put in each new
+				 * block. */
+    ArenaBlock *blocksPtr;	/* The blocks of the arena. */
+    Object *freePtr;		/* The first unused record; the first word of
+				 * each unused record points to the next. */
+} ObjectArena;
+
+#define ARENA_DEFAULT_SIZE 256	/* Block size used by [oo::define ... arena]
+				 * when none is given. */
+#define ARENA_MAX_SIZE 65536	/* Largest block size that [oo::define ...
+				 * arena] accepts, which keeps the size of a
+				 * block well inside what ckalloc can take. */
+
 /*
  * The foundation of the object system within an interpreter contains
  * references to the key classes and namespaces, together with a few other
@@ -291,8 +523,41 @@ typedef struct ThreadLocalData {
 				 * because Tcl_Objs can cross interpreter
 				 * boundaries within a thread (objects don't
 				 * generally cross threads). */
+    Tcl_HashTable *sharedLibraries;
+				/* Libraries of classes published with
+				 * [oo::share export], indexed by name, or
+				 * NULL if none have been. Thread-local for
+				 * the same reason as nsCount. */
 } ThreadLocalData;
 
+/*
+ * Counters that describe how well the caching of method call chains is
+ * working. These are purely for tuning; they are reported by [oo::cache
+ * stats].
+ */
+
+typedef struct CacheStats {
+    long stashes;		/* Number of times a call chain was stashed in
+				 * the internal representation of a method
+				 * name. */
+    long shimmers;		/* Number of those stashes that had to throw
+				 * away the internal representation of some
+				 * other type to do so. */
+    long avoided;		/* Number of stashes that were skipped so as
+				 * not to throw away some other type's
+				 * internal representation. */
+    long tableHits;		/* Number of chains found by looking them up
+				 * in the per-object or per-class tables. */
+    long epochs;		/* Number of times the global epoch has been
+				 * advanced. */
+    long rewarms;		/* Number of times the call chains of
+				 * precompiled classes have been rebuilt in
+				 * the background after an epoch advance. */
+    long bodyShares;		/* Number of class methods that reused the
+				 * procedure (and bytecode) of another with
+				 * the same definition. */
+} CacheStats;
+
 typedef struct Foundation {
     Tcl_Interp *interp;
     Class *objectCls;		/* The root of the object system. */
@@ -311,6 +576,9 @@ typedef struct Foundation {
 				 * procedural method. */
     int epoch;			/* Used to invalidate method chains when the
 				 * class structure changes. */
+    int frozenEpoch;		/* Used to invalidate the method chains of
+				 * the pure instances of frozen classes, which
+				 * can only change when a root class does. */
     ThreadLocalData *tsdPtr;	/* Counter so we can allocate a unique
 				 * namespace to each object. */
     Tcl_Obj *unknownMethodNameObj;
@@ -323,8 +591,72 @@ typedef struct Foundation {
     Tcl_Obj *clonedName;	/* Shared object containing the name of a
 				 * "<cloned>" pseudo-constructor. */
     Tcl_Obj *defineName;	/* Fully qualified name of oo::define. */
+    Tcl_Obj *slotGetName;	/* Shared object containing the name of the
+				 * reading method of slots. */
+    Tcl_Obj *slotSetName;	/* Shared object containing the name of the
+				 * writing method of slots. */
+    Tcl_Obj *slotDefOpName;	/* Shared object containing the name of the
+				 * default operation method of slots. */
+    int defineDepth;		/* How many definition batches (usually
+				 * [oo::define] scripts) are in progress. While
+				 * non-zero, advances of the global epoch are
+				 * deferred. */
+    int epochPending;		/* Whether an advance of the global epoch has
+				 * been deferred. */
+    int cacheFlags;		/* Policy for caching of call chains. */
+    CacheStats cacheStats;	/* How well that caching is working. */
+    Tcl_HashTable procTable;	/* The procedures of procedure-like class
+				 * methods, indexed by what they were made
+				 * from, so that methods with the same
+				 * definition can share one procedure and its
+				 * bytecode. Each holds a reference. */
+    int procSweepSize;		/* Size of procTable at which to next release
+				 * the procedures no method uses any more. */
+    Tcl_HashTable autoTable;	/* Objects that are to be destroyed once no
+				 * value refers to them, mapped to their
+				 * handles (the names that [new] returned).
+				 * A reference is held to both. */
+    int collectPending;		/* Whether a look for objects to destroy has
+				 * been scheduled for when the interpreter is
+				 * next idle. */
+    CompileProc *returnCompileProc;
+    CompileProc *setCompileProc;
+				/* The compilers of the builtin [return] and
+				 * [set]. A command with some other compiler
+				 * (or none) is not the builtin, so trivial
+				 * method bodies do not use it. */
+    LIST_DYNAMIC(Object *) deferred;
+				/* Objects whose destruction has been
+				 * deferred, in the order that it was asked
+				 * for. Each holds a reference. */
+    int deferredHead;		/* Index of the first object in deferred that
+				 * has yet to be finished off. */
+    int deferPending;		/* Whether finishing off the deferred objects
+				 * has been scheduled for when the interpreter
+				 * is next idle. */
 } Foundation;
 
+#define PROC_SWEEP_MIN	64	/* Smallest procTable size at which to look
+				 * for procedures to release. */
+#define DEFER_BATCH_SIZE 100	/* Most deferred objects to finish off each
+				 * time the interpreter is idle. */
+
+/*
+ * Flags for Foundation.cacheFlags.
+ *
+ * CACHE_NO_SHIMMER - never evict another type's internal representation of
+ *		a method name to stash a call chain there; rely on the
+ *		per-object and per-class chain tables instead. Useful when
+ *		the same literal is also used as (say) a list or a command.
+ * CACHE_REWARM - after the global epoch advances, rebuild the call chains of
+ *		precompiled classes when the interpreter is next idle.
+ * CACHE_REWARM_PENDING - such a rebuild has been scheduled.
+ */
+
+#define CACHE_NO_SHIMMER	1
+#define CACHE_REWARM		2
+#define CACHE_REWARM_PENDING	4
+
 /*
  * A call context structure is built when a method is called. They contain the
  * chain of method implementations that are to be invoked by a particular
@@ -357,6 +689,10 @@ typedef struct CallChain {
 				 * staticChain if the number of entries is
 				 * small. */
     struct MInvoke staticChain[CALL_CHAIN_STATIC_SIZE];
+    Tcl_HashTable *classIndex;	/* Map from declaring class to the index of
+				 * its non-filter entry in the chain, built on
+				 * first demand for chains too long to just
+				 * search. NULL if not (yet) built. */
 } CallChain;
 
 typedef struct CallContext {
@@ -380,6 +716,28 @@ typedef struct CallContext {
 #define OO_UNKNOWN_METHOD 0x04	/* This is an unknown method. */
 #define CONSTRUCTOR	  0x08	/* This is a constructor. */
 #define DESTRUCTOR	  0x10	/* This is a destructor. */
+#define TRIVIAL_CHAIN	  0x20	/* The chain consists of exactly one method
+				 * implementation, with no filters and no
+				 * unknown handling, so it can be invoked
+				 * directly. Only set on method chains. */
+#define FILTER_GUARDED	  0x40	/* Whether some filter is in the chain depends
+				 * on more than the method name, so the chain
+				 * may only be reused for calls with exactly
+				 * the same flags. */
+#define PERMANENT_CHAIN	  0x80	/* The chain is for the pure instances of a
+				 * frozen class, so it is checked against the
+				 * frozen epoch rather than the global epoch.
+				 * Only set on method chains. */
+
+/*
+ * Flags for TclOOInvokeMany. With neither of the error flags, the invocation
+ * stops at the first failing call.
+ */
+
+#define INVOKE_COLLECT_ERRORS	0x01	/* Record failures and carry on. */
+#define INVOKE_IGNORE_ERRORS	0x02	/* Discard failures and carry on. */
+#define INVOKE_GROUP_BY_CLASS	0x04	/* Call the objects grouped by class
+					 * rather than in the order given. */
 
 /*
  * Assorted flags for call frames. Note that bits 1 and 2 are already taken by
@@ -417,6 +775,12 @@ MODULE_SCOPE int	TclOODefineObjCmd(ClientData clientData,
 MODULE_SCOPE int	TclOOObjDefObjCmd(ClientData clientData,
 			    Tcl_Interp *interp, int objc,
 			    Tcl_Obj *const *objv);
+MODULE_SCOPE int	TclOODefineArenaObjCmd(ClientData clientData,
+			    Tcl_Interp *interp, int objc,
+			    Tcl_Obj *const *objv);
+MODULE_SCOPE int	TclOODefineAutoDestroyObjCmd(ClientData clientData,
+			    Tcl_Interp *interp, int objc,
+			    Tcl_Obj *const *objv);
 MODULE_SCOPE int	TclOODefineConstructorObjCmd(ClientData clientData,
 			    Tcl_Interp *interp, int objc,
 			    Tcl_Obj *const *objv);
@@ -429,9 +793,18 @@ MODULE_SCOPE int	TclOODefineDestructorObjCmd(ClientData clientData,
 MODULE_SCOPE int	TclOODefineExportObjCmd(ClientData clientData,
 			    Tcl_Interp *interp, int objc,
 			    Tcl_Obj *const *objv);
+MODULE_SCOPE int	TclOODefineFilterGuardObjCmd(ClientData clientData,
+			    Tcl_Interp *interp, int objc,
+			    Tcl_Obj *const *objv);
 MODULE_SCOPE int	TclOODefineForwardObjCmd(ClientData clientData,
 			    Tcl_Interp *interp, int objc,
 			    Tcl_Obj *const *objv);
+MODULE_SCOPE int	TclOODefineFreezeObjCmd(ClientData clientData,
+			    Tcl_Interp *interp, int objc,
+			    Tcl_Obj *const *objv);
+MODULE_SCOPE int	TclOODefineMemoizeObjCmd(ClientData clientData,
+			    Tcl_Interp *interp, int objc,
+			    Tcl_Obj *const *objv);
 MODULE_SCOPE int	TclOODefineMethodObjCmd(ClientData clientData,
 			    Tcl_Interp *interp, int objc,
 			    Tcl_Obj *const *objv);
@@ -447,12 +820,36 @@ MODULE_SCOPE int	TclOODefineClassObjCmd(ClientData clientData,
 MODULE_SCOPE int	TclOODefineSelfObjCmd(ClientData clientData,
 			    Tcl_Interp *interp, int objc,
 			    Tcl_Obj *const *objv);
+MODULE_SCOPE int	TclOODefinePoolObjCmd(ClientData clientData,
+			    Tcl_Interp *interp, int objc,
+			    Tcl_Obj *const *objv);
+MODULE_SCOPE int	TclOODefinePrecompileObjCmd(ClientData clientData,
+			    Tcl_Interp *interp, int objc,
+			    Tcl_Obj *const *objv);
+MODULE_SCOPE int	TclOODefinePropertyObjCmd(ClientData clientData,
+			    Tcl_Interp *interp, int objc,
+			    Tcl_Obj *const *objv);
 MODULE_SCOPE int	TclOOUnknownDefinition(ClientData clientData,
 			    Tcl_Interp *interp, int objc,
 			    Tcl_Obj *const *objv);
+MODULE_SCOPE int	TclOOBroadcastObjCmd(ClientData clientData,
+			    Tcl_Interp *interp, int objc,
+			    Tcl_Obj *const *objv);
+MODULE_SCOPE int	TclOOCacheObjCmd(ClientData clientData,
+			    Tcl_Interp *interp, int objc,
+			    Tcl_Obj *const *objv);
+MODULE_SCOPE int	TclOOCollectObjCmd(ClientData clientData,
+			    Tcl_Interp *interp, int objc,
+			    Tcl_Obj *const *objv);
 MODULE_SCOPE int	TclOOCopyObjectCmd(ClientData clientData,
 			    Tcl_Interp *interp, int objc,
 			    Tcl_Obj *const *objv);
+MODULE_SCOPE int	TclOODeserializeObjCmd(ClientData clientData,
+			    Tcl_Interp *interp, int objc,
+			    Tcl_Obj *const *objv);
+MODULE_SCOPE int	TclOOForeachInstanceObjCmd(ClientData clientData,
+			    Tcl_Interp *interp, int objc,
+			    Tcl_Obj *const *objv);
 MODULE_SCOPE int	TclOONextObjCmd(ClientData clientData,
 			    Tcl_Interp *interp, int objc,
 			    Tcl_Obj *const *objv);
@@ -462,6 +859,26 @@ MODULE_SCOPE int	TclOONextToObjCmd(ClientData clientData,
 MODULE_SCOPE int	TclOOSelfObjCmd(ClientData clientData,
 			    Tcl_Interp *interp, int objc,
 			    Tcl_Obj *const *objv);
+MODULE_SCOPE int	TclOOSerialGetCount(SerialReader *rPtr,
+			    unsigned int *countPtr);
+MODULE_SCOPE Tcl_Obj *	TclOOSerialGetString(SerialReader *rPtr);
+MODULE_SCOPE int	TclOOSerialGetWord(SerialReader *rPtr,
+			    unsigned int *valuePtr);
+MODULE_SCOPE void	TclOOSerialPatchWord(Tcl_DString *dsPtr, int pos,
+			    unsigned int value);
+MODULE_SCOPE void	TclOOSerialPutString(Tcl_DString *dsPtr,
+			    Tcl_Obj *objPtr);
+MODULE_SCOPE void	TclOOSerialPutWord(Tcl_DString *dsPtr,
+			    unsigned int value);
+MODULE_SCOPE int	TclOOSerializeObjCmd(ClientData clientData,
+			    Tcl_Interp *interp, int objc,
+			    Tcl_Obj *const *objv);
+MODULE_SCOPE int	TclOOShareObjCmd(ClientData clientData,
+			    Tcl_Interp *interp, int objc,
+			    Tcl_Obj *const *objv);
+MODULE_SCOPE int	TclOOTemplateObjCmd(ClientData clientData,
+			    Tcl_Interp *interp, int objc,
+			    Tcl_Obj *const *objv);
 
 /*
  * Method implementations (in tclOOBasic.c).
@@ -503,16 +920,33 @@ MODULE_SCOPE int	TclOO_Object_VarName(ClientData clientData,
 MODULE_SCOPE void	TclOOAddToInstances(Object *oPtr, Class *clsPtr);
 MODULE_SCOPE void	TclOOAddToMixinSubs(Class *subPtr, Class *mixinPtr);
 MODULE_SCOPE void	TclOOAddToSubclasses(Class *subPtr, Class *superPtr);
+MODULE_SCOPE Object *	TclOOArenaAlloc(ObjectArena *arenaPtr);
+MODULE_SCOPE void	TclOOArenaFree(Object *oPtr);
 MODULE_SCOPE int	TclOODefineSlots(Foundation *fPtr);
+MODULE_SCOPE void	TclOOCancelRewarm(Foundation *fPtr);
+MODULE_SCOPE int	TclOOCheckNotFrozen(Tcl_Interp *interp, Class *clsPtr);
+MODULE_SCOPE int	TclOOCollectObjects(Foundation *fPtr, int all);
+MODULE_SCOPE Tcl_HashTable *TclOOCopyFilterGuards(Tcl_HashTable *guardsPtr);
 MODULE_SCOPE void	TclOODeleteChain(CallChain *callPtr);
 MODULE_SCOPE void	TclOODeleteChainCache(Tcl_HashTable *tablePtr);
 MODULE_SCOPE void	TclOODeleteContext(CallContext *contextPtr);
+MODULE_SCOPE void	TclOODeleteFilterGuards(Tcl_HashTable *guardsPtr);
 MODULE_SCOPE void	TclOODelMethodRef(Method *method);
+MODULE_SCOPE SharedMethod *TclOODescribeMethod(Method *mPtr);
+MODULE_SCOPE CallChain *TclOOGetCachedCallChain(Object *oPtr,
+			    Tcl_Obj *methodNameObj, int flags);
 MODULE_SCOPE CallContext *TclOOGetCallContext(Object *oPtr,
 			    Tcl_Obj *methodNameObj, int flags);
 MODULE_SCOPE CallChain *TclOOGetStereotypeCallChain(Class *clsPtr,
 			    Tcl_Obj *methodNameObj, int flags);
+MODULE_SCOPE int	TclOOGetChainIndex(CallChain *callPtr,
+			    Class *clsPtr);
+MODULE_SCOPE Class *	TclOOGetClassFromObj(Tcl_Interp *interp,
+			    Tcl_Obj *objPtr);
 MODULE_SCOPE Foundation	*TclOOGetFoundation(Tcl_Interp *interp);
+MODULE_SCOPE int	TclOOGetMappedMethodName(Object *oPtr,
+			    Tcl_Obj *methodNameObj, Tcl_Obj **mappedNamePtr,
+			    Class **startClsPtr);
 MODULE_SCOPE Tcl_Obj *	TclOOGetFwdFromMethod(Method *mPtr);
 MODULE_SCOPE Proc *	TclOOGetProcFromMethod(Method *mPtr);
 MODULE_SCOPE Tcl_Obj *	TclOOGetMethodBody(Method *mPtr);
@@ -521,12 +955,30 @@ MODULE_SCOPE int	TclOOGetSortedClassMethodList(Class *clsPtr,
 MODULE_SCOPE int	TclOOGetSortedMethodList(Object *oPtr, int flags,
 			    const char ***stringsPtr);
 MODULE_SCOPE void	TclOOInitInfo(Tcl_Interp *interp);
+MODULE_SCOPE void	TclOOInitSharedProcs(Foundation *fPtr);
 MODULE_SCOPE int	TclOOInvokeContext(Tcl_Interp *interp,
 			    CallContext *contextPtr, int objc,
 			    Tcl_Obj *const *objv);
+MODULE_SCOPE int	TclOOInvokeTrivialChain(Tcl_Interp *interp,
+			    Object *oPtr, CallChain *callPtr, int objc,
+			    Tcl_Obj *const *objv);
+MODULE_SCOPE int	TclOOMemoizeMethod(Tcl_Interp *interp, Method *mPtr,
+			    Tcl_Obj *keysObj, Tcl_Obj *varsObj);
+MODULE_SCOPE ObjectArena *TclOONewArena(int blockSize);
 MODULE_SCOPE void	TclOONewBasicMethod(Tcl_Interp *interp, Class *clsPtr,
 			    const DeclaredClassMethod *dcm);
+MODULE_SCOPE Method *	TclOONewPropertyMethod(Tcl_Interp *interp,
+			    Object *oPtr, Class *clsPtr, int flags,
+			    Tcl_Obj *nameObj, int accessFlags,
+			    Tcl_Obj *validateObj);
+MODULE_SCOPE Method *	TclOONewSharedMethod(Tcl_Interp *interp,
+			    Object *oPtr, Class *clsPtr,
+			    SharedMethod *smPtr);
 MODULE_SCOPE Tcl_Obj *	TclOOObjectName(Tcl_Interp *interp, Object *oPtr);
+MODULE_SCOPE int	TclOOParkObject(Tcl_Interp *interp, Object *oPtr);
+MODULE_SCOPE void	TclOOReleaseArena(ObjectArena *arenaPtr);
+MODULE_SCOPE void	TclOOReleaseSharedMethod(SharedMethod *smPtr);
+MODULE_SCOPE void	TclOOReleaseSharedProcs(Foundation *fPtr, int all);
 MODULE_SCOPE void	TclOORemoveFromInstances(Object *oPtr, Class *clsPtr);
 MODULE_SCOPE void	TclOORemoveFromMixinSubs(Class *subPtr,
 			    Class *mixinPtr);
@@ -534,9 +986,17 @@ MODULE_SCOPE void	TclOORemoveFromSubclasses(Class *subPtr,
 			    Class *superPtr);
 MODULE_SCOPE Tcl_Obj *	TclOORenderCallChain(Tcl_Interp *interp,
 			    CallChain *callPtr);
+MODULE_SCOPE void	TclOOScheduleRewarm(Foundation *fPtr);
+MODULE_SCOPE void	TclOOStashMappedMethodName(Object *oPtr,
+			    Tcl_Obj *methodNameObj, Tcl_Obj *mappedNameObj,
+			    Class *startCls);
 MODULE_SCOPE void	TclOOStashContext(Tcl_Obj *objPtr,
 			    CallContext *contextPtr);
 MODULE_SCOPE void	TclOOSetupVariableResolver(Tcl_Namespace *nsPtr);
+MODULE_SCOPE void	TclOOTrimPool(Tcl_Interp *interp, Class *clsPtr,
+			    int keep);
+MODULE_SCOPE void	TclOOWarmClassChains(Class *clsPtr,
+			    const char *pattern);
 
 /*
  * Include all the private API, generated from tclOO.decls.
@@ -575,6 +1035,18 @@ MODULE_SCOPE void	TclOOSetupVariableResolver(Tcl_Namespace *nsPtr);
     for(hPtr=Tcl_FirstHashEntry((tablePtr),&search); hPtr!=NULL ? \
 	    ((val)=Tcl_GetHashValue(hPtr),1):0;hPtr=Tcl_NextHashEntry(&search))
 
+/*
+ * Helper macros (derived from things private to tclVar.c) for looking at the
+ * variables of a namespace directly.
+ */
+
+#define TclVarTable(contextNs) \
+    ((Tcl_HashTable *) (&((Namespace *) (contextNs))->varTable))
+#define TclVarHashGetValue(hPtr) \
+    ((Tcl_Var) ((char *)hPtr - TclOffset(VarInHash, entry)))
+#define TclVarHashGetKey(hPtr) \
+    ((hPtr)->key.objPtr)
+
 /*
  * Convenience macro for duplicating a list. Needs no external declaration,
  * but all arguments are used multiple times and so must have no side effects.
@@ -591,13 +1063,62 @@ MODULE_SCOPE void	TclOOSetupVariableResolver(Tcl_Namespace *nsPtr);
     } while(0)
 
 /*
- * Alternatives to Tcl_Preserve/Tcl_EventuallyFree/Tcl_Release.
+ * Advancing the global epoch. While a batch of definitions is being made
+ * (see TclOOBeginDefinitions) the advance is only noted, and is applied
+ * either at the end of the batch or when a call chain is next looked up,
+ * whichever comes first; that way, lots of changes coalesce into one.
+ */
+
+#define TclOOBumpEpoch(fPtr) do {		\
+	if ((fPtr)->defineDepth > 0) {		\
+	    (fPtr)->epochPending = 1;		\
+	} else {				\
+	    (fPtr)->epoch++;			\
+	    (fPtr)->cacheStats.epochs++;	\
+	    if ((fPtr)->cacheFlags & CACHE_REWARM) {	\
+		TclOOScheduleRewarm(fPtr);	\
+	    }					\
+	}					\
+    } while(0)
+#define TclOOSyncEpoch(fPtr) do {		\
+	if ((fPtr)->epochPending) {		\
+	    (fPtr)->epochPending = 0;		\
+	    (fPtr)->epoch++;			\
+	    (fPtr)->cacheStats.epochs++;	\
+	    if ((fPtr)->cacheFlags & CACHE_REWARM) {	\
+		TclOOScheduleRewarm(fPtr);	\
+	    }					\
+	}					\
+    } while(0)
+
+/*
+ * Advancing the frozen epoch. A frozen class only inherits from other frozen
+ * classes and from the root classes, so a change to the structure of any
+ * other class cannot affect the call chains of its pure instances. Frozen
+ * classes can still be changed through some parts of the C API (e.g.,
+ * Tcl_ClassSetFilterGuard), and such changes count too.
+ */
+
+#define TclOOBumpFrozenEpoch(fPtr, clsPtr) do {		\
+	if ((clsPtr) == NULL || ((clsPtr)->flags			\
+		& (ROOT_OBJECT|ROOT_CLASS|FROZEN_CLASS))) {	\
+	    (fPtr)->frozenEpoch++;				\
+	}							\
+    } while(0)
+
+/*
+ * Alternatives to Tcl_Preserve/Tcl_EventuallyFree/Tcl_Release. Object
+ * records that were allocated from an arena are given back to it.
  */
 
 #define AddRef(ptr) ((ptr)->refCount++)
 #define DelRef(ptr) do {			\
 	if (--(ptr)->refCount < 1) {		\
-	    ckfree((char *) (ptr));		\
+	    if ((ptr)->flags & ARENA_RECORD) {	\
+		TclOOArenaFree((Object *) (ptr));	\
+	    } else {				\
+		ckfree((char *) (ptr));		\
+	    }					\
 	}					\
     } while(0)
 
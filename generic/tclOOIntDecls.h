@@ -132,6 +132,30 @@ EXTERN void		TclOOClassSetMixins(Tcl_Interp *interp,
 				Class *classPtr, int numMixins,
 				Class *const *mixins);
 #endif
+#ifndef TclOOBeginDefinitions_TCL_DECLARED
+#define TclOOBeginDefinitions_TCL_DECLARED
+/* 16 */
+EXTERN void		TclOOBeginDefinitions(Tcl_Interp *interp);
+#endif
+#ifndef TclOOCommitDefinitions_TCL_DECLARED
+#define TclOOCommitDefinitions_TCL_DECLARED
+/* 17 */
+EXTERN void		TclOOCommitDefinitions(Tcl_Interp *interp);
+#endif
+#ifndef TclOOPrecompileClass_TCL_DECLARED
+#define TclOOPrecompileClass_TCL_DECLARED
+/* 18 */
+EXTERN int		TclOOPrecompileClass(Tcl_Interp *interp,
+				Class *clsPtr, const char *pattern);
+#endif
+#ifndef TclOOInvokeMany_TCL_DECLARED
+#define TclOOInvokeMany_TCL_DECLARED
+/* 19 */
+EXTERN int		TclOOInvokeMany(Tcl_Interp *interp, int numObjects,
+				Tcl_Object *const *objects, int flags,
+				int objc, Tcl_Obj *const *objv,
+				Tcl_Obj *errorsObj);
+#endif
 
 typedef struct TclOOIntStubs {
     int magic;
@@ -153,6 +177,10 @@ typedef struct TclOOIntStubs {
     void (*tclOOClassSetFilters) (Tcl_Interp *interp, Class *classPtr, int numFilters, Tcl_Obj *const *filters); /* 13 */
     void (*tclOOObjectSetMixins) (Object *oPtr, int numMixins, Class *const *mixins); /* 14 */
     void (*tclOOClassSetMixins) (Tcl_Interp *interp, Class *classPtr, int numMixins, Class *const *mixins); /* 15 */
+    void (*tclOOBeginDefinitions) (Tcl_Interp *interp); /* 16 */
+    void (*tclOOCommitDefinitions) (Tcl_Interp *interp); /* 17 */
+    int (*tclOOPrecompileClass) (Tcl_Interp *interp, Class *clsPtr, const char *pattern); /* 18 */
+    int (*tclOOInvokeMany) (Tcl_Interp *interp, int numObjects, Tcl_Object *const *objects, int flags, int objc, Tcl_Obj *const *objv, Tcl_Obj *errorsObj); /* 19 */
 } TclOOIntStubs;
 
 #if defined(USE_TCLOO_STUBS) && !defined(USE_TCLOO_STUB_PROCS)
@@ -229,6 +257,22 @@ extern const TclOOIntStubs *tclOOIntStubsPtr;
 #define TclOOClassSetMixins \
 	(tclOOIntStubsPtr->tclOOClassSetMixins) /* 15 */
 #endif
+#ifndef TclOOBeginDefinitions
+#define TclOOBeginDefinitions \
+	(tclOOIntStubsPtr->tclOOBeginDefinitions) /* 16 */
+#endif
+#ifndef TclOOCommitDefinitions
+#define TclOOCommitDefinitions \
+	(tclOOIntStubsPtr->tclOOCommitDefinitions) /* 17 */
+#endif
+#ifndef TclOOPrecompileClass
+#define TclOOPrecompileClass \
+	(tclOOIntStubsPtr->tclOOPrecompileClass) /* 18 */
+#endif
+#ifndef TclOOInvokeMany
+#define TclOOInvokeMany \
+	(tclOOIntStubsPtr->tclOOInvokeMany) /* 19 */
+#endif
 
 #endif /* defined(USE_TCLOO_STUBS) && !defined(USE_TCLOO_STUB_PROCS) */
 
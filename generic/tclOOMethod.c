@@ -58,6 +58,68 @@ typedef struct {
 				 * variables be cached? */
 } OOResVarInfo;
 
+/*
+ * The results of a memoized method, held either by the method itself for
+ * each class (when the results do not depend on the object) or in a table
+ * attached to each object as metadata, indexed by the MemoMethod. The
+ * results are per class because the method may reach other methods through
+ * [my], which subclasses can override.
+ */
+
+typedef struct MemoCache {
+    MemoMethod *memoPtr;	/* The method whose results these are. */
+    Object *oPtr;		/* The object that the results are for, or
+				 * NULL if they are for all instances of a
+				 * class. */
+    int classEpoch;		/* Creation epoch of that class, so that a
+				 * later class at the same address is not
+				 * taken for it. */
+    Tcl_HashTable results;	/* Map from key (Tcl_Obj) to result. */
+    int epoch;			/* Global epoch when results were gathered. */
+    int objectEpoch;		/* Object's epoch when results were
+				 * gathered. */
+    int generation;		/* Incremented each time the results are
+				 * thrown away. */
+    Tcl_Obj *tracedNamesObj;	/* List of the fully-qualified names of the
+				 * variables traced to invalidate the results,
+				 * or NULL if they are not being traced. */
+} MemoCache;
+
+#define MEMO_CACHE_SIZE	256	/* Largest number of results remembered for
+				 * a method (per object, if the results depend
+				 * on the object); when full, the cache is
+				 * emptied. */
+
+/*
+ * A procedure-like method that was made from a method in a shared class
+ * library, and which has not yet been called or looked at. The procedure for
+ * it is only created (and its body compiled) when it is first needed, at
+ * which point the method is turned into an ordinary procedure-like method.
+ */
+
+typedef struct LazyProcMethod {
+    Tcl_Interp *interp;		/* Interpreter that the method belongs to. */
+    SharedMethod *smPtr;	/* The shared description of the method. */
+} LazyProcMethod;
+
+/*
+ * The key of a procedure in the table of procedures shared between class
+ * methods. The key only refers to its parts, and an entry refers to the body
+ * of the procedure it maps to, so no text is copied into the table.
+ */
+
+typedef struct SharedProcKey {
+    int flags;			/* USE_DECLARER_NS if the body runs in the
+				 * declarer's namespace, else 0. */
+    int line;			/* Line where the body starts, or -1 if its
+				 * location is not known. */
+    Tcl_Obj *pathObj;		/* File the body came from, or NULL if its
+				 * location is not known. */
+    Tcl_Obj *argsObj;		/* The formal argument list. */
+    Tcl_Obj *bodyObj;		/* The body. In the table, this is the body of
+				 * the procedure itself. */
+} SharedProcKey;
+
 /*
  * Function declarations for things defined in this file.
  */
@@ -66,13 +128,23 @@ static Tcl_Obj **	InitEnsembleRewrite(Tcl_Interp *interp, int objc,
 			    Tcl_Obj *const *objv, int toRewrite,
 			    int rewriteLength, Tcl_Obj *const *rewriteObjs,
 			    int *lengthPtr);
+static void		AnalyzeTrivialBody(ProcedureMethod *pmPtr);
 static int		InvokeProcedureMethod(ClientData clientData,
 			    Tcl_Interp *interp, Tcl_ObjectContext context,
 			    int objc, Tcl_Obj *const *objv);
+static int		InvokeTrivialBody(ProcedureMethod *pmPtr,
+			    Tcl_Interp *interp, Tcl_ObjectContext context,
+			    int objc, Tcl_Obj *const *objv);
+static int		UsesBuiltinCommand(Tcl_Interp *interp,
+			    CallContext *contextPtr, ProcedureMethod *pmPtr);
 static int		PushMethodCallFrame(Tcl_Interp *interp,
 			    CallContext *contextPtr, ProcedureMethod *pmPtr,
 			    int objc, Tcl_Obj *const *objv,
 			    PMFrameData *fdPtr);
+static int		PrecompileClass(Tcl_Interp *interp, Class *clsPtr,
+			    const char *pattern, Tcl_HashTable *doneTablePtr);
+static int		PrecompileMethod(Tcl_Interp *interp, Method *mPtr,
+			    Tcl_Namespace *nsPtr, const char *namePtr);
 static void		DeleteProcedureMethodRecord(ProcedureMethod *pmPtr);
 static void		DeleteProcedureMethod(ClientData clientData);
 static int		CloneProcedureMethod(Tcl_Interp *interp,
@@ -90,6 +162,61 @@ static int		InvokeForwardMethod(ClientData clientData,
 static void		DeleteForwardMethod(ClientData clientData);
 static int		CloneForwardMethod(Tcl_Interp *interp,
 			    ClientData clientData, ClientData *newClientData);
+static int		InvokePropertyMethod(ClientData clientData,
+			    Tcl_Interp *interp, Tcl_ObjectContext context,
+			    int objc, Tcl_Obj *const *objv);
+static void		DeletePropertyMethod(ClientData clientData);
+static int		ClonePropertyMethod(Tcl_Interp *interp,
+			    ClientData clientData, ClientData *newClientData);
+static Var *		GetPropertyVar(Object *oPtr, Tcl_Obj *varNameObj);
+static inline const Tcl_MethodType *UnwrapMethod(Method *mPtr,
+			    ClientData *clientDataPtr);
+static Tcl_Obj *	PropertyVarName(Object *oPtr, Tcl_Obj *varNameObj);
+static int		InvokeMemoizedMethod(ClientData clientData,
+			    Tcl_Interp *interp, Tcl_ObjectContext context,
+			    int objc, Tcl_Obj *const *objv);
+static void		DeleteMemoizedMethod(ClientData clientData);
+static int		CloneMemoizedMethod(Tcl_Interp *interp,
+			    ClientData clientData, ClientData *newClientData);
+static Tcl_Obj *	MemoKey(MemoMethod *memoPtr, int objc,
+			    Tcl_Obj *const *objv);
+static MemoCache *	GetMemoCache(MemoMethod *memoPtr, Object *oPtr);
+static void		ClearMemoCache(MemoCache *cachePtr);
+static void		DeleteMemoCache(MemoCache *cachePtr);
+static void		ReleaseMemo(MemoMethod *memoPtr);
+static void		UntraceMemoVars(MemoCache *cachePtr);
+static char *		MemoVarTraceProc(ClientData clientData,
+			    Tcl_Interp *interp, const char *name1,
+			    const char *name2, int flags);
+static void		DeleteMemoMetadata(ClientData clientData);
+static int		CloneMemoMetadata(Tcl_Interp *interp,
+			    ClientData oldClientData,
+			    ClientData *newClientData);
+static int		InvokeLazyMethod(ClientData clientData,
+			    Tcl_Interp *interp, Tcl_ObjectContext context,
+			    int objc, Tcl_Obj *const *objv);
+static void		DeleteLazyMethod(ClientData clientData);
+static int		CloneLazyMethod(Tcl_Interp *interp,
+			    ClientData clientData, ClientData *newClientData);
+static int		MaterializeLazyMethod(Tcl_Interp *interp,
+			    Method *mPtr);
+static CmdFrame *	MethodBodyLocation(Interp *iPtr);
+static void		RecordMethodBodyLocation(Interp *iPtr,
+			    Proc *procPtr, CmdFrame *cfPtr);
+static void		FreeMethodBodyLocation(CmdFrame *cfPtr);
+static unsigned int	HashSharedProcKey(Tcl_HashTable *tablePtr,
+			    void *keyPtr);
+static int		CompareSharedProcKeys(void *keyPtr,
+			    Tcl_HashEntry *hPtr);
+static Tcl_HashEntry *	AllocSharedProcEntry(Tcl_HashTable *tablePtr,
+			    void *keyPtr);
+static void		FreeSharedProcEntry(Tcl_HashEntry *hPtr);
+static inline int	SameString(Tcl_Obj *obj1Ptr, Tcl_Obj *obj2Ptr);
+static int		GetSharedProc(Tcl_Interp *interp, int flags,
+			    const char *procName, Tcl_Obj *argsObj,
+			    Tcl_Obj *bodyObj, CmdFrame *cfPtr,
+			    Proc **procPtrPtr);
+static inline Tcl_Obj *	CopyOfString(Tcl_Obj *objPtr);
 static int		ProcedureMethodVarResolver(Tcl_Interp *interp,
 			    const char *varName, Tcl_Namespace *contextNs,
 			    int flags, Tcl_Var *varPtr);
@@ -98,6 +225,14 @@ static int		ProcedureMethodCompiledVarResolver(Tcl_Interp *interp,
 			    Tcl_Namespace *contextNs,
 			    Tcl_ResolvedVarInfo **rPtrPtr);
 
+/*
+ * The type of compiled procedure bodies. Should be a reference to
+ * tclByteCodeType, but that's MODULE_SCOPE so we remember it when we first
+ * see it instead. HACK!
+ */
+
+static Tcl_ObjType *byteCodeTypePtr = NULL;
+
 /*
  * The types of methods defined by the core OO system.
  */
@@ -110,15 +245,34 @@ static const Tcl_MethodType fwdMethodType = {
     TCL_OO_METHOD_VERSION_CURRENT, "forward",
     InvokeForwardMethod, DeleteForwardMethod, CloneForwardMethod
 };
+static const Tcl_MethodType propMethodType = {
+    TCL_OO_METHOD_VERSION_CURRENT, "property",
+    InvokePropertyMethod, DeletePropertyMethod, ClonePropertyMethod
+};
+static const Tcl_MethodType memoMethodType = {
+    TCL_OO_METHOD_VERSION_CURRENT, "memoized",
+    InvokeMemoizedMethod, DeleteMemoizedMethod, CloneMemoizedMethod
+};
+
+static const Tcl_MethodType lazyMethodType = {
+    TCL_OO_METHOD_VERSION_CURRENT, "method",
+    InvokeLazyMethod, DeleteLazyMethod, CloneLazyMethod
+};
+
+static const Tcl_ObjectMetadataType memoMetadataType = {
+    TCL_OO_METADATA_VERSION_CURRENT, "TclOO memoized results",
+    DeleteMemoMetadata, CloneMemoMetadata
+};
 
 /*
- * Helper macros (derived from things private to tclVar.c)
+ * How the table of shared procedures is keyed.
  */
 
-#define TclVarTable(contextNs) \
-    ((Tcl_HashTable *) (&((Namespace *) (contextNs))->varTable))
-#define TclVarHashGetValue(hPtr) \
-    ((Tcl_Var) ((char *)hPtr - TclOffset(VarInHash, entry)))
+static const Tcl_HashKeyType sharedProcKeyType = {
+    TCL_HASH_KEY_TYPE_VERSION, 0,
+    HashSharedProcKey, CompareSharedProcKeys,
+    AllocSharedProcEntry, FreeSharedProcEntry
+};
 
 /*
  * ----------------------------------------------------------------------
@@ -219,6 +373,9 @@ Tcl_NewMethod(
     Tcl_HashEntry *hPtr;
     int isNew;
 
+    if (TclOOCheckNotFrozen(interp, clsPtr) != TCL_OK) {
+	return NULL;
+    }
     if (nameObj == NULL) {
 	mPtr = (Method *) ckalloc(sizeof(Method));
 	mPtr->namePtr = NULL;
@@ -240,7 +397,8 @@ Tcl_NewMethod(
     }
 
   populate:
-    clsPtr->thisPtr->fPtr->epoch++;
+    TclOOBumpEpoch(clsPtr->thisPtr->fPtr);
+    TclOOBumpFrozenEpoch(clsPtr->thisPtr->fPtr, clsPtr);
     mPtr->typePtr = typePtr;
     mPtr->clientData = clientData;
     mPtr->flags = 0;
@@ -349,7 +507,10 @@ TclOONewProcInstanceMethod(
 	    argsObj, bodyObj, &procMethodType, pmPtr, &pmPtr->procPtr);
     if (method == NULL) {
 	ckfree((char *) pmPtr);
-    } else if (pmPtrPtr != NULL) {
+	return NULL;
+    }
+    AnalyzeTrivialBody(pmPtr);
+    if (pmPtrPtr != NULL) {
 	*pmPtrPtr = pmPtr;
     }
     return (Method *) method;
@@ -414,7 +575,10 @@ TclOONewProcMethod(
     }
     if (method == NULL) {
 	ckfree((char *) pmPtr);
-    } else if (pmPtrPtr != NULL) {
+	return NULL;
+    }
+    AnalyzeTrivialBody(pmPtr);
+    if (pmPtrPtr != NULL) {
 	*pmPtrPtr = pmPtr;
     }
 
@@ -453,78 +617,17 @@ TclOOMakeProcInstanceMethod(
 				 * inside the structure indicated by the
 				 * pointer in clientData. */
 {
-    Interp *iPtr = (Interp *) interp;
     Proc *procPtr;
+    CmdFrame *cfPtr = MethodBodyLocation((Interp *) interp);
 
     if (TclCreateProc(interp, NULL, TclGetString(nameObj), argsObj, bodyObj,
 	    procPtrPtr) != TCL_OK) {
+	FreeMethodBodyLocation(cfPtr);
 	return NULL;
     }
     procPtr = *procPtrPtr;
     procPtr->cmdPtr = NULL;
-
-    if (iPtr->cmdFramePtr) {
-	CmdFrame context = *iPtr->cmdFramePtr;
-
-	if (context.type == TCL_LOCATION_BC) {
-	    /*
-	     * Retrieve source information from the bytecode, if possible. If
-	     * the information is retrieved successfully, context.type will be
-	     * TCL_LOCATION_SOURCE and the reference held by
-	     * context.data.eval.path will be counted.
-	     */
-
-	    TclGetSrcInfoForPc(&context);
-	} else if (context.type == TCL_LOCATION_SOURCE) {
-	    /*
-	     * The copy into 'context' up above has created another reference
-	     * to 'context.data.eval.path'; account for it.
-	     */
-
-	    Tcl_IncrRefCount(context.data.eval.path);
-	}
-
-	if (context.type == TCL_LOCATION_SOURCE) {
-	    /*
-	     * We can account for source location within a proc only if the
-	     * proc body was not created by substitution.
-	     * (FIXME: check that this is sane and correct!)
-	     */
-
-	    if (context.line
-		    && (context.nline >= 4) && (context.line[3] >= 0)) {
-		int isNew;
-		CmdFrame *cfPtr = (CmdFrame *) ckalloc(sizeof(CmdFrame));
-		Tcl_HashEntry *hPtr;
-
-		cfPtr->level = -1;
-		cfPtr->type = context.type;
-		cfPtr->line = (int *) ckalloc(sizeof(int));
-		cfPtr->line[0] = context.line[3];
-		cfPtr->nline = 1;
-		cfPtr->framePtr = NULL;
-		cfPtr->nextPtr = NULL;
-
-		cfPtr->data.eval.path = context.data.eval.path;
-		Tcl_IncrRefCount(cfPtr->data.eval.path);
-
-		cfPtr->cmd.str.cmd = NULL;
-		cfPtr->cmd.str.len = 0;
-
-		hPtr = Tcl_CreateHashEntry(iPtr->linePBodyPtr,
-			(char *) procPtr, &isNew);
-		Tcl_SetHashValue(hPtr, cfPtr);
-	    }
-
-	    /*
-	     * 'context' is going out of scope; account for the reference that
-	     * it's holding to the path name.
-	     */
-
-	    Tcl_DecrRefCount(context.data.eval.path);
-	    context.data.eval.path = NULL;
-	}
-    }
+    RecordMethodBodyLocation((Interp *) interp, procPtr, cfPtr);
 
     return Tcl_NewInstanceMethod(interp, (Tcl_Object) oPtr, nameObj, flags,
 	    typePtr, clientData);
@@ -566,15 +669,51 @@ TclOOMakeProcMethod(
 				 * inside the structure indicated by the
 				 * pointer in clientData. */
 {
-    Interp *iPtr = (Interp *) interp;
-    Proc *procPtr;
+    CmdFrame *cfPtr = MethodBodyLocation((Interp *) interp);
 
-    if (TclCreateProc(interp, NULL, namePtr, argsObj, bodyObj,
-	    procPtrPtr) != TCL_OK) {
-	return NULL;
+    /*
+     * Ordinary procedure-like methods of classes share their procedure (and
+     * so its bytecode) with any other that has the same definition.
+     */
+
+    if (typePtr == &procMethodType) {
+	if (GetSharedProc(interp, flags, namePtr, argsObj, bodyObj, cfPtr,
+		procPtrPtr) != TCL_OK) {
+	    return NULL;
+	}
+    } else {
+	if (TclCreateProc(interp, NULL, namePtr, argsObj, bodyObj,
+		procPtrPtr) != TCL_OK) {
+	    FreeMethodBodyLocation(cfPtr);
+	    return NULL;
+	}
+	(*procPtrPtr)->cmdPtr = NULL;
+	RecordMethodBodyLocation((Interp *) interp, *procPtrPtr, cfPtr);
     }
-    procPtr = *procPtrPtr;
-    procPtr->cmdPtr = NULL;
+
+    return Tcl_NewMethod(interp, (Tcl_Class) clsPtr, nameObj, flags, typePtr,
+	    clientData);
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * MethodBodyLocation, RecordMethodBodyLocation, FreeMethodBodyLocation --
+ *
+ *	Work out where the body of a procedure-like method being defined came
+ *	from (if that can be known) so that [info frame] can report line
+ *	numbers within it, and attach that to the procedure made for the
+ *	method.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static CmdFrame *
+MethodBodyLocation(
+    Interp *iPtr)		/* Interpreter in which the method is being
+				 * defined. */
+{
+    CmdFrame *cfPtr = NULL;
 
     if (iPtr->cmdFramePtr) {
 	CmdFrame context = *iPtr->cmdFramePtr;
@@ -606,10 +745,7 @@ TclOOMakeProcMethod(
 
 	    if (context.line
 		    && (context.nline >= 4) && (context.line[3] >= 0)) {
-		int isNew;
-		CmdFrame *cfPtr = (CmdFrame *) ckalloc(sizeof(CmdFrame));
-		Tcl_HashEntry *hPtr;
-
+		cfPtr = (CmdFrame *) ckalloc(sizeof(CmdFrame));
 		cfPtr->level = -1;
 		cfPtr->type = context.type;
 		cfPtr->line = (int *) ckalloc(sizeof(int));
@@ -623,10 +759,6 @@ TclOOMakeProcMethod(
 
 		cfPtr->cmd.str.cmd = NULL;
 		cfPtr->cmd.str.len = 0;
-
-		hPtr = Tcl_CreateHashEntry(iPtr->linePBodyPtr,
-			(char *) procPtr, &isNew);
-		Tcl_SetHashValue(hPtr, cfPtr);
 	    }
 
 	    /*
@@ -639,8 +771,276 @@ TclOOMakeProcMethod(
 	}
     }
 
-    return Tcl_NewMethod(interp, (Tcl_Class) clsPtr, nameObj, flags, typePtr,
-	    clientData);
+    return cfPtr;
+}
+
+static void
+RecordMethodBodyLocation(
+    Interp *iPtr,
+    Proc *procPtr,
+    CmdFrame *cfPtr)
+{
+    Tcl_HashEntry *hPtr;
+    int isNew;
+
+    if (cfPtr != NULL) {
+	hPtr = Tcl_CreateHashEntry(iPtr->linePBodyPtr, (char *) procPtr,
+		&isNew);
+	Tcl_SetHashValue(hPtr, cfPtr);
+    }
+}
+
+static void
+FreeMethodBodyLocation(
+    CmdFrame *cfPtr)
+{
+    if (cfPtr != NULL) {
+	Tcl_DecrRefCount(cfPtr->data.eval.path);
+	ckfree((char *) cfPtr->line);
+	ckfree((char *) cfPtr);
+    }
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * GetSharedProc, TclOOInitSharedProcs, TclOOReleaseSharedProcs --
+ *
+ *	Get the procedure for a procedure-like method of a class, reusing the
+ *	one made for any earlier class method of the interpreter with the same
+ *	formal arguments and body, the same namespace for running the body
+ *	in, and the same source location (if known). Sharing the procedure
+ *	means sharing the compiled bytecode too, which matters for generated
+ *	classes where many methods are textually identical. This is safe for
+ *	class methods because the variables they declare are resolved when
+ *	the method is called, not when it is compiled; instance methods cache
+ *	the object's variables in the compiled body and so are never shared.
+ *
+ *	The table holds a reference to each procedure. Those that only the
+ *	table refers to are released whenever the table has doubled in size,
+ *	and all of them when the object system of the interpreter goes.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+GetSharedProc(
+    Tcl_Interp *interp,		/* Interpreter for error reporting. */
+    int flags,			/* Flags of the method; only USE_DECLARER_NS
+				 * matters. */
+    const char *procName,	/* Name of the method, for error messages. */
+    Tcl_Obj *argsObj,		/* The formal argument list. */
+    Tcl_Obj *bodyObj,		/* The body. */
+    CmdFrame *cfPtr,		/* Where the body came from, or NULL if that
+				 * is not known. Always disposed of. */
+    Proc **procPtrPtr)		/* Where to write the procedure. */
+{
+    Foundation *fPtr = TclOOGetFoundation(interp);
+    SharedProcKey key, *keyPtr;
+    Tcl_HashEntry *hPtr;
+    Proc *procPtr;
+    int isNew, result;
+
+    key.flags = flags & USE_DECLARER_NS;
+    key.line = (cfPtr != NULL ? cfPtr->line[0] : -1);
+    key.pathObj = (cfPtr != NULL ? cfPtr->data.eval.path : NULL);
+    key.argsObj = argsObj;
+    key.bodyObj = bodyObj;
+    hPtr = Tcl_CreateHashEntry(&fPtr->procTable, (char *) &key, &isNew);
+
+    if (!isNew) {
+	FreeMethodBodyLocation(cfPtr);
+	procPtr = Tcl_GetHashValue(hPtr);
+	procPtr->refCount++;
+	fPtr->cacheStats.bodyShares++;
+	*procPtrPtr = procPtr;
+	return TCL_OK;
+    }
+
+    /*
+     * Holding an extra reference to the body makes TclCreateProc take its
+     * own copy of it, so the bytecode that it is compiled to is not lost
+     * when the value is used for something else.
+     */
+
+    Tcl_IncrRefCount(bodyObj);
+    result = TclCreateProc(interp, NULL, procName, argsObj, bodyObj,
+	    procPtrPtr);
+    Tcl_DecrRefCount(bodyObj);
+    if (result != TCL_OK) {
+	Tcl_DeleteHashEntry(hPtr);
+	FreeMethodBodyLocation(cfPtr);
+	return TCL_ERROR;
+    }
+    procPtr = *procPtrPtr;
+    procPtr->cmdPtr = NULL;
+    procPtr->refCount++;
+    RecordMethodBodyLocation((Interp *) interp, procPtr, cfPtr);
+    Tcl_SetHashValue(hPtr, procPtr);
+
+    /*
+     * The entry now refers to the procedure's own copy of the body instead
+     * of the one it was made from.
+     */
+
+    keyPtr = (SharedProcKey *) hPtr->key.oneWordValue;
+    Tcl_IncrRefCount(procPtr->bodyPtr);
+    Tcl_DecrRefCount(keyPtr->bodyObj);
+    keyPtr->bodyObj = procPtr->bodyPtr;
+
+    if (fPtr->procTable.numEntries >= fPtr->procSweepSize) {
+	TclOOReleaseSharedProcs(fPtr, 0);
+    }
+    return TCL_OK;
+}
+
+void
+TclOOInitSharedProcs(
+    Foundation *fPtr)
+{
+    Tcl_InitCustomHashTable(&fPtr->procTable, TCL_CUSTOM_PTR_KEYS,
+	    &sharedProcKeyType);
+    fPtr->procSweepSize = PROC_SWEEP_MIN;
+}
+
+void
+TclOOReleaseSharedProcs(
+    Foundation *fPtr,
+    int all)			/* Whether to release all the procedures, and
+				 * not just those only the table uses. */
+{
+    Tcl_HashEntry *hPtr;
+    Tcl_HashSearch search;
+    Proc *procPtr;
+
+    for (hPtr=Tcl_FirstHashEntry(&fPtr->procTable, &search); hPtr!=NULL;
+	    hPtr=Tcl_NextHashEntry(&search)) {
+	procPtr = Tcl_GetHashValue(hPtr);
+	if (all || procPtr->refCount == 1) {
+	    Tcl_DeleteHashEntry(hPtr);
+	    TclProcDeleteProc(procPtr);
+	}
+    }
+    fPtr->procSweepSize = 2 * fPtr->procTable.numEntries;
+    if (fPtr->procSweepSize < PROC_SWEEP_MIN) {
+	fPtr->procSweepSize = PROC_SWEEP_MIN;
+    }
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * HashSharedProcKey, CompareSharedProcKeys, AllocSharedProcEntry,
+ * FreeSharedProcEntry --
+ *
+ *	How the table of shared procedures is keyed. An entry holds references
+ *	to the argument list, the file name and the body of its procedure,
+ *	instead of a copy of their text.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static unsigned int
+HashSharedProcKey(
+    Tcl_HashTable *tablePtr,
+    void *keyPtr)
+{
+    SharedProcKey *spkPtr = keyPtr;
+    unsigned int result = (unsigned int) (spkPtr->flags + spkPtr->line);
+    const char *p;
+    int length, i;
+
+    p = Tcl_GetStringFromObj(spkPtr->bodyObj, &length);
+    for (i=0 ; i<length ; i++) {
+	result += (result << 3) + UCHAR(p[i]);
+    }
+    p = Tcl_GetStringFromObj(spkPtr->argsObj, &length);
+    for (i=0 ; i<length ; i++) {
+	result += (result << 3) + UCHAR(p[i]);
+    }
+    return result;
+}
+
+static int
+CompareSharedProcKeys(
+    void *keyPtr,
+    Tcl_HashEntry *hPtr)
+{
+    SharedProcKey *spkPtr = keyPtr;
+    SharedProcKey *entryKeyPtr = (SharedProcKey *) hPtr->key.oneWordValue;
+
+    if (spkPtr->flags != entryKeyPtr->flags
+	    || spkPtr->line != entryKeyPtr->line
+	    || (spkPtr->pathObj == NULL) != (entryKeyPtr->pathObj == NULL)) {
+	return 0;
+    }
+    if (spkPtr->pathObj != NULL && spkPtr->pathObj != entryKeyPtr->pathObj
+	    && strcmp(TclGetString(spkPtr->pathObj),
+		    TclGetString(entryKeyPtr->pathObj)) != 0) {
+	return 0;
+    }
+    return (SameString(spkPtr->argsObj, entryKeyPtr->argsObj)
+	    && SameString(spkPtr->bodyObj, entryKeyPtr->bodyObj));
+}
+
+static Tcl_HashEntry *
+AllocSharedProcEntry(
+    Tcl_HashTable *tablePtr,
+    void *keyPtr)
+{
+    SharedProcKey *spkPtr = keyPtr;
+    SharedProcKey *entryKeyPtr = (SharedProcKey *)
+	    ckalloc(sizeof(SharedProcKey));
+    Tcl_HashEntry *hPtr = (Tcl_HashEntry *) ckalloc(sizeof(Tcl_HashEntry));
+
+    entryKeyPtr->flags = spkPtr->flags;
+    entryKeyPtr->line = spkPtr->line;
+    entryKeyPtr->pathObj = spkPtr->pathObj;
+    if (entryKeyPtr->pathObj != NULL) {
+	Tcl_IncrRefCount(entryKeyPtr->pathObj);
+    }
+    entryKeyPtr->argsObj = spkPtr->argsObj;
+    Tcl_IncrRefCount(entryKeyPtr->argsObj);
+    entryKeyPtr->bodyObj = spkPtr->bodyObj;
+    Tcl_IncrRefCount(entryKeyPtr->bodyObj);
+    hPtr->key.oneWordValue = (char *) entryKeyPtr;
+    hPtr->clientData = NULL;
+    return hPtr;
+}
+
+static void
+FreeSharedProcEntry(
+    Tcl_HashEntry *hPtr)
+{
+    SharedProcKey *entryKeyPtr = (SharedProcKey *) hPtr->key.oneWordValue;
+
+    if (entryKeyPtr->pathObj != NULL) {
+	Tcl_DecrRefCount(entryKeyPtr->pathObj);
+    }
+    Tcl_DecrRefCount(entryKeyPtr->argsObj);
+    Tcl_DecrRefCount(entryKeyPtr->bodyObj);
+    ckfree((char *) entryKeyPtr);
+    ckfree((char *) hPtr);
+}
+
+/*
+ * Whether two values have the same string.
+ */
+
+static inline int
+SameString(
+    Tcl_Obj *obj1Ptr,
+    Tcl_Obj *obj2Ptr)
+{
+    const char *str1, *str2;
+    int len1, len2;
+
+    if (obj1Ptr == obj2Ptr) {
+	return 1;
+    }
+    str1 = Tcl_GetStringFromObj(obj1Ptr, &len1);
+    str2 = Tcl_GetStringFromObj(obj2Ptr, &len2);
+    return (len1 == len2 && memcmp(str1, str2, (size_t) len1) == 0);
 }
 
 /*
@@ -668,6 +1068,15 @@ InvokeProcedureMethod(
 				 * matched by this function (or rather, by the
 				 * call frame's lifetime). */
 
+    /*
+     * Methods with trivial bodies can often be handled without a frame.
+     */
+
+    if (pmPtr->trivialKind != TRIVIAL_NONE && InvokeTrivialBody(pmPtr,
+	    interp, context, objc, objv)) {
+	return TCL_OK;
+    }
+
     /*
      * Allocate the special frame data.
      */
@@ -740,23 +1149,250 @@ InvokeProcedureMethod(
     TclStackFree(interp, fdPtr);
     return result;
 }
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * AnalyzeTrivialBody --
+ *
+ *	Work out whether a procedure-like method has a body so simple that
+ *	the method can be run without pushing a call frame or executing any
+ *	bytecode: an empty body (or just [return]), or one that just returns
+ *	the value of one of its arguments with [return $arg] or [set arg].
+ *	Nothing such a body does can be observed from inside the method, so
+ *	skipping the frame is safe. Anything else (including the tail calls
+ *	[my foo {*}$args] and [next {*}$args], whose targets can look at the
+ *	caller's frame with [uplevel] or [info frame]) is left alone. The
+ *	method remains a procedure method, so introspection is unaffected.
+ *
+ *	Setters of the form [set var $arg] are deliberately not recognised.
+ *	Whether var is an object variable or a local depends on the variable
+ *	declarations, which can change without the method being redefined,
+ *	and writing an object variable runs its traces, which could see that
+ *	the method's frame is missing. Handling them properly would need
+ *	those checks on every call, which would cost about as much as the
+ *	frame that is saved.
+ *
+ * ----------------------------------------------------------------------
+ */
 
-static int
-PushMethodCallFrame(
-    Tcl_Interp *interp,		/* Current interpreter. */
-    CallContext *contextPtr,	/* Current method call context. */
-    ProcedureMethod *pmPtr,	/* Information about this procedure-like
-				 * method. */
-    int objc,			/* Number of arguments. */
-    Tcl_Obj *const *objv,	/* Array of arguments. */
-    PMFrameData *fdPtr)		/* Place to store information about the call
-				 * frame. */
+static void
+AnalyzeTrivialBody(
+    ProcedureMethod *pmPtr)
 {
-    Tcl_Namespace *nsPtr = contextPtr->oPtr->namespacePtr;
-    register int result;
+    Proc *procPtr = pmPtr->procPtr;
+    CompiledLocal *localPtr;
+    const char *p, *word1, *word2, *end;
+    int len1, len2, i;
+
+    pmPtr->trivialKind = TRIVIAL_NONE;
+    pmPtr->trivialCmdName = NULL;
+    if (procPtr == NULL || procPtr->bodyPtr == NULL) {
+	return;
+    }
+
+    /*
+     * Split the body into at most two words of plain characters on one
+     * line. Anything with quoting, substitutions (other than the $ of
+     * [return $arg]), comments or multiple commands is not trivial.
+     */
+
+    p = TclGetString(procPtr->bodyPtr);
+    while (isspace(UCHAR(*p))) {
+	p++;
+    }
+    word1 = p;
+    while (*p != '\0' && !isspace(UCHAR(*p))) {
+	p++;
+    }
+    len1 = p - word1;
+    while (*p == ' ' || *p == '\t') {
+	p++;
+    }
+    word2 = p;
+    while (*p != '\0' && !isspace(UCHAR(*p))) {
+	p++;
+    }
+    len2 = p - word2;
+    end = p;
+    while (isspace(UCHAR(*end))) {
+	end++;
+    }
+    if (*end != '\0') {
+	return;
+    }
+
+    if (len1 == 0) {
+	pmPtr->trivialKind = TRIVIAL_EMPTY;
+    } else if (len1 == 6 && len2 == 0 && strncmp(word1, "return", 6) == 0) {
+	pmPtr->trivialKind = TRIVIAL_EMPTY;
+	pmPtr->trivialCmdName = "return";
+    } else if ((len1 == 6 && strncmp(word1, "return", 6) == 0
+	    && len2 > 1 && word2[0] == '$')
+	    || (len1 == 3 && strncmp(word1, "set", 3) == 0 && len2 > 0)) {
+	if (word1[0] == 'r') {
+	    word2++;
+	    len2--;
+	}
+	for (i=0 ; i<len2 ; i++) {
+	    if (!isalnum(UCHAR(word2[i])) && word2[i] != '_') {
+		return;
+	    }
+	}
+	for (i=0, localPtr=procPtr->firstLocalPtr ; i<procPtr->numArgs ;
+		i++, localPtr=localPtr->nextPtr) {
+	    if (localPtr->nameLength == len2
+		    && strncmp(localPtr->name, word2, len2) == 0) {
+		break;
+	    }
+	}
+	if (i >= procPtr->numArgs) {
+	    return;
+	}
+	pmPtr->trivialKind = TRIVIAL_ARG;
+	pmPtr->trivialArg = i;
+	pmPtr->trivialCmdName = (word1[0] == 'r' ? "return" : "set");
+    } else {
+	return;
+    }
+
+    /*
+     * Work out how many arguments the method may be called with.
+     */
+
+    pmPtr->minArgs = 0;
+    pmPtr->maxArgs = procPtr->numArgs;
+    for (i=0, localPtr=procPtr->firstLocalPtr ; i<procPtr->numArgs ;
+	    i++, localPtr=localPtr->nextPtr) {
+	if (localPtr->flags & VAR_IS_ARGS) {
+	    pmPtr->maxArgs = -1;
+	} else if (localPtr->defValuePtr == NULL) {
+	    pmPtr->minArgs = i + 1;
+	}
+    }
+    pmPtr->trivialBodyObj = procPtr->bodyPtr;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * InvokeTrivialBody --
+ *
+ *	Run a method found to be trivial by AnalyzeTrivialBody, if it is safe
+ *	to do so right now.
+ *
+ * Results:
+ *	1 if the method was run (and the interpreter result set), or 0 if it
+ *	must be invoked in the normal way instead, such as because it has the
+ *	wrong number of arguments (the normal path generates the error),
+ *	because there are execution or step traces that would see its body
+ *	run, or because the [return] or [set] that the body uses is not the
+ *	builtin where the method runs.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+InvokeTrivialBody(
+    ProcedureMethod *pmPtr,
+    Tcl_Interp *interp,
+    Tcl_ObjectContext context,
+    int objc,
+    Tcl_Obj *const *objv)
+{
+    int skip = Tcl_ObjectContextSkippedArgs(context);
+    int numArgs = objc - skip;
+    CompiledLocal *localPtr;
+    int i;
+
+    if (pmPtr->preCallProc != NULL || pmPtr->postCallProc != NULL
+	    || pmPtr->procPtr->bodyPtr != pmPtr->trivialBodyObj
+	    || ((Interp *) interp)->tracePtr != NULL
+	    || numArgs < pmPtr->minArgs
+	    || (pmPtr->maxArgs >= 0 && numArgs > pmPtr->maxArgs)) {
+	return 0;
+    }
+    if (pmPtr->trivialCmdName != NULL
+	    && !UsesBuiltinCommand(interp, (CallContext *) context, pmPtr)) {
+	return 0;
+    }
+
+    if (pmPtr->trivialKind == TRIVIAL_EMPTY) {
+	Tcl_ResetResult(interp);
+	return 1;
+    }
+
+    localPtr = pmPtr->procPtr->firstLocalPtr;
+    for (i=0 ; i<pmPtr->trivialArg ; i++) {
+	localPtr = localPtr->nextPtr;
+    }
+    if (localPtr->flags & VAR_IS_ARGS) {
+	Tcl_SetObjResult(interp, Tcl_NewListObj(numArgs - i, objv + skip + i));
+    } else if (i < numArgs) {
+	Tcl_SetObjResult(interp, objv[skip + i]);
+    } else {
+	Tcl_SetObjResult(interp, localPtr->defValuePtr);
+    }
+    return 1;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * UsesBuiltinCommand --
+ *
+ *	Check that the command used by a trivial method body resolves, in the
+ *	namespace that the method would run in, to the builtin with no traces
+ *	on it. The check is made on each call, as the command may be replaced
+ *	or shadowed (in the object's namespace, the class's or the global one)
+ *	at any time.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+UsesBuiltinCommand(
+    Tcl_Interp *interp,
+    CallContext *contextPtr,
+    ProcedureMethod *pmPtr)
+{
+    Foundation *fPtr = contextPtr->oPtr->fPtr;
+    Tcl_Namespace *nsPtr = contextPtr->oPtr->namespacePtr;
+    CompileProc *compileProc = (pmPtr->trivialCmdName[0] == 'r')
+	    ? fPtr->returnCompileProc : fPtr->setCompileProc;
+    Command *cmdPtr;
+
+    if (pmPtr->flags & USE_DECLARER_NS) {
+	register Method *mPtr =
+		contextPtr->callPtr->chain[contextPtr->index].mPtr;
+
+	if (mPtr->declaringClassPtr != NULL) {
+	    nsPtr = mPtr->declaringClassPtr->thisPtr->namespacePtr;
+	} else {
+	    nsPtr = mPtr->declaringObjectPtr->namespacePtr;
+	}
+    }
+    cmdPtr = (Command *) Tcl_FindCommand(interp, pmPtr->trivialCmdName,
+	    nsPtr, 0);
+    return (cmdPtr != NULL && compileProc != NULL
+	    && cmdPtr->compileProc == compileProc && cmdPtr->tracePtr == NULL);
+}
+
+static int
+PushMethodCallFrame(
+    Tcl_Interp *interp,		/* Current interpreter. */
+    CallContext *contextPtr,	/* Current method call context. */
+    ProcedureMethod *pmPtr,	/* Information about this procedure-like
+				 * method. */
+    int objc,			/* Number of arguments. */
+    Tcl_Obj *const *objv,	/* Array of arguments. */
+    PMFrameData *fdPtr)		/* Place to store information about the call
+				 * frame. */
+{
+    Tcl_Namespace *nsPtr = contextPtr->oPtr->namespacePtr;
+    register int result;
     const char *namePtr;
     CallFrame **framePtrPtr = &fdPtr->framePtr;
-    static Tcl_ObjType *byteCodeTypePtr = NULL;	/* HACK! */
 
     /*
      * Compute basic information on the basis of the type of method it is.
@@ -814,7 +1450,6 @@ PushMethodCallFrame(
     fdPtr->cmd.clientData = &fdPtr->efi;
     pmPtr->procPtr->cmdPtr = &fdPtr->cmd;
 
-    /* Should be a reference to tclByteCodeType, but that's MODULE_SCOPE */
     if (byteCodeTypePtr == NULL ||
 	    pmPtr->procPtr->bodyPtr->typePtr != byteCodeTypePtr) {
 	result = TclProcCompileProc(interp, pmPtr->procPtr,
@@ -872,6 +1507,142 @@ PushMethodCallFrame(
     return TCL_OK;
 }
 
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOPrecompileClass, PrecompileClass, PrecompileMethod --
+ *
+ *	Compile the bodies of the procedure-like methods of a class and of
+ *	all its subclasses, and build the call chains that a stereotypical
+ *	instance of each of those classes would use, so that the first call
+ *	of a method does not have to pay for these things. If a pattern is
+ *	given, only methods whose names match it are handled; constructors
+ *	and destructors are always compiled.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+TclOOPrecompileClass(
+    Tcl_Interp *interp,		/* Where to report errors. */
+    Class *clsPtr,		/* The class to precompile. */
+    const char *pattern)	/* Pattern that selects which methods to
+				 * precompile, or NULL for all of them. */
+{
+    Tcl_HashTable doneTable;
+    int result;
+
+    Tcl_InitHashTable(&doneTable, TCL_ONE_WORD_KEYS);
+    result = PrecompileClass(interp, clsPtr, pattern, &doneTable);
+    Tcl_DeleteHashTable(&doneTable);
+    return result;
+}
+
+static int
+PrecompileClass(
+    Tcl_Interp *interp,
+    Class *clsPtr,
+    const char *pattern,
+    Tcl_HashTable *doneTablePtr)/* Classes already processed, to cope with
+				 * diamond inheritance. */
+{
+    FOREACH_HASH_DECLS;
+    Tcl_Namespace *nsPtr = clsPtr->thisPtr->namespacePtr;
+    Tcl_Obj *namePtr;
+    Method *mPtr;
+    Class *subPtr;
+    int i, isNew;
+
+    (void) Tcl_CreateHashEntry(doneTablePtr, (char *) clsPtr, &isNew);
+    if (!isNew) {
+	return TCL_OK;
+    }
+
+    FOREACH_HASH(namePtr, mPtr, &clsPtr->classMethods) {
+	if (pattern != NULL
+		&& !Tcl_StringMatch(TclGetString(namePtr), pattern)) {
+	    continue;
+	}
+	if (PrecompileMethod(interp, mPtr, nsPtr,
+		TclGetString(namePtr)) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+    }
+    if (PrecompileMethod(interp, clsPtr->constructorPtr, nsPtr,
+	    "<constructor>") != TCL_OK) {
+	return TCL_ERROR;
+    }
+    if (PrecompileMethod(interp, clsPtr->destructorPtr, nsPtr,
+	    "<destructor>") != TCL_OK) {
+	return TCL_ERROR;
+    }
+    TclOOWarmClassChains(clsPtr, pattern);
+
+    FOREACH(subPtr, clsPtr->subclasses) {
+	if (PrecompileClass(interp, subPtr, pattern,
+		doneTablePtr) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+    }
+    return TCL_OK;
+}
+
+static int
+PrecompileMethod(
+    Tcl_Interp *interp,
+    Method *mPtr,		/* The method to compile; may be NULL or of
+				 * a type other than a procedure-like method,
+				 * in which case nothing is done. */
+    Tcl_Namespace *nsPtr,	/* Namespace to compile the body in. */
+    const char *namePtr)	/* Name of the method, for error messages. */
+{
+    ProcedureMethod *pmPtr;
+    Command *oldCmdPtr, cmd;
+    int result;
+
+    if (mPtr == NULL) {
+	return TCL_OK;
+    }
+    if (mPtr->typePtr == &lazyMethodType
+	    && MaterializeLazyMethod(interp, mPtr) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    if (mPtr->typePtr == &memoMethodType) {
+	MemoMethod *memoPtr = mPtr->clientData;
+
+	if (memoPtr->innerTypePtr != &procMethodType) {
+	    return TCL_OK;
+	}
+	pmPtr = memoPtr->innerClientData;
+    } else if (mPtr->typePtr != &procMethodType) {
+	return TCL_OK;
+    } else {
+	pmPtr = mPtr->clientData;
+    }
+    if (byteCodeTypePtr != NULL
+	    && pmPtr->procPtr->bodyPtr->typePtr == byteCodeTypePtr) {
+	return TCL_OK;
+    }
+
+    /*
+     * The compiler expects the procedure to belong to a command, as it does
+     * when the method is being called; see PushMethodCallFrame().
+     */
+
+    memset(&cmd, 0, sizeof(Command));
+    cmd.nsPtr = (Namespace *) nsPtr;
+    oldCmdPtr = pmPtr->procPtr->cmdPtr;
+    pmPtr->procPtr->cmdPtr = &cmd;
+    result = TclProcCompileProc(interp, pmPtr->procPtr,
+	    pmPtr->procPtr->bodyPtr, (Namespace *) nsPtr, "body of method",
+	    namePtr);
+    pmPtr->procPtr->cmdPtr = oldCmdPtr;
+    if (result == TCL_OK && byteCodeTypePtr == NULL) {
+	byteCodeTypePtr = pmPtr->procPtr->bodyPtr->typePtr;
+    }
+    return result;
+}
+
 /*
  * ----------------------------------------------------------------------
  *
@@ -1457,47 +2228,1339 @@ CloneForwardMethod(
 /*
  * ----------------------------------------------------------------------
  *
- * TclOOGetProcFromMethod, TclOOGetFwdFromMethod --
+ * TclOONewPropertyMethod --
  *
- *	Utility functions used for procedure-like and forwarding method
- *	introspection.
+ *	Create a new property accessor method for a class (if clsPtr is
+ *	non-NULL) or an object. The method reads or writes the variable of
+ *	the same name in the object's namespace without needing a call frame
+ *	or any bytecode.
  *
  * ----------------------------------------------------------------------
  */
 
-Proc *
-TclOOGetProcFromMethod(
-    Method *mPtr)
+Method *
+TclOONewPropertyMethod(
+    Tcl_Interp *interp,		/* Interpreter for error reporting. */
+    Object *oPtr,		/* The object to attach the method to, if
+				 * clsPtr is NULL. */
+    Class *clsPtr,		/* The class to attach the method to, or NULL
+				 * for an instance method. */
+    int flags,			/* Whether the method is public or not. */
+    Tcl_Obj *nameObj,		/* The name of the method and variable. */
+    int accessFlags,		/* PROPERTY_GET and/or PROPERTY_SET. */
+    Tcl_Obj *validateObj)	/* Command prefix used to check new values, or
+				 * NULL. */
 {
-    if (mPtr->typePtr == &procMethodType) {
-	ProcedureMethod *pmPtr = mPtr->clientData;
+    register PropertyMethod *prPtr;
+    int prefixLen;
 
-	return pmPtr->procPtr;
+    if (validateObj != NULL) {
+	if (Tcl_ListObjLength(interp, validateObj, &prefixLen) != TCL_OK) {
+	    return NULL;
+	}
+	if (prefixLen < 1) {
+	    Tcl_AppendResult(interp,
+		    "property validation prefix must be non-empty", NULL);
+	    return NULL;
+	}
+	Tcl_IncrRefCount(validateObj);
     }
-    return NULL;
+
+    prPtr = (PropertyMethod *) ckalloc(sizeof(PropertyMethod));
+    prPtr->varNameObj = nameObj;
+    Tcl_IncrRefCount(nameObj);
+    prPtr->flags = accessFlags;
+    prPtr->validateObj = validateObj;
+    if (clsPtr != NULL) {
+	return (Method *) Tcl_NewMethod(interp, (Tcl_Class) clsPtr, nameObj,
+		flags, &propMethodType, prPtr);
+    }
+    return (Method *) Tcl_NewInstanceMethod(interp, (Tcl_Object) oPtr,
+	    nameObj, flags, &propMethodType, prPtr);
 }
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * InvokePropertyMethod --
+ *
+ *	How to invoke a property accessor. With no arguments, the property
+ *	value is returned; with one, it is validated and then stored. Simple
+ *	scalar variables are accessed directly; anything that might need
+ *	traces firing or other special treatment goes through the normal Tcl
+ *	variable API instead.
+ *
+ * ----------------------------------------------------------------------
+ */
 
-Tcl_Obj *
-TclOOGetMethodBody(
-    Method *mPtr)
+static int
+InvokePropertyMethod(
+    ClientData clientData,	/* Pointer to some per-method context. */
+    Tcl_Interp *interp,
+    Tcl_ObjectContext context,	/* The method calling context. */
+    int objc,			/* Number of arguments. */
+    Tcl_Obj *const *objv)	/* Arguments as actually seen. */
 {
-    if (mPtr->typePtr == &procMethodType) {
-	ProcedureMethod *pmPtr = mPtr->clientData;
+    CallContext *contextPtr = (CallContext *) context;
+    PropertyMethod *prPtr = clientData;
+    Object *oPtr = contextPtr->oPtr;
+    int skip = contextPtr->skip;
+    Tcl_Obj *valueObj, *varNameObj;
+    Var *varPtr;
+
+    if (objc == skip && (prPtr->flags & PROPERTY_GET)) {
+	varPtr = GetPropertyVar(oPtr, prPtr->varNameObj);
+	if (varPtr != NULL && !TclIsVarUndefined(varPtr)) {
+	    Tcl_SetObjResult(interp, varPtr->value.objPtr);
+	    return TCL_OK;
+	}
 
-	if (pmPtr->procPtr->bodyPtr->bytes == NULL) {
-	    (void) Tcl_GetString(pmPtr->procPtr->bodyPtr);
+	varNameObj = PropertyVarName(oPtr, prPtr->varNameObj);
+	valueObj = Tcl_ObjGetVar2(interp, varNameObj, NULL,
+		TCL_LEAVE_ERR_MSG);
+	Tcl_DecrRefCount(varNameObj);
+	if (valueObj == NULL) {
+	    return TCL_ERROR;
 	}
-	return pmPtr->procPtr->bodyPtr;
+	Tcl_SetObjResult(interp, valueObj);
+	return TCL_OK;
+    } else if (objc == skip+1 && (prPtr->flags & PROPERTY_SET)) {
+	int result = TCL_OK;
+
+	valueObj = objv[skip];
+	Tcl_IncrRefCount(valueObj);
+
+	/*
+	 * Check the value first, if we've been asked to. The validation
+	 * command is looked up in the same way as the target of a forwarded
+	 * method.
+	 */
+
+	if (prPtr->validateObj != NULL) {
+	    Tcl_Obj **argObjs, **prefixObjs;
+	    int len;
+
+	    Tcl_ListObjGetElements(NULL, prPtr->validateObj, &len,
+		    &prefixObjs);
+	    argObjs = TclStackAlloc(interp, sizeof(Tcl_Obj *) * (len+1));
+	    memcpy(argObjs, prefixObjs, sizeof(Tcl_Obj *) * len);
+	    argObjs[len++] = valueObj;
+	    if (strncmp(TclGetString(argObjs[0]), "::", 2) != 0) {
+		Tcl_Command cmd = Tcl_FindCommand(interp,
+			TclGetString(argObjs[0]), oPtr->namespacePtr, 0);
+
+		if (cmd != NULL) {
+		    argObjs[0] = Tcl_NewObj();
+		    Tcl_GetCommandFullName(interp, cmd, argObjs[0]);
+		}
+	    }
+	    Tcl_IncrRefCount(argObjs[0]);
+	    result = Tcl_EvalObjv(interp, len, argObjs, TCL_EVAL_INVOKE);
+	    Tcl_DecrRefCount(argObjs[0]);
+	    TclStackFree(interp, argObjs);
+	    if (result != TCL_OK) {
+		goto doneSet;
+	    }
+	    Tcl_ResetResult(interp);
+	    if (oPtr->namespacePtr == NULL) {
+		Tcl_AppendResult(interp, "object deleted while validating "
+			"property value", NULL);
+		result = TCL_ERROR;
+		goto doneSet;
+	    }
+	}
+
+	varPtr = GetPropertyVar(oPtr, prPtr->varNameObj);
+	if (varPtr != NULL && !TclIsVarUndefined(varPtr)) {
+	    if (varPtr->value.objPtr != valueObj) {
+		Tcl_DecrRefCount(varPtr->value.objPtr);
+		varPtr->value.objPtr = valueObj;
+		Tcl_IncrRefCount(valueObj);
+	    }
+	    Tcl_SetObjResult(interp, valueObj);
+	} else {
+	    Tcl_Obj *resultObj;
+
+	    varNameObj = PropertyVarName(oPtr, prPtr->varNameObj);
+	    resultObj = Tcl_ObjSetVar2(interp, varNameObj, NULL, valueObj,
+		    TCL_LEAVE_ERR_MSG);
+	    Tcl_DecrRefCount(varNameObj);
+	    if (resultObj == NULL) {
+		result = TCL_ERROR;
+	    } else {
+		Tcl_SetObjResult(interp, resultObj);
+	    }
+	}
+
+      doneSet:
+	Tcl_DecrRefCount(valueObj);
+	return result;
     }
-    return NULL;
+
+    switch (prPtr->flags & (PROPERTY_GET | PROPERTY_SET)) {
+    case PROPERTY_GET:
+	Tcl_WrongNumArgs(interp, skip, objv, NULL);
+	break;
+    case PROPERTY_SET:
+	Tcl_WrongNumArgs(interp, skip, objv, "value");
+	break;
+    default:
+	Tcl_WrongNumArgs(interp, skip, objv, "?value?");
+    }
+    return TCL_ERROR;
 }
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * GetPropertyVar, PropertyVarName --
+ *
+ *	Utility functions for locating the variable behind a property. The
+ *	first finds the variable itself, but only if it is a plain scalar that
+ *	can be read and written without any help from Tcl's variable code
+ *	(i.e., it has no traces and is not an array element, whose array
+ *	might have traces); otherwise it returns NULL. The second produces
+ *	the fully-qualified name of the variable, with a reference count of
+ *	one, for when the full variable API must be used.
+ *
+ * ----------------------------------------------------------------------
+ */
 
-Tcl_Obj *
-TclOOGetFwdFromMethod(
-    Method *mPtr)
+static Var *
+GetPropertyVar(
+    Object *oPtr,
+    Tcl_Obj *varNameObj)
+{
+    Tcl_HashEntry *hPtr;
+    Var *varPtr;
+
+    hPtr = Tcl_FindHashEntry(TclVarTable(oPtr->namespacePtr),
+	    (char *) varNameObj);
+    if (hPtr == NULL) {
+	return NULL;
+    }
+    varPtr = (Var *) TclVarHashGetValue(hPtr);
+    if (TclIsVarLink(varPtr)) {
+	varPtr = varPtr->value.linkPtr;
+    }
+    if (!TclIsVarScalar(varPtr) || TclIsVarLink(varPtr)
+	    || TclIsVarTraced(varPtr) || TclIsVarArrayElement(varPtr)) {
+	return NULL;
+    }
+    return varPtr;
+}
+
+static Tcl_Obj *
+PropertyVarName(
+    Object *oPtr,
+    Tcl_Obj *varNameObj)
+{
+    Tcl_Obj *nameObj = Tcl_NewStringObj(oPtr->namespacePtr->fullName, -1);
+
+    Tcl_AppendToObj(nameObj, "::", 2);
+    Tcl_AppendObjToObj(nameObj, varNameObj);
+    Tcl_IncrRefCount(nameObj);
+    return nameObj;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * DeletePropertyMethod, ClonePropertyMethod --
+ *
+ *	How to delete and clone property accessor methods.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static void
+DeletePropertyMethod(
+    ClientData clientData)
 {
-    if (mPtr->typePtr == &fwdMethodType) {
-	ForwardMethod *fwPtr = mPtr->clientData;
+    PropertyMethod *prPtr = clientData;
+
+    Tcl_DecrRefCount(prPtr->varNameObj);
+    if (prPtr->validateObj != NULL) {
+	Tcl_DecrRefCount(prPtr->validateObj);
+    }
+    ckfree((char *) prPtr);
+}
+
+static int
+ClonePropertyMethod(
+    Tcl_Interp *interp,
+    ClientData clientData,
+    ClientData *newClientData)
+{
+    PropertyMethod *prPtr = clientData;
+    PropertyMethod *pr2Ptr = (PropertyMethod *)
+	    ckalloc(sizeof(PropertyMethod));
+
+    *pr2Ptr = *prPtr;
+    Tcl_IncrRefCount(pr2Ptr->varNameObj);
+    if (pr2Ptr->validateObj != NULL) {
+	Tcl_IncrRefCount(pr2Ptr->validateObj);
+    }
+    *newClientData = pr2Ptr;
+    return TCL_OK;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOODescribeMethod --
+ *
+ *	Make a description of a method that does not depend on the
+ *	interpreter it belongs to, for use in a shared class library (see
+ *	tclOOShare.c). Only methods that are completely defined by their
+ *	definition script can be described; procedure-like methods that an
+ *	extension has customized, memoized methods and methods of types
+ *	defined outside the core cannot be. Returns NULL if the method cannot
+ *	be described, and otherwise a description with one reference that
+ *	belongs to the caller.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+SharedMethod *
+TclOODescribeMethod(
+    Method *mPtr)		/* The method to describe. */
+{
+    SharedMethod *smPtr;
+    Tcl_Obj *argsObj = NULL, *bodyObj = NULL;
+    int kind, accessFlags = 0;
+    int flags = mPtr->flags & (PUBLIC_METHOD | PRIVATE_METHOD);
+
+    if (mPtr->typePtr == NULL) {
+	kind = SHARED_FLAGS;
+    } else if (mPtr->typePtr == &lazyMethodType) {
+	/*
+	 * Not yet used in this interpreter, so the description it was made
+	 * from is still exactly right.
+	 */
+
+	smPtr = ((LazyProcMethod *) mPtr->clientData)->smPtr;
+	smPtr->refCount++;
+	return smPtr;
+    } else if (mPtr->typePtr == &procMethodType) {
+	ProcedureMethod *pmPtr = mPtr->clientData;
+	CompiledLocal *localPtr;
+	Tcl_Obj *listObj;
+
+	if (pmPtr->clientData != NULL || pmPtr->errProc != NULL
+		|| pmPtr->preCallProc != NULL || pmPtr->postCallProc != NULL
+		|| pmPtr->gfivProc != NULL
+		|| (pmPtr->flags & ~USE_DECLARER_NS)) {
+	    return NULL;
+	}
+	kind = SHARED_PROC;
+	flags |= pmPtr->flags;
+
+	/*
+	 * Rebuild the formal argument list in the same way as [info class
+	 * definition] does.
+	 */
+
+	listObj = Tcl_NewObj();
+	Tcl_IncrRefCount(listObj);
+	for (localPtr=pmPtr->procPtr->firstLocalPtr; localPtr!=NULL;
+		localPtr=localPtr->nextPtr) {
+	    if (TclIsVarArgument(localPtr)) {
+		Tcl_Obj *argObj = Tcl_NewObj();
+
+		Tcl_ListObjAppendElement(NULL, argObj,
+			Tcl_NewStringObj(localPtr->name, -1));
+		if (localPtr->defValuePtr != NULL) {
+		    Tcl_ListObjAppendElement(NULL, argObj,
+			    CopyOfString(localPtr->defValuePtr));
+		}
+		Tcl_ListObjAppendElement(NULL, listObj, argObj);
+	    }
+	}
+	argsObj = CopyOfString(listObj);
+	Tcl_DecrRefCount(listObj);
+	bodyObj = CopyOfString(TclOOGetMethodBody(mPtr));
+    } else if (mPtr->typePtr == &fwdMethodType) {
+	kind = SHARED_FORWARD;
+	bodyObj = CopyOfString(
+		((ForwardMethod *) mPtr->clientData)->prefixObj);
+    } else if (mPtr->typePtr == &propMethodType) {
+	PropertyMethod *prPtr = mPtr->clientData;
+
+	kind = SHARED_PROPERTY;
+	accessFlags = prPtr->flags;
+	if (prPtr->validateObj != NULL) {
+	    bodyObj = CopyOfString(prPtr->validateObj);
+	}
+    } else {
+	return NULL;
+    }
+
+    smPtr = (SharedMethod *) ckalloc(sizeof(SharedMethod));
+    smPtr->refCount = 1;
+    smPtr->kind = kind;
+    smPtr->flags = flags;
+    smPtr->accessFlags = accessFlags;
+    smPtr->nameObj = NULL;
+    if (mPtr->namePtr != NULL) {
+	smPtr->nameObj = CopyOfString(mPtr->namePtr);
+	Tcl_IncrRefCount(smPtr->nameObj);
+    }
+    smPtr->argsObj = argsObj;
+    if (argsObj != NULL) {
+	Tcl_IncrRefCount(argsObj);
+    }
+    smPtr->bodyObj = bodyObj;
+    if (bodyObj != NULL) {
+	Tcl_IncrRefCount(bodyObj);
+    }
+    return smPtr;
+}
+
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOONewSharedMethod --
+ *
+ *	Create a method for a class (if clsPtr is non-NULL) or an object from
+ *	its description in a shared class library. Everything that the method
+ *	keeps is a fresh copy belonging to this interpreter. Procedure-like
+ *	methods keep a reference to the description and only become real
+ *	procedures when first needed.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+Method *
+TclOONewSharedMethod(
+    Tcl_Interp *interp,		/* Interpreter for error reporting. */
+    Object *oPtr,		/* The object to attach the method to, if
+				 * clsPtr is NULL. */
+    Class *clsPtr,		/* The class to attach the method to, or NULL
+				 * for an instance method. */
+    SharedMethod *smPtr)	/* The description of the method. */
+{
+    Tcl_Obj *nameObj = NULL, *prefixObj;
+    const Tcl_MethodType *typePtr = NULL;
+    ClientData clientData = NULL;
+    int flags = smPtr->flags & (PUBLIC_METHOD | PRIVATE_METHOD);
+    Method *mPtr;
+
+    if (smPtr->nameObj != NULL) {
+	nameObj = CopyOfString(smPtr->nameObj);
+	Tcl_IncrRefCount(nameObj);
+    }
+
+    switch (smPtr->kind) {
+    case SHARED_FORWARD:
+	prefixObj = CopyOfString(smPtr->bodyObj);
+	Tcl_IncrRefCount(prefixObj);
+	if (clsPtr != NULL) {
+	    mPtr = TclOONewForwardMethod(interp, clsPtr, flags, nameObj,
+		    prefixObj);
+	} else {
+	    mPtr = TclOONewForwardInstanceMethod(interp, oPtr, flags, nameObj,
+		    prefixObj);
+	}
+	Tcl_DecrRefCount(prefixObj);
+	goto done;
+    case SHARED_PROPERTY:
+	prefixObj = NULL;
+	if (smPtr->bodyObj != NULL) {
+	    prefixObj = CopyOfString(smPtr->bodyObj);
+	    Tcl_IncrRefCount(prefixObj);
+	}
+	mPtr = TclOONewPropertyMethod(interp, oPtr, clsPtr, flags, nameObj,
+		smPtr->accessFlags, prefixObj);
+	if (prefixObj != NULL) {
+	    Tcl_DecrRefCount(prefixObj);
+	}
+	goto done;
+    case SHARED_PROC: {
+	LazyProcMethod *lpmPtr = (LazyProcMethod *)
+		ckalloc(sizeof(LazyProcMethod));
+
+	lpmPtr->interp = interp;
+	lpmPtr->smPtr = smPtr;
+	smPtr->refCount++;
+	typePtr = &lazyMethodType;
+	clientData = lpmPtr;
+	break;
+    }
+    case SHARED_FLAGS:
+	break;
+    }
+
+    if (clsPtr != NULL) {
+	mPtr = (Method *) Tcl_NewMethod(interp, (Tcl_Class) clsPtr, nameObj,
+		flags, typePtr, clientData);
+    } else {
+	mPtr = (Method *) Tcl_NewInstanceMethod(interp, (Tcl_Object) oPtr,
+		nameObj, flags, typePtr, clientData);
+    }
+
+  done:
+    if (nameObj != NULL) {
+	Tcl_DecrRefCount(nameObj);
+    }
+    return mPtr;
+}
+
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOReleaseSharedMethod --
+ *
+ *	Drop a reference to the description of a method in a shared class
+ *	library, deleting it when it is no longer used.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+void
+TclOOReleaseSharedMethod(
+    SharedMethod *smPtr)
+{
+    if (--smPtr->refCount > 0) {
+	return;
+    }
+    if (smPtr->nameObj != NULL) {
+	Tcl_DecrRefCount(smPtr->nameObj);
+    }
+    if (smPtr->argsObj != NULL) {
+	Tcl_DecrRefCount(smPtr->argsObj);
+    }
+    if (smPtr->bodyObj != NULL) {
+	Tcl_DecrRefCount(smPtr->bodyObj);
+    }
+    ckfree((char *) smPtr);
+}
+
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * MaterializeLazyMethod --
+ *
+ *	Turn a method made from a shared class library into an ordinary
+ *	procedure-like method, in place, so that all call chains that refer to
+ *	it see the change. This is where the cost of making the procedure is
+ *	paid; its body is compiled the first time that it runs, as for any
+ *	other method.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+MaterializeLazyMethod(
+    Tcl_Interp *interp,		/* Interpreter for error reporting. */
+    Method *mPtr)		/* The method to convert. */
+{
+    LazyProcMethod *lpmPtr = mPtr->clientData;
+    SharedMethod *smPtr = lpmPtr->smPtr;
+    register ProcedureMethod *pmPtr;
+    Tcl_Obj *argsObj;
+    const char *procName;
+    int result;
+
+    procName = (smPtr->nameObj == NULL ? "<constructor>"
+	    : TclGetString(smPtr->nameObj));
+    pmPtr = (ProcedureMethod *) ckalloc(sizeof(ProcedureMethod));
+    memset(pmPtr, 0, sizeof(ProcedureMethod));
+    pmPtr->version = TCLOO_PROCEDURE_METHOD_VERSION;
+    pmPtr->flags = smPtr->flags & USE_DECLARER_NS;
+    pmPtr->refCount = 1;
+
+    /*
+     * Holding an extra reference to the shared body makes TclCreateProc
+     * take its own copy of it, so the bytecode that it is later compiled to
+     * is never seen by any other interpreter. (GetSharedProc does the same.)
+     */
+
+    argsObj = CopyOfString(smPtr->argsObj);
+    Tcl_IncrRefCount(argsObj);
+    if (mPtr->declaringClassPtr != NULL) {
+	result = GetSharedProc(interp, smPtr->flags, procName, argsObj,
+		smPtr->bodyObj, NULL, &pmPtr->procPtr);
+    } else {
+	Tcl_IncrRefCount(smPtr->bodyObj);
+	result = TclCreateProc(interp, NULL, procName, argsObj,
+		smPtr->bodyObj, &pmPtr->procPtr);
+	Tcl_DecrRefCount(smPtr->bodyObj);
+	if (result == TCL_OK) {
+	    pmPtr->procPtr->cmdPtr = NULL;
+	}
+    }
+    Tcl_DecrRefCount(argsObj);
+    if (result != TCL_OK) {
+	ckfree((char *) pmPtr);
+	return TCL_ERROR;
+    }
+    AnalyzeTrivialBody(pmPtr);
+
+    mPtr->typePtr = &procMethodType;
+    mPtr->clientData = pmPtr;
+    DeleteLazyMethod(lpmPtr);
+    return TCL_OK;
+}
+
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * InvokeLazyMethod, DeleteLazyMethod, CloneLazyMethod --
+ *
+ *	How to invoke, delete and clone a method made from a shared class
+ *	library that has not yet been converted into a procedure-like method.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+InvokeLazyMethod(
+    ClientData clientData,	/* Pointer to some per-method context. */
+    Tcl_Interp *interp,
+    Tcl_ObjectContext context,	/* The method calling context. */
+    int objc,			/* Number of arguments. */
+    Tcl_Obj *const *objv)	/* Arguments as actually seen. */
+{
+    Method *mPtr = (Method *) Tcl_ObjectContextMethod(context);
+
+    if (MaterializeLazyMethod(interp, mPtr) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    return mPtr->typePtr->callProc(mPtr->clientData, interp, context, objc,
+	    objv);
+}
+
+static void
+DeleteLazyMethod(
+    ClientData clientData)
+{
+    LazyProcMethod *lpmPtr = clientData;
+
+    TclOOReleaseSharedMethod(lpmPtr->smPtr);
+    ckfree((char *) lpmPtr);
+}
+
+static int
+CloneLazyMethod(
+    Tcl_Interp *interp,
+    ClientData clientData,
+    ClientData *newClientData)
+{
+    LazyProcMethod *lpmPtr = clientData;
+    LazyProcMethod *lpm2Ptr = (LazyProcMethod *)
+	    ckalloc(sizeof(LazyProcMethod));
+
+    lpm2Ptr->interp = interp;
+    lpm2Ptr->smPtr = lpmPtr->smPtr;
+    lpm2Ptr->smPtr->refCount++;
+    *newClientData = lpm2Ptr;
+    return TCL_OK;
+}
+
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * CopyOfString --
+ *
+ *	Make a new value with the same string as an existing one, but none of
+ *	its internal representation. Used to keep the values in shared class
+ *	libraries independent of every interpreter.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static inline Tcl_Obj *
+CopyOfString(
+    Tcl_Obj *objPtr)
+{
+    const char *bytes = TclGetString(objPtr);
+
+    return Tcl_NewStringObj(bytes, objPtr->length);
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOMemoizeMethod --
+ *
+ *	Wrap an existing method so that its results are remembered, keyed by
+ *	its arguments (or the named subset of them), and the real method is
+ *	only called when there is no result to hand. The remembered results
+ *	are thrown away when the class structure changes and, if variables
+ *	are named, when any of those variables of the object is written or
+ *	unset. The Method structure is updated in place, so redefining the
+ *	method gets rid of the wrapper.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+TclOOMemoizeMethod(
+    Tcl_Interp *interp,		/* Interpreter for error reporting. */
+    Method *mPtr,		/* The method to wrap. */
+    Tcl_Obj *keysObj,		/* List of names of the formal arguments that
+				 * the results depend upon, or NULL if they
+				 * depend on all the actual arguments. */
+    Tcl_Obj *varsObj)		/* List of names of object variables that the
+				 * results depend upon, or NULL. */
+{
+    const Tcl_MethodType *innerTypePtr;
+    ClientData innerClientData;
+    MemoMethod *memoPtr, *oldPtr = NULL;
+    Tcl_Obj **objv;
+    int objc, i, j;
+
+    if (mPtr->typePtr == &lazyMethodType
+	    && MaterializeLazyMethod(interp, mPtr) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    innerTypePtr = mPtr->typePtr;
+    innerClientData = mPtr->clientData;
+
+    if (innerTypePtr == &memoMethodType) {
+	oldPtr = innerClientData;
+	innerTypePtr = oldPtr->innerTypePtr;
+	innerClientData = oldPtr->innerClientData;
+    }
+
+    if (varsObj != NULL) {
+	if (Tcl_ListObjGetElements(interp, varsObj, &objc, &objv) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	for (i=0 ; i<objc ; i++) {
+	    const char *varName = TclGetString(objv[i]);
+
+	    if (varName[0] == '\0' || strstr(varName, "::") != NULL
+		    || strchr(varName, '(') != NULL) {
+		Tcl_AppendResult(interp, "bad variable name \"", varName,
+			"\": must be a simple variable name", NULL);
+		return TCL_ERROR;
+	    }
+	}
+	if (objc == 0) {
+	    varsObj = NULL;
+	}
+    }
+
+    memoPtr = (MemoMethod *) ckalloc(sizeof(MemoMethod));
+    memoPtr->numKeys = 0;
+    memoPtr->keyIndices = NULL;
+    memoPtr->restIndex = -1;
+    memoPtr->minArgs = 0;
+    memoPtr->maxArgs = -1;
+
+    /*
+     * Work out where the arguments named in the key are. This needs the
+     * formal argument list, so only works for procedure-like methods.
+     */
+
+    if (keysObj != NULL) {
+	Proc *procPtr;
+	CompiledLocal *localPtr;
+
+	if (Tcl_ListObjGetElements(interp, keysObj, &objc, &objv) != TCL_OK) {
+	    ckfree((char *) memoPtr);
+	    return TCL_ERROR;
+	}
+	if (innerTypePtr != &procMethodType) {
+	    Tcl_AppendResult(interp, "only procedure-like methods can be ",
+		    "memoized on selected arguments", NULL);
+	    ckfree((char *) memoPtr);
+	    return TCL_ERROR;
+	}
+	procPtr = ((ProcedureMethod *) innerClientData)->procPtr;
+	memoPtr->keyIndices = (int *) ckalloc(sizeof(int) * (objc + 1));
+	for (i=0 ; i<objc ; i++) {
+	    const char *keyName = TclGetString(objv[i]);
+
+	    for (j=0,localPtr=procPtr->firstLocalPtr ; j<procPtr->numArgs ;
+		    j++,localPtr=localPtr->nextPtr) {
+		if (strcmp(localPtr->name, keyName) == 0) {
+		    break;
+		}
+	    }
+	    if (j == procPtr->numArgs) {
+		Tcl_AppendResult(interp, "method has no argument \"", keyName,
+			"\"", NULL);
+		ckfree((char *) memoPtr->keyIndices);
+		ckfree((char *) memoPtr);
+		return TCL_ERROR;
+	    }
+	    if (localPtr->flags & VAR_IS_ARGS) {
+		memoPtr->restIndex = j;
+	    } else {
+		memoPtr->keyIndices[memoPtr->numKeys++] = j;
+	    }
+	}
+
+	/*
+	 * Remember how many arguments the method accepts, as a call with the
+	 * wrong number must still go through to the method to be reported.
+	 */
+
+	memoPtr->maxArgs = procPtr->numArgs;
+	for (j=0,localPtr=procPtr->firstLocalPtr ; j<procPtr->numArgs ;
+		j++,localPtr=localPtr->nextPtr) {
+	    if (localPtr->flags & VAR_IS_ARGS) {
+		memoPtr->maxArgs = -1;
+	    } else if (localPtr->defValuePtr == NULL) {
+		memoPtr->minArgs = j + 1;
+	    }
+	}
+    }
+
+    memoPtr->innerTypePtr = innerTypePtr;
+    memoPtr->innerClientData = innerClientData;
+    memoPtr->refCount = 1;
+    memoPtr->varsObj = varsObj;
+    if (varsObj != NULL) {
+	Tcl_IncrRefCount(varsObj);
+    }
+    memoPtr->classCachesPtr = NULL;
+
+    /*
+     * If the method was already memoized, the old wrapper gives up the
+     * wrapped method to the new one.
+     */
+
+    if (oldPtr != NULL) {
+	oldPtr->innerTypePtr = NULL;
+	ReleaseMemo(oldPtr);
+    }
+    mPtr->typePtr = &memoMethodType;
+    mPtr->clientData = memoPtr;
+    return TCL_OK;
+}
+
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * InvokeMemoizedMethod --
+ *
+ *	How to invoke a memoized method. If a result is remembered for the
+ *	arguments, that is the result; otherwise the wrapped method is called
+ *	and, if it succeeds, its result is remembered. A result is not
+ *	remembered if anything that it depends upon changed while it was being
+ *	computed.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+InvokeMemoizedMethod(
+    ClientData clientData,	/* Pointer to some per-method context. */
+    Tcl_Interp *interp,
+    Tcl_ObjectContext context,	/* The method calling context. */
+    int objc,			/* Number of arguments. */
+    Tcl_Obj *const *objv)	/* Arguments as actually seen. */
+{
+    MemoMethod *memoPtr = clientData;
+    CallContext *contextPtr = (CallContext *) context;
+    Object *oPtr = contextPtr->oPtr;
+    MemoCache *cachePtr, *firstCachePtr;
+    Tcl_HashEntry *hPtr;
+    Tcl_Obj *keyObj, *resultObj;
+    int result, isNew, generation, epoch, objectEpoch;
+
+    keyObj = MemoKey(memoPtr, objc - contextPtr->skip,
+	    objv + contextPtr->skip);
+    if (keyObj == NULL) {
+	return memoPtr->innerTypePtr->callProc(memoPtr->innerClientData,
+		interp, context, objc, objv);
+    }
+    Tcl_IncrRefCount(keyObj);
+
+    cachePtr = GetMemoCache(memoPtr, oPtr);
+    hPtr = Tcl_FindHashEntry(&cachePtr->results, (char *) keyObj);
+    if (hPtr != NULL) {
+	Tcl_SetObjResult(interp, Tcl_GetHashValue(hPtr));
+	Tcl_DecrRefCount(keyObj);
+	return TCL_OK;
+    }
+
+    firstCachePtr = cachePtr;
+    generation = cachePtr->generation;
+    epoch = cachePtr->epoch;
+    objectEpoch = cachePtr->objectEpoch;
+    memoPtr->refCount++;
+    result = memoPtr->innerTypePtr->callProc(memoPtr->innerClientData,
+	    interp, context, objc, objv);
+
+    /*
+     * The method may have been redefined, the object deleted or its class
+     * changed while the result was being worked out, so check before
+     * remembering it.
+     */
+
+    if (result == TCL_OK && memoPtr->innerTypePtr != NULL
+	    && oPtr->namespacePtr != NULL) {
+	cachePtr = GetMemoCache(memoPtr, oPtr);
+	if (cachePtr == firstCachePtr && cachePtr->generation == generation
+		&& cachePtr->epoch == epoch
+		&& cachePtr->objectEpoch == objectEpoch) {
+	    if (cachePtr->results.numEntries >= MEMO_CACHE_SIZE) {
+		ClearMemoCache(cachePtr);
+	    }
+	    hPtr = Tcl_CreateHashEntry(&cachePtr->results, (char *) keyObj,
+		    &isNew);
+	    resultObj = Tcl_GetObjResult(interp);
+	    Tcl_IncrRefCount(resultObj);
+	    if (!isNew) {
+		Tcl_DecrRefCount((Tcl_Obj *) Tcl_GetHashValue(hPtr));
+	    }
+	    Tcl_SetHashValue(hPtr, resultObj);
+	}
+    }
+    ReleaseMemo(memoPtr);
+    Tcl_DecrRefCount(keyObj);
+    return result;
+}
+
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * MemoKey --
+ *
+ *	Produce the value that identifies a call to a memoized method, or NULL
+ *	if the call should just be passed through to the wrapped method (so
+ *	that it can complain about the number of arguments).
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static Tcl_Obj *
+MemoKey(
+    MemoMethod *memoPtr,
+    int objc,			/* Number of arguments, excluding those that
+				 * select the method. */
+    Tcl_Obj *const *objv)
+{
+    Tcl_Obj *keyObj;
+    int i;
+
+    if (memoPtr->keyIndices == NULL) {
+	return Tcl_NewListObj(objc, objv);
+    }
+    if (objc < memoPtr->minArgs
+	    || (memoPtr->maxArgs >= 0 && objc > memoPtr->maxArgs)) {
+	return NULL;
+    }
+    for (i=0 ; i<memoPtr->numKeys ; i++) {
+	if (memoPtr->keyIndices[i] >= objc) {
+	    return NULL;
+	}
+    }
+    if (memoPtr->numKeys == 1 && memoPtr->restIndex < 0) {
+	return objv[memoPtr->keyIndices[0]];
+    }
+
+    keyObj = Tcl_NewObj();
+    for (i=0 ; i<memoPtr->numKeys ; i++) {
+	Tcl_ListObjAppendElement(NULL, keyObj, objv[memoPtr->keyIndices[i]]);
+    }
+    if (memoPtr->restIndex >= 0) {
+	int numRest = objc - memoPtr->restIndex;
+
+	Tcl_ListObjAppendElement(NULL, keyObj, Tcl_NewListObj(
+		(numRest > 0 ? numRest : 0), objv + memoPtr->restIndex));
+    }
+    return keyObj;
+}
+
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * GetMemoCache, ClearMemoCache, DeleteMemoCache --
+ *
+ *	Manage the tables of remembered results. Getting the table for an
+ *	object (or for its class) also makes sure that the variables the
+ *	results depend upon are being traced, and throws away results from an
+ *	older class structure.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static MemoCache *
+GetMemoCache(
+    MemoMethod *memoPtr,
+    Object *oPtr)
+{
+    Tcl_HashTable *tablePtr;
+    Tcl_HashEntry *hPtr;
+    MemoCache *cachePtr;
+    int isNew, classEpoch = oPtr->selfCls->thisPtr->creationEpoch;
+
+    if (memoPtr->varsObj == NULL) {
+	tablePtr = memoPtr->classCachesPtr;
+	if (tablePtr == NULL) {
+	    tablePtr = (Tcl_HashTable *) ckalloc(sizeof(Tcl_HashTable));
+	    Tcl_InitHashTable(tablePtr, TCL_ONE_WORD_KEYS);
+	    memoPtr->classCachesPtr = tablePtr;
+	}
+	hPtr = Tcl_CreateHashEntry(tablePtr, (char *) oPtr->selfCls, &isNew);
+    } else {
+	tablePtr = Tcl_ObjectGetMetadata((Tcl_Object) oPtr,
+		&memoMetadataType);
+	if (tablePtr == NULL) {
+	    tablePtr = (Tcl_HashTable *) ckalloc(sizeof(Tcl_HashTable));
+	    Tcl_InitHashTable(tablePtr, TCL_ONE_WORD_KEYS);
+	    Tcl_ObjectSetMetadata((Tcl_Object) oPtr, &memoMetadataType,
+		    tablePtr);
+	}
+	hPtr = Tcl_CreateHashEntry(tablePtr, (char *) memoPtr, &isNew);
+    }
+    cachePtr = Tcl_GetHashValue(hPtr);
+
+    if (cachePtr == NULL) {
+	cachePtr = (MemoCache *) ckalloc(sizeof(MemoCache));
+	cachePtr->memoPtr = memoPtr;
+	Tcl_InitObjHashTable(&cachePtr->results);
+	cachePtr->epoch = oPtr->fPtr->epoch;
+	cachePtr->objectEpoch = oPtr->epoch;
+	cachePtr->classEpoch = classEpoch;
+	cachePtr->generation = 0;
+	cachePtr->tracedNamesObj = NULL;
+	if (memoPtr->varsObj == NULL) {
+	    cachePtr->oPtr = NULL;
+	} else {
+	    cachePtr->oPtr = oPtr;
+	    memoPtr->refCount++;
+	}
+	Tcl_SetHashValue(hPtr, cachePtr);
+    }
+
+    if (cachePtr->epoch != oPtr->fPtr->epoch || (cachePtr->oPtr != NULL
+	    ? cachePtr->objectEpoch != oPtr->epoch
+	    : cachePtr->classEpoch != classEpoch)) {
+	ClearMemoCache(cachePtr);
+	cachePtr->epoch = oPtr->fPtr->epoch;
+	cachePtr->objectEpoch = oPtr->epoch;
+	cachePtr->classEpoch = classEpoch;
+    }
+
+    /*
+     * Trace the variables that the results depend upon. The traces are
+     * removed when any of the variables is unset, and put back here.
+     */
+
+    if (cachePtr->oPtr != NULL && cachePtr->tracedNamesObj == NULL) {
+	Tcl_Obj **varv, *nameObj;
+	int varc, i;
+
+	cachePtr->tracedNamesObj = Tcl_NewObj();
+	Tcl_IncrRefCount(cachePtr->tracedNamesObj);
+	Tcl_ListObjGetElements(NULL, memoPtr->varsObj, &varc, &varv);
+	for (i=0 ; i<varc ; i++) {
+	    nameObj = Tcl_NewStringObj(oPtr->namespacePtr->fullName, -1);
+	    Tcl_AppendToObj(nameObj, "::", 2);
+	    Tcl_AppendObjToObj(nameObj, varv[i]);
+	    Tcl_ListObjAppendElement(NULL, cachePtr->tracedNamesObj, nameObj);
+	    Tcl_TraceVar(oPtr->fPtr->interp, TclGetString(nameObj),
+		    TCL_GLOBAL_ONLY | TCL_TRACE_WRITES | TCL_TRACE_UNSETS,
+		    MemoVarTraceProc, cachePtr);
+	}
+    }
+    return cachePtr;
+}
+
+static void
+ClearMemoCache(
+    MemoCache *cachePtr)
+{
+    FOREACH_HASH_DECLS;
+    Tcl_Obj *resultObj;
+
+    FOREACH_HASH_VALUE(resultObj, &cachePtr->results) {
+	Tcl_DecrRefCount(resultObj);
+    }
+    Tcl_DeleteHashTable(&cachePtr->results);
+    Tcl_InitObjHashTable(&cachePtr->results);
+    cachePtr->generation++;
+}
+
+static void
+DeleteMemoCache(
+    MemoCache *cachePtr)
+{
+    FOREACH_HASH_DECLS;
+    Tcl_Obj *resultObj;
+
+    UntraceMemoVars(cachePtr);
+    FOREACH_HASH_VALUE(resultObj, &cachePtr->results) {
+	Tcl_DecrRefCount(resultObj);
+    }
+    Tcl_DeleteHashTable(&cachePtr->results);
+    if (cachePtr->oPtr != NULL) {
+	ReleaseMemo(cachePtr->memoPtr);
+    }
+    ckfree((char *) cachePtr);
+}
+
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * UntraceMemoVars, MemoVarTraceProc --
+ *
+ *	Manage the traces that throw away the remembered results of a method
+ *	when a variable that they depend upon changes.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static void
+UntraceMemoVars(
+    MemoCache *cachePtr)
+{
+    Tcl_Obj **namev;
+    int namec, i;
+
+    if (cachePtr->tracedNamesObj == NULL) {
+	return;
+    }
+    Tcl_ListObjGetElements(NULL, cachePtr->tracedNamesObj, &namec, &namev);
+    for (i=0 ; i<namec ; i++) {
+	Tcl_UntraceVar(cachePtr->oPtr->fPtr->interp, TclGetString(namev[i]),
+		TCL_GLOBAL_ONLY | TCL_TRACE_WRITES | TCL_TRACE_UNSETS,
+		MemoVarTraceProc, cachePtr);
+    }
+    Tcl_DecrRefCount(cachePtr->tracedNamesObj);
+    cachePtr->tracedNamesObj = NULL;
+}
+
+static char *
+MemoVarTraceProc(
+    ClientData clientData,
+    Tcl_Interp *interp,
+    const char *name1,
+    const char *name2,
+    int flags)
+{
+    MemoCache *cachePtr = clientData;
+
+    ClearMemoCache(cachePtr);
+    if (flags & TCL_TRACE_DESTROYED) {
+	UntraceMemoVars(cachePtr);
+    }
+    return NULL;
+}
+
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * ReleaseMemo, DeleteMemoizedMethod, CloneMemoizedMethod --
+ *
+ *	How to manage the lifetime of memoized methods. The wrapper structure
+ *	lives on after the method is deleted for as long as any object has
+ *	results remembered for it, so that it cannot be confused with any
+ *	other wrapper.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static void
+ReleaseMemo(
+    MemoMethod *memoPtr)
+{
+    if (--memoPtr->refCount > 0) {
+	return;
+    }
+    if (memoPtr->classCachesPtr != NULL) {
+	FOREACH_HASH_DECLS;
+	MemoCache *cachePtr;
+
+	FOREACH_HASH_VALUE(cachePtr, memoPtr->classCachesPtr) {
+	    DeleteMemoCache(cachePtr);
+	}
+	Tcl_DeleteHashTable(memoPtr->classCachesPtr);
+	ckfree((char *) memoPtr->classCachesPtr);
+    }
+    if (memoPtr->keyIndices != NULL) {
+	ckfree((char *) memoPtr->keyIndices);
+    }
+    if (memoPtr->varsObj != NULL) {
+	Tcl_DecrRefCount(memoPtr->varsObj);
+    }
+    ckfree((char *) memoPtr);
+}
+
+static void
+DeleteMemoizedMethod(
+    ClientData clientData)
+{
+    MemoMethod *memoPtr = clientData;
+
+    if (memoPtr->innerTypePtr != NULL
+	    && memoPtr->innerTypePtr->deleteProc != NULL) {
+	memoPtr->innerTypePtr->deleteProc(memoPtr->innerClientData);
+    }
+    memoPtr->innerTypePtr = NULL;
+    ReleaseMemo(memoPtr);
+}
+
+static int
+CloneMemoizedMethod(
+    Tcl_Interp *interp,
+    ClientData clientData,
+    ClientData *newClientData)
+{
+    MemoMethod *memoPtr = clientData;
+    MemoMethod *memo2Ptr;
+    ClientData innerClientData = memoPtr->innerClientData;
+
+    if (memoPtr->innerTypePtr->cloneProc != NULL
+	    && memoPtr->innerTypePtr->cloneProc(interp,
+		    memoPtr->innerClientData, &innerClientData) != TCL_OK) {
+	return TCL_ERROR;
+    }
+
+    memo2Ptr = (MemoMethod *) ckalloc(sizeof(MemoMethod));
+    *memo2Ptr = *memoPtr;
+    memo2Ptr->innerClientData = innerClientData;
+    memo2Ptr->refCount = 1;
+    memo2Ptr->classCachesPtr = NULL;
+    if (memoPtr->keyIndices != NULL) {
+	memo2Ptr->keyIndices = (int *)
+		ckalloc(sizeof(int) * (memoPtr->numKeys + 1));
+	memcpy(memo2Ptr->keyIndices, memoPtr->keyIndices,
+		sizeof(int) * memoPtr->numKeys);
+    }
+    if (memo2Ptr->varsObj != NULL) {
+	Tcl_IncrRefCount(memo2Ptr->varsObj);
+    }
+    *newClientData = memo2Ptr;
+    return TCL_OK;
+}
+
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * DeleteMemoMetadata, CloneMemoMetadata --
+ *
+ *	How to manage the per-object tables of remembered results. These are
+ *	never copied, as the copy must trace its own variables.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static void
+DeleteMemoMetadata(
+    ClientData clientData)
+{
+    Tcl_HashTable *tablePtr = clientData;
+    FOREACH_HASH_DECLS;
+    MemoCache *cachePtr;
+
+    FOREACH_HASH_VALUE(cachePtr, tablePtr) {
+	DeleteMemoCache(cachePtr);
+    }
+    Tcl_DeleteHashTable(tablePtr);
+    ckfree((char *) tablePtr);
+}
+
+static int
+CloneMemoMetadata(
+    Tcl_Interp *interp,
+    ClientData oldClientData,
+    ClientData *newClientData)
+{
+    *newClientData = NULL;
+    return TCL_OK;
+}
+
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOGetProcFromMethod, TclOOGetFwdFromMethod --
+ *
+ *	Utility functions used for procedure-like and forwarding method
+ *	introspection. These look through any memoizing wrapper, and turn
+ *	methods made from shared class libraries into real procedures.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static inline const Tcl_MethodType *
+UnwrapMethod(
+    Method *mPtr,
+    ClientData *clientDataPtr)
+{
+    if (mPtr->typePtr == &lazyMethodType) {
+	/*
+	 * Introspection needs the real procedure. This can fail (e.g., when
+	 * the method was loaded from an image file with a bad argument list),
+	 * in which case the method stays lazy and the callers find no
+	 * procedure or forward in it, just as for any other kind of method.
+	 * The interpreter's result must not be disturbed either way.
+	 */
+
+	Tcl_Interp *interp = ((LazyProcMethod *) mPtr->clientData)->interp;
+	Tcl_InterpState state = Tcl_SaveInterpState(interp, TCL_OK);
+
+	(void) MaterializeLazyMethod(interp, mPtr);
+	Tcl_RestoreInterpState(interp, state);
+    }
+    if (mPtr->typePtr == &memoMethodType) {
+	MemoMethod *memoPtr = mPtr->clientData;
+
+	*clientDataPtr = memoPtr->innerClientData;
+	return memoPtr->innerTypePtr;
+    }
+    *clientDataPtr = mPtr->clientData;
+    return mPtr->typePtr;
+}
+
+Proc *
+TclOOGetProcFromMethod(
+    Method *mPtr)
+{
+    ClientData clientData;
+
+    if (UnwrapMethod(mPtr, &clientData) == &procMethodType) {
+	ProcedureMethod *pmPtr = clientData;
+
+	return pmPtr->procPtr;
+    }
+    return NULL;
+}
+
+Tcl_Obj *
+TclOOGetMethodBody(
+    Method *mPtr)
+{
+    ClientData clientData;
+
+    if (UnwrapMethod(mPtr, &clientData) == &procMethodType) {
+	ProcedureMethod *pmPtr = clientData;
+
+	if (pmPtr->procPtr->bodyPtr->bytes == NULL) {
+	    (void) Tcl_GetString(pmPtr->procPtr->bodyPtr);
+	}
+	return pmPtr->procPtr->bodyPtr;
+    }
+    return NULL;
+}
+
+Tcl_Obj *
+TclOOGetFwdFromMethod(
+    Method *mPtr)
+{
+    ClientData clientData;
+
+    if (UnwrapMethod(mPtr, &clientData) == &fwdMethodType) {
+	ForwardMethod *fwPtr = clientData;
 
 	return fwPtr->prefixObj;
     }
@@ -0,0 +1,1414 @@
+/*
+ * tclOOShare.c --
+ *
+ *	This file contains the implementation of the [oo::share] command,
+ *	which allows a hierarchy of classes to be defined once and then set up
+ *	cheaply in any number of interpreters belonging to the same thread,
+ *	and allows such a set of classes to be saved to a file and loaded from
+ *	it again by a later process.
+ *
+ * Copyright (c) 2026 by agent
+ *
+ * See the file "license.terms" for information on usage and redistribution of
+ * this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "tclInt.h"
+#include "tclOOInt.h"
+
+/*
+ * The description of one class in a shared class library. Every value here
+ * is a plain string that no interpreter has ever seen, and the methods are
+ * described by SharedMethod records, so a library can be used by any
+ * interpreter in the thread that it was made in. Classes are referred to by
+ * their fully-qualified names, so a library may use classes that are not in
+ * it as long as the importing interpreter has them.
+ */
+
+typedef struct SharedClass {
+    Tcl_Obj *nameObj;		/* Fully-qualified name of the class. */
+    Tcl_Obj *metaclassObj;	/* Name of the class of the class. */
+    Tcl_Obj *superclassesObj;	/* List of names of the superclasses. */
+    Tcl_Obj *mixinsObj;		/* List of names of the mixed-in classes. */
+    Tcl_Obj *filtersObj;	/* List of names of the filter methods. */
+    Tcl_Obj *variablesObj;	/* List of declared variable names. */
+    SharedMethod *constructorPtr;
+				/* The constructor, or NULL if none. */
+    SharedMethod *destructorPtr;/* The destructor, or NULL if none. */
+    int numMethods;		/* Number of methods of the class. */
+    SharedMethod **methods;	/* The methods of the class. */
+    int numSelfMethods;		/* Number of methods of the class object
+				 * itself. */
+    SharedMethod **selfMethods;	/* The methods of the class object itself. */
+} SharedClass;
+
+/*
+ * A shared class library. The classes are in an order where each comes after
+ * its superclasses, mixins and metaclass (where those are in the library
+ * too), so that they can be made in that order.
+ */
+
+typedef struct SharedLibrary {
+    int numClasses;		/* Number of classes in the library. */
+    SharedClass *classes;	/* Array of class descriptions. */
+} SharedLibrary;
+
+/*
+ * Function declarations for things defined in this file.
+ */
+
+static int		CollectClasses(Tcl_Interp *interp, int objc,
+			    Tcl_Obj *const *objv, Tcl_HashTable *tablePtr,
+			    Class ***classesPtr);
+static int		OrderClasses(Tcl_Interp *interp, Class *clsPtr,
+			    Tcl_HashTable *tablePtr, Class **order,
+			    int *numPtr);
+static int		DescribeClass(Tcl_Interp *interp, Class *clsPtr,
+			    SharedClass *scPtr);
+static int		DescribeMethodTable(Tcl_Interp *interp,
+			    Tcl_HashTable *tablePtr, Object *oPtr,
+			    int *numPtr, SharedMethod ***methodsPtr);
+static Tcl_Obj *	ClassListString(Tcl_Interp *interp, int numClasses,
+			    Class *const *classes);
+static Tcl_Obj *	ObjListString(int objc, Tcl_Obj *const *objv);
+static int		ImportLibrary(Tcl_Interp *interp,
+			    SharedLibrary *libPtr);
+static int		ConfigureClass(Tcl_Interp *interp, Class *clsPtr,
+			    SharedClass *scPtr);
+static Class *		LookupClass(Tcl_Interp *interp, Tcl_Obj *nameObj);
+static int		CheckNewLibraryName(Tcl_Interp *interp,
+			    ThreadLocalData *tsdPtr, Tcl_Obj *nameObj);
+static void		RegisterLibrary(Tcl_Interp *interp,
+			    ThreadLocalData *tsdPtr, Tcl_Obj *nameObj,
+			    SharedLibrary *libPtr);
+static int		WriteLibraryImage(Tcl_Interp *interp,
+			    SharedLibrary *libPtr, Tcl_Obj *fileNameObj);
+static void		PutMethod(Tcl_DString *dsPtr, SharedMethod *smPtr);
+static SharedLibrary *	ReadLibraryImage(Tcl_Interp *interp,
+			    Tcl_Obj *fileNameObj);
+static int		GetClass(SerialReader *rPtr, SharedClass *scPtr);
+static int		GetMethodList(SerialReader *rPtr, int *numPtr,
+			    SharedMethod ***methodsPtr);
+static SharedMethod *	GetMethod(SerialReader *rPtr, int isNamed);
+static void		FreeSharedClass(SharedClass *scPtr);
+static void		FreeSharedLibrary(SharedLibrary *libPtr);
+static void		FreeSharedLibraries(ClientData clientData);
+
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOShareObjCmd --
+ *
+ *	Implementation of the [oo::share] command, which manages the libraries
+ *	of classes shared between the interpreters of a thread. Libraries are
+ *	made with [oo::share export] from a set of classes and all their
+ *	subclasses, and are set up in other interpreters with [oo::share
+ *	import]; that is much cheaper than running the definitions again, as
+ *	the bodies of procedure-like methods are only turned into procedures
+ *	and compiled when they are first called. Libraries may also be saved
+ *	to a file with [oo::share save] and read back, in this or any other
+ *	process, with [oo::share load]. Safe interpreters may import libraries
+ *	but not make, forget, save or load them.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+TclOOShareObjCmd(
+    ClientData clientData,
+    Tcl_Interp *interp,
+    int objc,
+    Tcl_Obj *const *objv)
+{
+    static const char *subcmds[] = {
+	"export", "forget", "import", "load", "names", "save", NULL
+    };
+    enum ShareSubcmds {
+	SHARE_EXPORT, SHARE_FORGET, SHARE_IMPORT, SHARE_LOAD, SHARE_NAMES,
+	SHARE_SAVE
+    };
+    ThreadLocalData *tsdPtr = TclOOGetFoundation(interp)->tsdPtr;
+    SharedLibrary *libPtr;
+    Tcl_HashEntry *hPtr;
+    int idx;
+
+    if (objc < 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "subcommand ?arg ...?");
+	return TCL_ERROR;
+    }
+    if (Tcl_GetIndexFromObj(interp, objv[1], subcmds, "subcommand", 0,
+	    &idx) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    if (idx != SHARE_IMPORT && idx != SHARE_NAMES && Tcl_IsSafe(interp)) {
+	Tcl_AppendResult(interp, "may not ", subcmds[idx],
+		" class libraries in a safe interpreter", NULL);
+	return TCL_ERROR;
+    }
+
+    switch ((enum ShareSubcmds) idx) {
+    case SHARE_EXPORT: {
+	Tcl_HashTable table;
+	Class **collected, **order;
+	int num, i;
+
+	if (objc < 4) {
+	    Tcl_WrongNumArgs(interp, 2, objv,
+		    "libName className ?className ...?");
+	    return TCL_ERROR;
+	}
+	if (CheckNewLibraryName(interp, tsdPtr, objv[2]) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+
+	/*
+	 * Work out which classes are in the library and what order to make
+	 * them in. The value in the table says how far through ordering each
+	 * class is: 0 for not yet, 1 for in progress, and 2 for done.
+	 */
+
+	Tcl_InitHashTable(&table, TCL_ONE_WORD_KEYS);
+	num = CollectClasses(interp, objc-3, objv+3, &table, &collected);
+	if (num < 0) {
+	    Tcl_DeleteHashTable(&table);
+	    return TCL_ERROR;
+	}
+	order = (Class **) ckalloc(sizeof(Class *) * num);
+	idx = 0;
+	for (i=0 ; i<num ; i++) {
+	    if (OrderClasses(interp, collected[i], &table, order,
+		    &idx) != TCL_OK) {
+		ckfree((char *) order);
+		ckfree((char *) collected);
+		Tcl_DeleteHashTable(&table);
+		return TCL_ERROR;
+	    }
+	}
+	ckfree((char *) collected);
+	Tcl_DeleteHashTable(&table);
+
+	/*
+	 * Describe each class. Nothing is published unless they can all be
+	 * described.
+	 */
+
+	libPtr = (SharedLibrary *) ckalloc(sizeof(SharedLibrary));
+	libPtr->classes = (SharedClass *) ckalloc(sizeof(SharedClass) * num);
+	libPtr->numClasses = 0;
+	for (i=0 ; i<num ; i++) {
+	    if (DescribeClass(interp, order[i],
+		    &libPtr->classes[i]) != TCL_OK) {
+		ckfree((char *) order);
+		FreeSharedLibrary(libPtr);
+		return TCL_ERROR;
+	    }
+	    libPtr->numClasses++;
+	}
+	ckfree((char *) order);
+
+	RegisterLibrary(interp, tsdPtr, objv[2], libPtr);
+	return TCL_OK;
+    }
+
+    case SHARE_LOAD:
+	if (objc != 4) {
+	    Tcl_WrongNumArgs(interp, 2, objv, "libName fileName");
+	    return TCL_ERROR;
+	}
+	if (CheckNewLibraryName(interp, tsdPtr, objv[2]) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	libPtr = ReadLibraryImage(interp, objv[3]);
+	if (libPtr == NULL) {
+	    return TCL_ERROR;
+	}
+	RegisterLibrary(interp, tsdPtr, objv[2], libPtr);
+	return TCL_OK;
+
+    case SHARE_FORGET:
+    case SHARE_IMPORT:
+    case SHARE_SAVE:
+	if (objc != (idx == SHARE_SAVE ? 4 : 3)) {
+	    Tcl_WrongNumArgs(interp, 2, objv,
+		    (idx == SHARE_SAVE ? "libName fileName" : "libName"));
+	    return TCL_ERROR;
+	}
+	hPtr = NULL;
+	if (tsdPtr->sharedLibraries != NULL) {
+	    hPtr = Tcl_FindHashEntry(tsdPtr->sharedLibraries,
+		    TclGetString(objv[2]));
+	}
+	if (hPtr == NULL) {
+	    Tcl_AppendResult(interp, "unknown class library \"",
+		    TclGetString(objv[2]), "\"", NULL);
+	    return TCL_ERROR;
+	}
+	libPtr = Tcl_GetHashValue(hPtr);
+	if (idx == SHARE_IMPORT) {
+	    return ImportLibrary(interp, libPtr);
+	} else if (idx == SHARE_SAVE) {
+	    return WriteLibraryImage(interp, libPtr, objv[3]);
+	}
+
+	/*
+	 * Methods that were made from the library keep their own references
+	 * to what they need, so the library can go at once.
+	 */
+
+	Tcl_DeleteHashEntry(hPtr);
+	FreeSharedLibrary(libPtr);
+	return TCL_OK;
+
+    case SHARE_NAMES:
+	if (objc != 2) {
+	    Tcl_WrongNumArgs(interp, 2, objv, NULL);
+	    return TCL_ERROR;
+	} else {
+	    Tcl_Obj *resultObj = Tcl_NewObj();
+
+	    if (tsdPtr->sharedLibraries != NULL) {
+		Tcl_HashSearch search;
+
+		for (hPtr=Tcl_FirstHashEntry(tsdPtr->sharedLibraries, &search);
+			hPtr!=NULL ; hPtr=Tcl_NextHashEntry(&search)) {
+		    Tcl_ListObjAppendElement(NULL, resultObj, Tcl_NewStringObj(
+			    Tcl_GetHashKey(tsdPtr->sharedLibraries, hPtr),
+			    -1));
+		}
+	    }
+	    Tcl_SetObjResult(interp, resultObj);
+	}
+	return TCL_OK;
+    }
+    return TCL_ERROR;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * CollectClasses --
+ *
+ *	Find the named classes and all their subclasses, refusing the classes
+ *	at the root of the class system (which every interpreter has already).
+ *	Returns the number of classes found, and writes an array of them that
+ *	the caller must free; also enters each class in the given table with a
+ *	value of 0. Returns -1 on error.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+CollectClasses(
+    Tcl_Interp *interp,		/* Interpreter for error reporting. */
+    int objc,			/* Number of class names. */
+    Tcl_Obj *const *objv,	/* The class names. */
+    Tcl_HashTable *tablePtr,	/* Table of classes found. */
+    Class ***classesPtr)	/* Where to write the array of classes. */
+{
+    Foundation *fPtr = TclOOGetFoundation(interp);
+    Class **classes, *clsPtr, *subPtr;
+    int num = 0, size = objc, isNew, i, j;
+    Tcl_HashEntry *hPtr;
+
+    classes = (Class **) ckalloc(sizeof(Class *) * size);
+    for (j=0 ; j<objc ; j++) {
+	clsPtr = LookupClass(interp, objv[j]);
+	if (clsPtr == NULL) {
+	    goto failed;
+	}
+	hPtr = Tcl_CreateHashEntry(tablePtr, (char *) clsPtr, &isNew);
+	if (isNew) {
+	    Tcl_SetHashValue(hPtr, INT2PTR(0));
+	    classes[num++] = clsPtr;
+	}
+    }
+
+    /*
+     * The array of classes doubles as the queue of classes whose subclasses
+     * are still to be looked at.
+     */
+
+    for (j=0 ; j<num ; j++) {
+	clsPtr = classes[j];
+	if (clsPtr == fPtr->objectCls || clsPtr == fPtr->classCls) {
+	    Tcl_AppendResult(interp, "may not share the root class \"",
+		    TclGetString(TclOOObjectName(interp, clsPtr->thisPtr)),
+		    "\"", NULL);
+	    goto failed;
+	}
+	FOREACH(subPtr, clsPtr->subclasses) {
+	    hPtr = Tcl_CreateHashEntry(tablePtr, (char *) subPtr, &isNew);
+	    if (!isNew) {
+		continue;
+	    }
+	    Tcl_SetHashValue(hPtr, INT2PTR(0));
+	    if (num >= size) {
+		size *= 2;
+		classes = (Class **) ckrealloc((char *) classes,
+			sizeof(Class *) * size);
+	    }
+	    classes[num++] = subPtr;
+	}
+    }
+    *classesPtr = classes;
+    return num;
+
+  failed:
+    ckfree((char *) classes);
+    return -1;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * OrderClasses --
+ *
+ *	Put a class into the order in which the classes of a library are to
+ *	be made, after the classes of the library that it depends on.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+OrderClasses(
+    Tcl_Interp *interp,		/* Interpreter for error reporting. */
+    Class *clsPtr,		/* The class to place. */
+    Tcl_HashTable *tablePtr,	/* Table of the classes of the library, with
+				 * how far through ordering each is. */
+    Class **order,		/* The order being built. */
+    int *numPtr)		/* How many classes have been placed. */
+{
+    Tcl_HashEntry *hPtr = Tcl_FindHashEntry(tablePtr, (char *) clsPtr);
+    Class *depPtr;
+    int i;
+
+    if (hPtr == NULL || PTR2INT(Tcl_GetHashValue(hPtr)) == 2) {
+	return TCL_OK;
+    } else if (PTR2INT(Tcl_GetHashValue(hPtr)) == 1) {
+	Tcl_AppendResult(interp, "may not share class \"",
+		TclGetString(TclOOObjectName(interp, clsPtr->thisPtr)),
+		"\": it depends on itself through its mixins", NULL);
+	return TCL_ERROR;
+    }
+    Tcl_SetHashValue(hPtr, INT2PTR(1));
+
+    if (OrderClasses(interp, clsPtr->thisPtr->selfCls, tablePtr, order,
+	    numPtr) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    FOREACH(depPtr, clsPtr->superclasses) {
+	if (OrderClasses(interp, depPtr, tablePtr, order,
+		numPtr) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+    }
+    FOREACH(depPtr, clsPtr->mixins) {
+	if (OrderClasses(interp, depPtr, tablePtr, order,
+		numPtr) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+    }
+
+    Tcl_SetHashValue(hPtr, INT2PTR(2));
+    order[(*numPtr)++] = clsPtr;
+    return TCL_OK;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * DescribeClass --
+ *
+ *	Fill in the description of a class for a shared class library. Fails
+ *	if the class has anything that cannot be described without reference
+ *	to the interpreter it belongs to.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+DescribeClass(
+    Tcl_Interp *interp,		/* Interpreter for error reporting. */
+    Class *clsPtr,		/* The class to describe. */
+    SharedClass *scPtr)		/* Where to write the description. */
+{
+    Object *oPtr = clsPtr->thisPtr;
+    const char *className = TclGetString(TclOOObjectName(interp, oPtr));
+
+    if (oPtr->mixins.num || oPtr->filters.num || oPtr->variables.num
+	    || oPtr->mapMethodNameProc != NULL) {
+	Tcl_AppendResult(interp, "may not share class \"", className,
+		"\": it has its own mixins, filters or variables", NULL);
+	return TCL_ERROR;
+    } else if (clsPtr->filterGuards != NULL
+	    && clsPtr->filterGuards->numEntries > 0) {
+	Tcl_AppendResult(interp, "may not share class \"", className,
+		"\": it has filter guards", NULL);
+	return TCL_ERROR;
+    } else if ((clsPtr->metadataPtr != NULL
+	    && clsPtr->metadataPtr->numEntries > 0)
+	    || (oPtr->metadataPtr != NULL
+	    && oPtr->metadataPtr->numEntries > 0)) {
+	Tcl_AppendResult(interp, "may not share class \"", className,
+		"\": it has metadata attached", NULL);
+	return TCL_ERROR;
+    }
+
+    memset(scPtr, 0, sizeof(SharedClass));
+    scPtr->nameObj = Tcl_NewStringObj(className, -1);
+    Tcl_IncrRefCount(scPtr->nameObj);
+    scPtr->metaclassObj = Tcl_NewStringObj(TclGetString(
+	    TclOOObjectName(interp, oPtr->selfCls->thisPtr)), -1);
+    Tcl_IncrRefCount(scPtr->metaclassObj);
+    scPtr->superclassesObj = ClassListString(interp,
+	    clsPtr->superclasses.num, clsPtr->superclasses.list);
+    scPtr->mixinsObj = ClassListString(interp, clsPtr->mixins.num,
+	    clsPtr->mixins.list);
+    scPtr->filtersObj = ObjListString(clsPtr->filters.num,
+	    clsPtr->filters.list);
+    scPtr->variablesObj = ObjListString(clsPtr->variables.num,
+	    clsPtr->variables.list);
+
+    if (clsPtr->constructorPtr != NULL) {
+	scPtr->constructorPtr = TclOODescribeMethod(clsPtr->constructorPtr);
+	if (scPtr->constructorPtr == NULL) {
+	    Tcl_AppendResult(interp, "may not share class \"", className,
+		    "\": its constructor cannot be shared", NULL);
+	    goto failed;
+	}
+    }
+    if (clsPtr->destructorPtr != NULL) {
+	scPtr->destructorPtr = TclOODescribeMethod(clsPtr->destructorPtr);
+	if (scPtr->destructorPtr == NULL) {
+	    Tcl_AppendResult(interp, "may not share class \"", className,
+		    "\": its destructor cannot be shared", NULL);
+	    goto failed;
+	}
+    }
+    if (DescribeMethodTable(interp, &clsPtr->classMethods, oPtr,
+	    &scPtr->numMethods, &scPtr->methods) != TCL_OK) {
+	goto failed;
+    }
+    if (oPtr->methodsPtr != NULL && DescribeMethodTable(interp,
+	    oPtr->methodsPtr, oPtr, &scPtr->numSelfMethods,
+	    &scPtr->selfMethods) != TCL_OK) {
+	goto failed;
+    }
+    return TCL_OK;
+
+  failed:
+    FreeSharedClass(scPtr);
+    return TCL_ERROR;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * DescribeMethodTable --
+ *
+ *	Describe all the methods in a table of methods of a class or of a
+ *	class object.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+DescribeMethodTable(
+    Tcl_Interp *interp,		/* Interpreter for error reporting. */
+    Tcl_HashTable *tablePtr,	/* The table of methods. */
+    Object *oPtr,		/* The class object, for error messages. */
+    int *numPtr,		/* Where to write the number of methods. */
+    SharedMethod ***methodsPtr)	/* Where to write the array of methods. */
+{
+    SharedMethod **methods;
+    Tcl_Obj *nameObj;
+    Method *mPtr;
+    int num = 0;
+    FOREACH_HASH_DECLS;
+
+    *numPtr = 0;
+    *methodsPtr = NULL;
+    if (tablePtr->numEntries == 0) {
+	return TCL_OK;
+    }
+    methods = (SharedMethod **)
+	    ckalloc(sizeof(SharedMethod *) * tablePtr->numEntries);
+    FOREACH_HASH(nameObj, mPtr, tablePtr) {
+	methods[num] = TclOODescribeMethod(mPtr);
+	if (methods[num] == NULL) {
+	    Tcl_AppendResult(interp, "may not share class \"",
+		    TclGetString(TclOOObjectName(interp, oPtr)),
+		    "\": method \"", TclGetString(nameObj),
+		    "\" cannot be shared", NULL);
+	    while (num-- > 0) {
+		TclOOReleaseSharedMethod(methods[num]);
+	    }
+	    ckfree((char *) methods);
+	    return TCL_ERROR;
+	}
+	num++;
+    }
+    *numPtr = num;
+    *methodsPtr = methods;
+    return TCL_OK;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * ClassListString, ObjListString --
+ *
+ *	Make a list of the names of some classes, or of some values, as a
+ *	plain string value that belongs to no interpreter. The result has one
+ *	reference.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static Tcl_Obj *
+ClassListString(
+    Tcl_Interp *interp,
+    int numClasses,
+    Class *const *classes)
+{
+    Tcl_Obj *listObj = Tcl_NewObj(), *resultObj;
+    int i;
+
+    Tcl_IncrRefCount(listObj);
+    for (i=0 ; i<numClasses ; i++) {
+	Tcl_ListObjAppendElement(NULL, listObj,
+		TclOOObjectName(interp, classes[i]->thisPtr));
+    }
+    resultObj = Tcl_NewStringObj(TclGetString(listObj), -1);
+    Tcl_IncrRefCount(resultObj);
+    Tcl_DecrRefCount(listObj);
+    return resultObj;
+}
+
+static Tcl_Obj *
+ObjListString(
+    int objc,
+    Tcl_Obj *const *objv)
+{
+    Tcl_Obj *listObj = Tcl_NewListObj(objc, objv), *resultObj;
+
+    Tcl_IncrRefCount(listObj);
+    resultObj = Tcl_NewStringObj(TclGetString(listObj), -1);
+    Tcl_IncrRefCount(resultObj);
+    Tcl_DecrRefCount(listObj);
+    return resultObj;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * ImportLibrary --
+ *
+ *	Make the classes of a shared class library in an interpreter. Either
+ *	all of them are made, or none are. The names of the classes made are
+ *	the result.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+ImportLibrary(
+    Tcl_Interp *interp,		/* Interpreter to make the classes in. */
+    SharedLibrary *libPtr)	/* The library to import. */
+{
+    Foundation *fPtr = TclOOGetFoundation(interp);
+    Object **created, *oPtr;
+    Class *metaPtr;
+    SharedClass *scPtr;
+    Tcl_Obj *resultObj;
+    Tcl_InterpState state;
+    int i, numCreated = 0;
+
+    for (i=0 ; i<libPtr->numClasses ; i++) {
+	const char *className = TclGetString(libPtr->classes[i].nameObj);
+
+	if (Tcl_FindCommand(interp, className, NULL,
+		TCL_GLOBAL_ONLY) != NULL) {
+	    Tcl_AppendResult(interp, "can't import class \"", className,
+		    "\": command already exists with that name", NULL);
+	    return TCL_ERROR;
+	}
+    }
+
+    /*
+     * Make the classes with all cached call chains being thrown away just
+     * once at the end. The objects are locked so that they can be cleaned
+     * up whatever happens if there is a failure part way through.
+     */
+
+    created = (Object **) ckalloc(sizeof(Object *) * libPtr->numClasses);
+    TclOOBeginDefinitions(interp);
+    for (i=0 ; i<libPtr->numClasses ; i++) {
+	scPtr = &libPtr->classes[i];
+	metaPtr = LookupClass(interp, scPtr->metaclassObj);
+	if (metaPtr == NULL) {
+	    goto failed;
+	} else if (!TclOOIsReachable(fPtr->classCls, metaPtr)) {
+	    Tcl_AppendResult(interp, "can't import class \"",
+		    TclGetString(scPtr->nameObj), "\": \"",
+		    TclGetString(scPtr->metaclassObj),
+		    "\" is not a metaclass", NULL);
+	    goto failed;
+	}
+	oPtr = (Object *) Tcl_NewObjectInstance(interp, (Tcl_Class) metaPtr,
+		TclGetString(scPtr->nameObj), NULL, -1, NULL, 0);
+	if (oPtr == NULL) {
+	    goto failed;
+	}
+	AddRef(oPtr);
+	created[numCreated++] = oPtr;
+	if (ConfigureClass(interp, oPtr->classPtr, scPtr) != TCL_OK) {
+	    goto failed;
+	}
+    }
+    TclOOCommitDefinitions(interp);
+
+    resultObj = Tcl_NewObj();
+    for (i=0 ; i<numCreated ; i++) {
+	Tcl_ListObjAppendElement(NULL, resultObj,
+		TclOOObjectName(interp, created[i]));
+	DelRef(created[i]);
+    }
+    ckfree((char *) created);
+    Tcl_SetObjResult(interp, resultObj);
+    return TCL_OK;
+
+    /*
+     * Get rid of what was made, most derived first, keeping the error
+     * message.
+     */
+
+  failed:
+    TclOOCommitDefinitions(interp);
+    state = Tcl_SaveInterpState(interp, TCL_ERROR);
+    for (i=numCreated-1 ; i>=0 ; i--) {
+	if (created[i]->command != NULL) {
+	    Tcl_DeleteCommandFromToken(interp, created[i]->command);
+	}
+	DelRef(created[i]);
+    }
+    ckfree((char *) created);
+    return Tcl_RestoreInterpState(interp, state);
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * ConfigureClass --
+ *
+ *	Set up a newly made class from its description in a shared class
+ *	library. Every value that the class keeps is a fresh copy.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+ConfigureClass(
+    Tcl_Interp *interp,		/* Interpreter for error reporting. */
+    Class *clsPtr,		/* The class to set up. */
+    SharedClass *scPtr)		/* The description of the class. */
+{
+    Tcl_Obj *listObj, **objv;
+    Class **classes, *superPtr;
+    Method *mPtr;
+    int objc, i, j;
+
+    /*
+     * Superclasses. The class is new, so it has no subclasses and there is
+     * no need to check for circularity.
+     */
+
+    listObj = Tcl_NewStringObj(TclGetString(scPtr->superclassesObj), -1);
+    Tcl_IncrRefCount(listObj);
+    if (Tcl_ListObjGetElements(interp, listObj, &objc, &objv) != TCL_OK) {
+	goto failed;
+    }
+    if (objc > 0) {
+	classes = (Class **) ckalloc(sizeof(Class *) * objc);
+	for (j=0 ; j<objc ; j++) {
+	    classes[j] = LookupClass(interp, objv[j]);
+	    if (classes[j] == NULL) {
+		ckfree((char *) classes);
+		goto failed;
+	    }
+	}
+	FOREACH(superPtr, clsPtr->superclasses) {
+	    TclOORemoveFromSubclasses(clsPtr, superPtr);
+	}
+	ckfree((char *) clsPtr->superclasses.list);
+	clsPtr->superclasses.list = classes;
+	clsPtr->superclasses.num = objc;
+	FOREACH(superPtr, clsPtr->superclasses) {
+	    TclOOAddToSubclasses(clsPtr, superPtr);
+	}
+    }
+    Tcl_DecrRefCount(listObj);
+
+    /*
+     * Mixins.
+     */
+
+    listObj = Tcl_NewStringObj(TclGetString(scPtr->mixinsObj), -1);
+    Tcl_IncrRefCount(listObj);
+    if (Tcl_ListObjGetElements(interp, listObj, &objc, &objv) != TCL_OK) {
+	goto failed;
+    }
+    if (objc > 0) {
+	classes = (Class **) ckalloc(sizeof(Class *) * objc);
+	for (j=0 ; j<objc ; j++) {
+	    classes[j] = LookupClass(interp, objv[j]);
+	    if (classes[j] == NULL) {
+		ckfree((char *) classes);
+		goto failed;
+	    }
+	}
+	TclOOClassSetMixins(interp, clsPtr, objc, classes);
+	ckfree((char *) classes);
+    }
+    Tcl_DecrRefCount(listObj);
+
+    /*
+     * Filters and variables. The elements of the lists are fresh values, so
+     * they can be kept directly.
+     */
+
+    listObj = Tcl_NewStringObj(TclGetString(scPtr->filtersObj), -1);
+    Tcl_IncrRefCount(listObj);
+    if (Tcl_ListObjGetElements(interp, listObj, &objc, &objv) != TCL_OK) {
+	goto failed;
+    }
+    if (objc > 0) {
+	TclOOClassSetFilters(interp, clsPtr, objc, objv);
+    }
+    Tcl_DecrRefCount(listObj);
+
+    listObj = Tcl_NewStringObj(TclGetString(scPtr->variablesObj), -1);
+    Tcl_IncrRefCount(listObj);
+    if (Tcl_ListObjGetElements(interp, listObj, &objc, &objv) != TCL_OK) {
+	goto failed;
+    }
+    if (objc > 0) {
+	clsPtr->variables.list = (Tcl_Obj **)
+		ckalloc(sizeof(Tcl_Obj *) * objc);
+	for (j=0 ; j<objc ; j++) {
+	    clsPtr->variables.list[j] = objv[j];
+	    Tcl_IncrRefCount(objv[j]);
+	}
+	clsPtr->variables.num = objc;
+    }
+    Tcl_DecrRefCount(listObj);
+
+    /*
+     * Methods.
+     */
+
+    if (scPtr->constructorPtr != NULL) {
+	mPtr = TclOONewSharedMethod(interp, NULL, clsPtr,
+		scPtr->constructorPtr);
+	if (mPtr == NULL) {
+	    return TCL_ERROR;
+	}
+	Tcl_ClassSetConstructor(interp, (Tcl_Class) clsPtr, (Tcl_Method) mPtr);
+    }
+    if (scPtr->destructorPtr != NULL) {
+	mPtr = TclOONewSharedMethod(interp, NULL, clsPtr,
+		scPtr->destructorPtr);
+	if (mPtr == NULL) {
+	    return TCL_ERROR;
+	}
+	Tcl_ClassSetDestructor(interp, (Tcl_Class) clsPtr, (Tcl_Method) mPtr);
+    }
+    for (i=0 ; i<scPtr->numMethods ; i++) {
+	if (TclOONewSharedMethod(interp, NULL, clsPtr,
+		scPtr->methods[i]) == NULL) {
+	    return TCL_ERROR;
+	}
+    }
+    for (i=0 ; i<scPtr->numSelfMethods ; i++) {
+	if (TclOONewSharedMethod(interp, clsPtr->thisPtr, NULL,
+		scPtr->selfMethods[i]) == NULL) {
+	    return TCL_ERROR;
+	}
+    }
+    return TCL_OK;
+
+  failed:
+    Tcl_DecrRefCount(listObj);
+    return TCL_ERROR;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * LookupClass --
+ *
+ *	Find a class by name, leaving an error message if there is no such
+ *	class.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static Class *
+LookupClass(
+    Tcl_Interp *interp,
+    Tcl_Obj *nameObj)
+{
+    Object *oPtr = (Object *) Tcl_GetObjectFromObj(interp, nameObj);
+
+    if (oPtr == NULL) {
+	return NULL;
+    } else if (oPtr->classPtr == NULL) {
+	Tcl_AppendResult(interp, "\"", TclGetString(nameObj),
+		"\" is not a class", NULL);
+	return NULL;
+    }
+    return oPtr->classPtr;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * CheckNewLibraryName, RegisterLibrary --
+ *
+ *	Check that there is not already a class library with a particular
+ *	name, and publish a class library under a name. Publishing a library
+ *	sets the interpreter result to the list of the names of its classes.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+CheckNewLibraryName(
+    Tcl_Interp *interp,
+    ThreadLocalData *tsdPtr,
+    Tcl_Obj *nameObj)
+{
+    if (tsdPtr->sharedLibraries != NULL && Tcl_FindHashEntry(
+	    tsdPtr->sharedLibraries, TclGetString(nameObj)) != NULL) {
+	Tcl_AppendResult(interp, "class library \"", TclGetString(nameObj),
+		"\" already exists", NULL);
+	return TCL_ERROR;
+    }
+    return TCL_OK;
+}
+
+static void
+RegisterLibrary(
+    Tcl_Interp *interp,
+    ThreadLocalData *tsdPtr,
+    Tcl_Obj *nameObj,
+    SharedLibrary *libPtr)
+{
+    Tcl_HashEntry *hPtr;
+    Tcl_Obj *resultObj;
+    int i, isNew;
+
+    if (tsdPtr->sharedLibraries == NULL) {
+	tsdPtr->sharedLibraries = (Tcl_HashTable *)
+		ckalloc(sizeof(Tcl_HashTable));
+	Tcl_InitHashTable(tsdPtr->sharedLibraries, TCL_STRING_KEYS);
+	Tcl_CreateThreadExitHandler(FreeSharedLibraries, tsdPtr);
+    }
+    hPtr = Tcl_CreateHashEntry(tsdPtr->sharedLibraries,
+	    TclGetString(nameObj), &isNew);
+    Tcl_SetHashValue(hPtr, libPtr);
+
+    resultObj = Tcl_NewObj();
+    for (i=0 ; i<libPtr->numClasses ; i++) {
+	Tcl_ListObjAppendElement(NULL, resultObj, Tcl_NewStringObj(
+		TclGetString(libPtr->classes[i].nameObj), -1));
+    }
+    Tcl_SetObjResult(interp, resultObj);
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * WriteLibraryImage, PutMethod --
+ *
+ *	Save a class library to a file as an image that [oo::share load] can
+ *	read back. The format of an image is:
+ *
+ *	    "TOOL" version(1 byte) length(4 bytes) payload(length bytes)
+ *
+ *	where the payload is the number of classes followed by each class in
+ *	the order they are to be made. A class is its name, metaclass name,
+ *	superclass list, mixin list, filter list and variable list (all as
+ *	strings), then the constructor and the destructor (each as a word that
+ *	says whether it is there, and then the method if it is), then the
+ *	counted list of methods of the class and the counted list of methods
+ *	of the class object. A method is its kind, flags and property access
+ *	flags, a word saying which of its name, formal arguments and body
+ *	follow (IMAGE_NAME, IMAGE_ARGS and IMAGE_BODY), and then those
+ *	strings. Words, counts and the lengths of strings are all 4-byte
+ *	big-endian unsigned integers, as with [oo::serialize].
+ *
+ * ----------------------------------------------------------------------
+ */
+
+#define IMAGE_MAGIC		"TOOL"
+#define IMAGE_VERSION		1
+#define IMAGE_HEADER_SIZE	9
+#define IMAGE_NAME		1
+#define IMAGE_ARGS		2
+#define IMAGE_BODY		4
+
+static int
+WriteLibraryImage(
+    Tcl_Interp *interp,		/* Interpreter for error reporting. */
+    SharedLibrary *libPtr,	/* The library to save. */
+    Tcl_Obj *fileNameObj)	/* The name of the file to write. */
+{
+    Tcl_DString buffer;
+    Tcl_Channel chan;
+    SharedClass *scPtr;
+    char version = IMAGE_VERSION;
+    int i, j, result = TCL_OK;
+
+    Tcl_DStringInit(&buffer);
+    Tcl_DStringAppend(&buffer, IMAGE_MAGIC, 4);
+    Tcl_DStringAppend(&buffer, &version, 1);
+    TclOOSerialPutWord(&buffer, 0);
+    TclOOSerialPutWord(&buffer, (unsigned) libPtr->numClasses);
+    for (i=0 ; i<libPtr->numClasses ; i++) {
+	scPtr = &libPtr->classes[i];
+	TclOOSerialPutString(&buffer, scPtr->nameObj);
+	TclOOSerialPutString(&buffer, scPtr->metaclassObj);
+	TclOOSerialPutString(&buffer, scPtr->superclassesObj);
+	TclOOSerialPutString(&buffer, scPtr->mixinsObj);
+	TclOOSerialPutString(&buffer, scPtr->filtersObj);
+	TclOOSerialPutString(&buffer, scPtr->variablesObj);
+	TclOOSerialPutWord(&buffer, scPtr->constructorPtr != NULL);
+	if (scPtr->constructorPtr != NULL) {
+	    PutMethod(&buffer, scPtr->constructorPtr);
+	}
+	TclOOSerialPutWord(&buffer, scPtr->destructorPtr != NULL);
+	if (scPtr->destructorPtr != NULL) {
+	    PutMethod(&buffer, scPtr->destructorPtr);
+	}
+	TclOOSerialPutWord(&buffer, (unsigned) scPtr->numMethods);
+	for (j=0 ; j<scPtr->numMethods ; j++) {
+	    PutMethod(&buffer, scPtr->methods[j]);
+	}
+	TclOOSerialPutWord(&buffer, (unsigned) scPtr->numSelfMethods);
+	for (j=0 ; j<scPtr->numSelfMethods ; j++) {
+	    PutMethod(&buffer, scPtr->selfMethods[j]);
+	}
+    }
+    TclOOSerialPatchWord(&buffer, 5, (unsigned)
+	    (Tcl_DStringLength(&buffer) - IMAGE_HEADER_SIZE));
+
+    chan = Tcl_OpenFileChannel(interp, TclGetString(fileNameObj), "w", 0666);
+    if (chan == NULL) {
+	Tcl_DStringFree(&buffer);
+	return TCL_ERROR;
+    }
+    Tcl_SetChannelOption(NULL, chan, "-translation", "binary");
+    if (Tcl_Write(chan, Tcl_DStringValue(&buffer),
+	    Tcl_DStringLength(&buffer)) < 0) {
+	Tcl_AppendResult(interp, "error writing \"", TclGetString(fileNameObj),
+		"\": ", Tcl_PosixError(interp), NULL);
+	result = TCL_ERROR;
+    }
+    if (Tcl_Close((result == TCL_OK ? interp : NULL), chan) != TCL_OK) {
+	result = TCL_ERROR;
+    }
+    Tcl_DStringFree(&buffer);
+    return result;
+}
+
+static void
+PutMethod(
+    Tcl_DString *dsPtr,
+    SharedMethod *smPtr)
+{
+    unsigned int parts = 0;
+
+    if (smPtr->nameObj != NULL) {
+	parts |= IMAGE_NAME;
+    }
+    if (smPtr->argsObj != NULL) {
+	parts |= IMAGE_ARGS;
+    }
+    if (smPtr->bodyObj != NULL) {
+	parts |= IMAGE_BODY;
+    }
+    TclOOSerialPutWord(dsPtr, (unsigned) smPtr->kind);
+    TclOOSerialPutWord(dsPtr, (unsigned) smPtr->flags);
+    TclOOSerialPutWord(dsPtr, (unsigned) smPtr->accessFlags);
+    TclOOSerialPutWord(dsPtr, parts);
+    if (smPtr->nameObj != NULL) {
+	TclOOSerialPutString(dsPtr, smPtr->nameObj);
+    }
+    if (smPtr->argsObj != NULL) {
+	TclOOSerialPutString(dsPtr, smPtr->argsObj);
+    }
+    if (smPtr->bodyObj != NULL) {
+	TclOOSerialPutString(dsPtr, smPtr->bodyObj);
+    }
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * ReadLibraryImage --
+ *
+ *	Read a class library from an image file written by WriteLibraryImage.
+ *	The whole image is checked before anything is returned, so a damaged
+ *	file makes no library at all. The bodies of the methods are not
+ *	looked at here; as with a library made by [oo::share export], they
+ *	are only turned into procedures when first called.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static SharedLibrary *
+ReadLibraryImage(
+    Tcl_Interp *interp,		/* Interpreter for error reporting. */
+    Tcl_Obj *fileNameObj)	/* The name of the file to read. */
+{
+    Tcl_Channel chan;
+    Tcl_WideInt size;
+    SerialReader reader;
+    SharedLibrary *libPtr = NULL;
+    unsigned char *buffer = NULL;
+    unsigned int length, num;
+    int numRead, i;
+
+    chan = Tcl_OpenFileChannel(interp, TclGetString(fileNameObj), "r", 0);
+    if (chan == NULL) {
+	return NULL;
+    }
+    Tcl_SetChannelOption(NULL, chan, "-translation", "binary");
+
+    /*
+     * Read the whole file in one go; the file size bounds how much memory a
+     * damaged length field can ask for.
+     */
+
+    size = Tcl_Seek(chan, 0, SEEK_END);
+    if (size < 0 || Tcl_Seek(chan, 0, SEEK_SET) < 0) {
+	goto readError;
+    } else if (size < IMAGE_HEADER_SIZE || size > INT_MAX) {
+	goto notImage;
+    }
+    buffer = (unsigned char *) ckalloc((int) size);
+    numRead = Tcl_Read(chan, (char *) buffer, (int) size);
+    if (numRead < 0) {
+	goto readError;
+    }
+    Tcl_Close(NULL, chan);
+    chan = NULL;
+
+    if (numRead < IMAGE_HEADER_SIZE || memcmp(buffer, IMAGE_MAGIC, 4) != 0) {
+	goto notImage;
+    } else if (buffer[4] != IMAGE_VERSION) {
+	char buf[TCL_INTEGER_SPACE];
+
+	sprintf(buf, "%d", buffer[4]);
+	Tcl_AppendResult(interp, "unsupported class library image version ",
+		buf, NULL);
+	goto done;
+    }
+    reader.bytes = buffer + 5;
+    reader.length = 4;
+    reader.pos = 0;
+    TclOOSerialGetWord(&reader, &length);
+    reader.bytes = buffer + IMAGE_HEADER_SIZE;
+    reader.length = numRead - IMAGE_HEADER_SIZE;
+    reader.pos = 0;
+    if (length != (unsigned) reader.length
+	    || !TclOOSerialGetCount(&reader, &num) || num == 0) {
+	goto malformed;
+    }
+
+    libPtr = (SharedLibrary *) ckalloc(sizeof(SharedLibrary));
+    libPtr->classes = (SharedClass *) ckalloc(sizeof(SharedClass) * num);
+    libPtr->numClasses = 0;
+    for (i=0 ; i<(int) num ; i++) {
+	if (!GetClass(&reader, &libPtr->classes[i])) {
+	    goto malformed;
+	}
+	libPtr->numClasses++;
+    }
+    if (reader.pos != reader.length) {
+	goto malformed;
+    }
+    ckfree((char *) buffer);
+    return libPtr;
+
+  readError:
+    Tcl_AppendResult(interp, "error reading \"", TclGetString(fileNameObj),
+	    "\": ", Tcl_PosixError(interp), NULL);
+    goto done;
+  notImage:
+    Tcl_AppendResult(interp, "\"", TclGetString(fileNameObj),
+	    "\" is not a class library image", NULL);
+    goto done;
+  malformed:
+    Tcl_AppendResult(interp, "malformed class library image \"",
+	    TclGetString(fileNameObj), "\"", NULL);
+  done:
+    if (chan != NULL) {
+	Tcl_Close(NULL, chan);
+    }
+    if (buffer != NULL) {
+	ckfree((char *) buffer);
+    }
+    if (libPtr != NULL) {
+	FreeSharedLibrary(libPtr);
+    }
+    return NULL;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * GetClass, GetMethodList, GetMethod --
+ *
+ *	Read the parts of a class library image. These return zero (or NULL)
+ *	if the image is damaged, having released whatever they had read.
+ *	Whatever they read is described by fresh strings that belong to no
+ *	interpreter.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+GetClass(
+    SerialReader *rPtr,		/* The image being read. */
+    SharedClass *scPtr)		/* Where to write the description. */
+{
+    Tcl_Obj *strings[6];
+    unsigned int present;
+    int i;
+
+    for (i=0 ; i<6 ; i++) {
+	strings[i] = TclOOSerialGetString(rPtr);
+	if (strings[i] == NULL) {
+	    while (i-- > 0) {
+		Tcl_DecrRefCount(strings[i]);
+	    }
+	    return 0;
+	}
+    }
+    memset(scPtr, 0, sizeof(SharedClass));
+    scPtr->nameObj = strings[0];
+    scPtr->metaclassObj = strings[1];
+    scPtr->superclassesObj = strings[2];
+    scPtr->mixinsObj = strings[3];
+    scPtr->filtersObj = strings[4];
+    scPtr->variablesObj = strings[5];
+
+    if (!TclOOSerialGetWord(rPtr, &present) || present > 1) {
+	goto failed;
+    } else if (present) {
+	scPtr->constructorPtr = GetMethod(rPtr, 0);
+	if (scPtr->constructorPtr == NULL) {
+	    goto failed;
+	}
+    }
+    if (!TclOOSerialGetWord(rPtr, &present) || present > 1) {
+	goto failed;
+    } else if (present) {
+	scPtr->destructorPtr = GetMethod(rPtr, 0);
+	if (scPtr->destructorPtr == NULL) {
+	    goto failed;
+	}
+    }
+    if (!GetMethodList(rPtr, &scPtr->numMethods, &scPtr->methods)
+	    || !GetMethodList(rPtr, &scPtr->numSelfMethods,
+		    &scPtr->selfMethods)) {
+	goto failed;
+    }
+    return 1;
+
+  failed:
+    FreeSharedClass(scPtr);
+    return 0;
+}
+
+static int
+GetMethodList(
+    SerialReader *rPtr,		/* The image being read. */
+    int *numPtr,		/* Where to count the methods read; must be
+				 * zero to start with. */
+    SharedMethod ***methodsPtr)	/* Where to write the array of methods. */
+{
+    SharedMethod *smPtr;
+    unsigned int num, i;
+
+    if (!TclOOSerialGetCount(rPtr, &num)) {
+	return 0;
+    } else if (num == 0) {
+	return 1;
+    }
+
+    /*
+     * The count is kept up to date so that the caller can release a partly
+     * read list.
+     */
+
+    *methodsPtr = (SharedMethod **) ckalloc(sizeof(SharedMethod *) * num);
+    for (i=0 ; i<num ; i++) {
+	smPtr = GetMethod(rPtr, 1);
+	if (smPtr == NULL) {
+	    return 0;
+	}
+	(*methodsPtr)[(*numPtr)++] = smPtr;
+    }
+    return 1;
+}
+
+static SharedMethod *
+GetMethod(
+    SerialReader *rPtr,		/* The image being read. */
+    int isNamed)		/* Whether this is an ordinary method (with a
+				 * name) rather than a constructor or
+				 * destructor. */
+{
+    SharedMethod *smPtr;
+    Tcl_Obj *strings[3];
+    unsigned int kind, flags, accessFlags, parts;
+    int i;
+
+    if (!TclOOSerialGetWord(rPtr, &kind)
+	    || !TclOOSerialGetWord(rPtr, &flags)
+	    || !TclOOSerialGetWord(rPtr, &accessFlags)
+	    || !TclOOSerialGetWord(rPtr, &parts)) {
+	return NULL;
+    }
+
+    /*
+     * Only accept what TclOONewSharedMethod can make: constructors and
+     * destructors are always procedure-like and unnamed, other methods are
+     * always named, procedure-like methods need arguments and a body, and
+     * forwarded methods need a prefix.
+     */
+
+    if (kind > SHARED_FLAGS
+	    || parts > (IMAGE_NAME | IMAGE_ARGS | IMAGE_BODY)
+	    || (isNamed ? !(parts & IMAGE_NAME)
+		    : (parts & IMAGE_NAME) || kind != SHARED_PROC)
+	    || (kind == SHARED_PROC
+		    && (parts & (IMAGE_ARGS | IMAGE_BODY))
+			    != (IMAGE_ARGS | IMAGE_BODY))
+	    || (kind == SHARED_FORWARD && !(parts & IMAGE_BODY))) {
+	return NULL;
+    }
+    for (i=0 ; i<3 ; i++) {
+	strings[i] = NULL;
+	if (parts & (1 << i)) {
+	    strings[i] = TclOOSerialGetString(rPtr);
+	    if (strings[i] == NULL) {
+		while (i-- > 0) {
+		    if (strings[i] != NULL) {
+			Tcl_DecrRefCount(strings[i]);
+		    }
+		}
+		return NULL;
+	    }
+	}
+    }
+
+    smPtr = (SharedMethod *) ckalloc(sizeof(SharedMethod));
+    smPtr->refCount = 1;
+    smPtr->kind = (int) kind;
+    smPtr->flags = (int) flags
+	    & (PUBLIC_METHOD|PRIVATE_METHOD|USE_DECLARER_NS);
+    smPtr->accessFlags = (int) accessFlags & (PROPERTY_GET|PROPERTY_SET);
+    smPtr->nameObj = strings[0];
+    smPtr->argsObj = strings[1];
+    smPtr->bodyObj = strings[2];
+    return smPtr;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * FreeSharedClass, FreeSharedLibrary, FreeSharedLibraries --
+ *
+ *	How to get rid of the descriptions of classes, of a library, and of
+ *	all the libraries of a thread (when the thread exits).
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static void
+FreeSharedClass(
+    SharedClass *scPtr)
+{
+    int i;
+
+    Tcl_DecrRefCount(scPtr->nameObj);
+    Tcl_DecrRefCount(scPtr->metaclassObj);
+    Tcl_DecrRefCount(scPtr->superclassesObj);
+    Tcl_DecrRefCount(scPtr->mixinsObj);
+    Tcl_DecrRefCount(scPtr->filtersObj);
+    Tcl_DecrRefCount(scPtr->variablesObj);
+    if (scPtr->constructorPtr != NULL) {
+	TclOOReleaseSharedMethod(scPtr->constructorPtr);
+    }
+    if (scPtr->destructorPtr != NULL) {
+	TclOOReleaseSharedMethod(scPtr->destructorPtr);
+    }
+    for (i=0 ; i<scPtr->numMethods ; i++) {
+	TclOOReleaseSharedMethod(scPtr->methods[i]);
+    }
+    if (scPtr->methods != NULL) {
+	ckfree((char *) scPtr->methods);
+    }
+    for (i=0 ; i<scPtr->numSelfMethods ; i++) {
+	TclOOReleaseSharedMethod(scPtr->selfMethods[i]);
+    }
+    if (scPtr->selfMethods != NULL) {
+	ckfree((char *) scPtr->selfMethods);
+    }
+}
+
+static void
+FreeSharedLibrary(
+    SharedLibrary *libPtr)
+{
+    int i;
+
+    for (i=0 ; i<libPtr->numClasses ; i++) {
+	FreeSharedClass(&libPtr->classes[i]);
+    }
+    ckfree((char *) libPtr->classes);
+    ckfree((char *) libPtr);
+}
+
+static void
+FreeSharedLibraries(
+    ClientData clientData)
+{
+    ThreadLocalData *tsdPtr = clientData;
+    Tcl_HashEntry *hPtr;
+    Tcl_HashSearch search;
+
+    for (hPtr=Tcl_FirstHashEntry(tsdPtr->sharedLibraries, &search);
+	    hPtr!=NULL ; hPtr=Tcl_NextHashEntry(&search)) {
+	FreeSharedLibrary(Tcl_GetHashValue(hPtr));
+    }
+    Tcl_DeleteHashTable(tsdPtr->sharedLibraries);
+    ckfree((char *) tsdPtr->sharedLibraries);
+    tsdPtr->sharedLibraries = NULL;
+}
+
+/*
+ * Local Variables:
+ * mode: c
+ * c-basic-offset: 4
+ * fill-column: 78
+ * End:
+ */
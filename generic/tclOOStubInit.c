@@ -30,6 +30,10 @@ static const TclOOIntStubs tclOOIntStubs = {
     TclOOClassSetFilters, /* 13 */
     TclOOObjectSetMixins, /* 14 */
     TclOOClassSetMixins, /* 15 */
+    TclOOBeginDefinitions, /* 16 */
+    TclOOCommitDefinitions, /* 17 */
+    TclOOPrecompileClass, /* 18 */
+    TclOOInvokeMany, /* 19 */
 };
 
 static const TclOOStubHooks tclOOStubHooks = {
@@ -68,6 +72,11 @@ const TclOOStubs tclOOStubs = {
     Tcl_ClassSetConstructor, /* 26 */
     Tcl_ClassSetDestructor, /* 27 */
     Tcl_GetObjectName, /* 28 */
+    Tcl_ObjectSetPureMethodNameMapper, /* 29 */
+    Tcl_ClassSetFilterGuard, /* 30 */
+    Tcl_ClassForeachInstance, /* 31 */
+    Tcl_DeferObjectDeletion, /* 32 */
+    Tcl_DrainDeferredDeletions, /* 33 */
 };
 
 /* !END!: Do not edit above this line. */
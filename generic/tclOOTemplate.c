@@ -0,0 +1,532 @@
+/*
+ * tclOOTemplate.c --
+ *
+ *	This file contains the implementation of the [oo::template] command,
+ *	which makes families of similar classes by copying a prepared
+ *	prototype class instead of running a whole definition script for each
+ *	of them.
+ *
+ * Copyright (c) 2026 by agent
+ *
+ * See the file "license.terms" for information on usage and redistribution of
+ * this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "tclInt.h"
+#include "tclOOInt.h"
+
+/*
+ * A class template. The commands of its definition up to the first that
+ * mentions a parameter have been applied to the prototype class once and
+ * for all; only the rest are run for each class made from the template,
+ * after the parameters in them have been replaced.
+ */
+
+typedef struct Template {
+    Tcl_Interp *interp;		/* Interpreter the template belongs to. */
+    Tcl_Command command;	/* The template's command. */
+    Object *protoPtr;		/* The prototype class. Locked, so that it can
+				 * be told when it has been deleted. */
+    Tcl_Obj *paramsObj;		/* List of the parameters; each is a string
+				 * that is replaced wherever it occurs. */
+    Tcl_Obj *scriptObj;		/* The commands of the definition from the
+				 * first that mentions a parameter on, or NULL
+				 * if none does. */
+} Template;
+
+/*
+ * Function declarations for things defined in this file.
+ */
+
+static int		TemplateObjCmd(ClientData clientData,
+			    Tcl_Interp *interp, int objc,
+			    Tcl_Obj *const *objv);
+static void		DeleteTemplate(ClientData clientData);
+static int		SplitDefinition(Tcl_Interp *interp, Tcl_Obj *defnObj,
+			    int numParams, Tcl_Obj *const *params,
+			    Tcl_DString *protoPtr, Tcl_DString *paramPtr);
+static int		MentionsParameter(const char *bytes, int length,
+			    int numParams, Tcl_Obj *const *params);
+static Tcl_Obj *	SubstituteParameters(Tcl_Obj *scriptObj,
+			    int numParams, Tcl_Obj *const *params,
+			    Tcl_Obj *const *values);
+static int		Instantiate(Tcl_Interp *interp, Template *tmplPtr,
+			    Tcl_Obj *nameObj, Tcl_Obj *valuesObj);
+static int		ApplyDefinition(Tcl_Interp *interp, Object *oPtr,
+			    Tcl_Obj *scriptObj);
+static void		QualifyName(Tcl_Interp *interp, const char *name,
+			    Tcl_DString *dsPtr);
+
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TclOOTemplateObjCmd --
+ *
+ *	Implementation of the [oo::template] command, which makes class
+ *	templates. The definition of a template is split into its commands;
+ *	those before the first that mentions any of the parameters are applied
+ *	straight away to a prototype class, and the others are kept. Making a
+ *	class from the template copies the prototype (sharing the procedures
+ *	and bytecode of its methods) and then runs just the kept commands,
+ *	with the parameters replaced by their values as if by [string map].
+ *
+ * ----------------------------------------------------------------------
+ */
+
+int
+TclOOTemplateObjCmd(
+    ClientData clientData,
+    Tcl_Interp *interp,
+    int objc,
+    Tcl_Obj *const *objv)
+{
+    Foundation *fPtr = TclOOGetFoundation(interp);
+    Template *tmplPtr;
+    Tcl_Obj **params;
+    Tcl_DString protoScript, paramScript, name;
+    Object *protoPtr;
+    const char *nameStr;
+    int numParams, i;
+
+    static const char *subcmds[] = {
+	"create", NULL
+    };
+    int idx;
+
+    if (objc < 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "subcommand ?arg ...?");
+	return TCL_ERROR;
+    }
+    if (Tcl_GetIndexFromObj(interp, objv[1], subcmds, "subcommand", 0,
+	    &idx) != TCL_OK) {
+	return TCL_ERROR;
+    } else if (objc != 5) {
+	Tcl_WrongNumArgs(interp, 2, objv,
+		"templateName paramList definitionScript");
+	return TCL_ERROR;
+    }
+    if (Tcl_ListObjGetElements(interp, objv[3], &numParams,
+	    &params) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    for (i=0 ; i<numParams ; i++) {
+	if (TclGetString(params[i])[0] == '\0') {
+	    Tcl_AppendResult(interp, "template parameters must not be empty",
+		    NULL);
+	    return TCL_ERROR;
+	}
+    }
+
+    /*
+     * The template's command is named in the same way as a class.
+     */
+
+    nameStr = TclGetString(objv[2]);
+    QualifyName(interp, nameStr, &name);
+    if (Tcl_FindCommand(interp, Tcl_DStringValue(&name), NULL,
+	    TCL_GLOBAL_ONLY) != NULL) {
+	Tcl_AppendResult(interp, "can't create template \"", nameStr,
+		"\": command already exists with that name", NULL);
+	Tcl_DStringFree(&name);
+	return TCL_ERROR;
+    }
+
+    /*
+     * Split the definition and build the prototype.
+     */
+
+    Tcl_DStringInit(&protoScript);
+    Tcl_DStringInit(&paramScript);
+    if (SplitDefinition(interp, objv[4], numParams, params, &protoScript,
+	    &paramScript) != TCL_OK) {
+	goto failed;
+    }
+    protoPtr = (Object *) Tcl_NewObjectInstance(interp,
+	    (Tcl_Class) fPtr->classCls, NULL, NULL, -1, NULL, 0);
+    if (protoPtr == NULL) {
+	goto failed;
+    }
+    AddRef(protoPtr);
+    if (Tcl_DStringLength(&protoScript) > 0) {
+	Tcl_Obj *scriptObj = Tcl_NewStringObj(Tcl_DStringValue(&protoScript),
+		Tcl_DStringLength(&protoScript));
+
+	Tcl_IncrRefCount(scriptObj);
+	i = ApplyDefinition(interp, protoPtr, scriptObj);
+	Tcl_DecrRefCount(scriptObj);
+	if (i != TCL_OK) {
+	    Tcl_AppendObjToErrorInfo(interp, Tcl_ObjPrintf(
+		    "\n    (in definition of template \"%s\")", nameStr));
+	    if (protoPtr->command != NULL) {
+		Tcl_DeleteCommandFromToken(interp, protoPtr->command);
+	    }
+	    DelRef(protoPtr);
+	    goto failed;
+	}
+    }
+
+    tmplPtr = (Template *) ckalloc(sizeof(Template));
+    tmplPtr->interp = interp;
+    tmplPtr->protoPtr = protoPtr;
+    tmplPtr->paramsObj = objv[3];
+    Tcl_IncrRefCount(tmplPtr->paramsObj);
+    tmplPtr->scriptObj = NULL;
+    if (Tcl_DStringLength(&paramScript) > 0) {
+	tmplPtr->scriptObj = Tcl_NewStringObj(Tcl_DStringValue(&paramScript),
+		Tcl_DStringLength(&paramScript));
+	Tcl_IncrRefCount(tmplPtr->scriptObj);
+    }
+    tmplPtr->command = Tcl_CreateObjCommand(interp, Tcl_DStringValue(&name),
+	    TemplateObjCmd, tmplPtr, DeleteTemplate);
+    Tcl_DStringFree(&protoScript);
+    Tcl_DStringFree(&paramScript);
+    Tcl_DStringFree(&name);
+
+    Tcl_SetObjResult(interp, Tcl_NewObj());
+    Tcl_GetCommandFullName(interp, tmplPtr->command, Tcl_GetObjResult(interp));
+    return TCL_OK;
+
+  failed:
+    Tcl_DStringFree(&protoScript);
+    Tcl_DStringFree(&paramScript);
+    Tcl_DStringFree(&name);
+    return TCL_ERROR;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * TemplateObjCmd, DeleteTemplate --
+ *
+ *	The command of a class template, and how to get rid of the template
+ *	when the command goes.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+TemplateObjCmd(
+    ClientData clientData,
+    Tcl_Interp *interp,
+    int objc,
+    Tcl_Obj *const *objv)
+{
+    static const char *subcmds[] = {
+	"destroy", "instantiate", NULL
+    };
+    enum TemplateSubcmds {
+	TEMPLATE_DESTROY, TEMPLATE_INSTANTIATE
+    };
+    Template *tmplPtr = clientData;
+    int idx;
+
+    if (objc < 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "subcommand ?arg ...?");
+	return TCL_ERROR;
+    }
+    if (Tcl_GetIndexFromObj(interp, objv[1], subcmds, "subcommand", 0,
+	    &idx) != TCL_OK) {
+	return TCL_ERROR;
+    }
+
+    switch ((enum TemplateSubcmds) idx) {
+    case TEMPLATE_DESTROY:
+	if (objc != 2) {
+	    Tcl_WrongNumArgs(interp, 2, objv, NULL);
+	    return TCL_ERROR;
+	}
+	Tcl_DeleteCommandFromToken(interp, tmplPtr->command);
+	return TCL_OK;
+    case TEMPLATE_INSTANTIATE:
+	if (objc != 4) {
+	    Tcl_WrongNumArgs(interp, 2, objv, "className valueList");
+	    return TCL_ERROR;
+	}
+	return Instantiate(interp, tmplPtr, objv[2], objv[3]);
+    }
+    return TCL_ERROR;
+}
+
+static void
+DeleteTemplate(
+    ClientData clientData)
+{
+    Template *tmplPtr = clientData;
+    Object *protoPtr = tmplPtr->protoPtr;
+
+    if (protoPtr->command != NULL
+	    && !Tcl_InterpDeleted(tmplPtr->interp)) {
+	Tcl_DeleteCommandFromToken(tmplPtr->interp, protoPtr->command);
+    }
+    DelRef(protoPtr);
+    Tcl_DecrRefCount(tmplPtr->paramsObj);
+    if (tmplPtr->scriptObj != NULL) {
+	Tcl_DecrRefCount(tmplPtr->scriptObj);
+    }
+    ckfree((char *) tmplPtr);
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * SplitDefinition, MentionsParameter --
+ *
+ *	Split the definition of a template into the commands before the
+ *	first one that mentions a parameter (for the prototype) and the rest.
+ *	Later commands that mention no parameter stay with the rest, as they
+ *	may depend on what the commands before them did (e.g., [unexport] or
+ *	[renamemethod] of a method made with a parameter in it).
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+SplitDefinition(
+    Tcl_Interp *interp,		/* Interpreter for error reporting. */
+    Tcl_Obj *defnObj,		/* The definition script. */
+    int numParams,		/* Number of parameters. */
+    Tcl_Obj *const *params,	/* The parameters. */
+    Tcl_DString *protoPtr,	/* Where to put the commands that mention no
+				 * parameter. */
+    Tcl_DString *paramPtr)	/* Where to put the commands that do. */
+{
+    Tcl_Parse parse;
+    Tcl_DString *dsPtr = protoPtr;
+    const char *p;
+    int length;
+
+    p = Tcl_GetStringFromObj(defnObj, &length);
+    while (length > 0) {
+	if (Tcl_ParseCommand(interp, p, length, 0, &parse) != TCL_OK) {
+	    Tcl_AddErrorInfo(interp, "\n    (parsing template definition)");
+	    return TCL_ERROR;
+	}
+	if (parse.numWords > 0) {
+	    if (dsPtr == protoPtr && MentionsParameter(parse.commandStart,
+		    parse.commandSize, numParams, params)) {
+		dsPtr = paramPtr;
+	    }
+	    Tcl_DStringAppend(dsPtr, parse.commandStart, parse.commandSize);
+	    Tcl_DStringAppend(dsPtr, "\n", 1);
+	}
+	length -= (parse.commandStart + parse.commandSize) - p;
+	p = parse.commandStart + parse.commandSize;
+	Tcl_FreeParse(&parse);
+    }
+    return TCL_OK;
+}
+
+static int
+MentionsParameter(
+    const char *bytes,
+    int length,
+    int numParams,
+    Tcl_Obj *const *params)
+{
+    const char *paramStr;
+    int i, j, paramLen;
+
+    for (i=0 ; i<numParams ; i++) {
+	paramStr = Tcl_GetStringFromObj(params[i], &paramLen);
+	for (j=0 ; j+paramLen<=length ; j++) {
+	    if (bytes[j] == paramStr[0]
+		    && memcmp(bytes+j, paramStr, (size_t) paramLen) == 0) {
+		return 1;
+	    }
+	}
+    }
+    return 0;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * SubstituteParameters --
+ *
+ *	Replace the parameters in a script with their values, in the same way
+ *	as [string map] does: at each point, the first parameter in the list
+ *	that matches is replaced, and the replacement is not looked at again.
+ *	The result has no references.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static Tcl_Obj *
+SubstituteParameters(
+    Tcl_Obj *scriptObj,
+    int numParams,
+    Tcl_Obj *const *params,
+    Tcl_Obj *const *values)
+{
+    Tcl_Obj *resultObj = Tcl_NewObj();
+    const char *p, *start, *paramStr, *valueStr;
+    int length, paramLen, valueLen, i;
+
+    p = start = Tcl_GetStringFromObj(scriptObj, &length);
+    while (length > 0) {
+	for (i=0 ; i<numParams ; i++) {
+	    paramStr = Tcl_GetStringFromObj(params[i], &paramLen);
+	    if (paramLen <= length && *p == *paramStr
+		    && memcmp(p, paramStr, (size_t) paramLen) == 0) {
+		break;
+	    }
+	}
+	if (i == numParams) {
+	    p++;
+	    length--;
+	    continue;
+	}
+	Tcl_AppendToObj(resultObj, start, p - start);
+	valueStr = Tcl_GetStringFromObj(values[i], &valueLen);
+	Tcl_AppendToObj(resultObj, valueStr, valueLen);
+	p += paramLen;
+	length -= paramLen;
+	start = p;
+    }
+    Tcl_AppendToObj(resultObj, start, p - start);
+    return resultObj;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * Instantiate --
+ *
+ *	Make a class from a template. The class is a copy of the prototype
+ *	(made without running any script) to which the kept commands of the
+ *	definition are then applied. If those fail, the class is deleted
+ *	again.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+Instantiate(
+    Tcl_Interp *interp,		/* Interpreter to make the class in. */
+    Template *tmplPtr,		/* The template. */
+    Tcl_Obj *nameObj,		/* Name of the class to make. */
+    Tcl_Obj *valuesObj)		/* List of values of the parameters. */
+{
+    Object *oPtr;
+    Tcl_Obj **params, **values, *scriptObj;
+    Tcl_DString buffer;
+    int numParams, numValues, result;
+
+    if (tmplPtr->protoPtr->command == NULL) {
+	Tcl_AppendResult(interp, "the prototype class of the template has "
+		"been deleted", NULL);
+	return TCL_ERROR;
+    }
+    Tcl_ListObjGetElements(NULL, tmplPtr->paramsObj, &numParams, &params);
+    if (Tcl_ListObjGetElements(interp, valuesObj, &numValues,
+	    &values) != TCL_OK) {
+	return TCL_ERROR;
+    } else if (numValues != numParams) {
+	Tcl_AppendResult(interp,
+		"wrong number of template values: should be \"",
+		TclGetString(tmplPtr->paramsObj), "\"", NULL);
+	return TCL_ERROR;
+    }
+
+    QualifyName(interp, TclGetString(nameObj), &buffer);
+    oPtr = (Object *) Tcl_CopyObjectInstance(interp,
+	    (Tcl_Object) tmplPtr->protoPtr, Tcl_DStringValue(&buffer), NULL);
+    Tcl_DStringFree(&buffer);
+    if (oPtr == NULL) {
+	return TCL_ERROR;
+    }
+
+    if (tmplPtr->scriptObj != NULL) {
+	scriptObj = SubstituteParameters(tmplPtr->scriptObj, numParams,
+		params, values);
+	Tcl_IncrRefCount(scriptObj);
+	AddRef(oPtr);
+	result = ApplyDefinition(interp, oPtr, scriptObj);
+	Tcl_DecrRefCount(scriptObj);
+	if (result != TCL_OK) {
+	    Tcl_InterpState state = Tcl_SaveInterpState(interp, result);
+
+	    if (oPtr->command != NULL) {
+		Tcl_DeleteCommandFromToken(interp, oPtr->command);
+	    }
+	    DelRef(oPtr);
+	    return Tcl_RestoreInterpState(interp, state);
+	}
+	Tcl_SetObjResult(interp, TclOOObjectName(interp, oPtr));
+	DelRef(oPtr);
+	return TCL_OK;
+    }
+
+    Tcl_SetObjResult(interp, TclOOObjectName(interp, oPtr));
+    return TCL_OK;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * ApplyDefinition --
+ *
+ *	Apply a definition script to a class with [oo::define], just as if
+ *	the caller had done so.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static int
+ApplyDefinition(
+    Tcl_Interp *interp,
+    Object *oPtr,
+    Tcl_Obj *scriptObj)
+{
+    Tcl_Obj *objv[3];
+    int result;
+
+    objv[0] = oPtr->fPtr->defineName;
+    objv[1] = TclOOObjectName(interp, oPtr);
+    objv[2] = scriptObj;
+    Tcl_IncrRefCount(objv[1]);
+    result = Tcl_EvalObjv(interp, 3, objv, 0);
+    Tcl_DecrRefCount(objv[1]);
+    return result;
+}
+
+/*
+ * ----------------------------------------------------------------------
+ *
+ * QualifyName --
+ *
+ *	Make a name fully-qualified with respect to the current namespace,
+ *	writing it into an uninitialized DString.
+ *
+ * ----------------------------------------------------------------------
+ */
+
+static void
+QualifyName(
+    Tcl_Interp *interp,
+    const char *name,
+    Tcl_DString *dsPtr)
+{
+    Tcl_Namespace *nsPtr = Tcl_GetCurrentNamespace(interp);
+
+    Tcl_DStringInit(dsPtr);
+    if (name[0] != ':' || name[1] != ':') {
+	if (nsPtr != Tcl_GetGlobalNamespace(interp)) {
+	    Tcl_DStringAppend(dsPtr, nsPtr->fullName, -1);
+	}
+	Tcl_DStringAppend(dsPtr, "::", 2);
+    }
+    Tcl_DStringAppend(dsPtr, name, -1);
+}
+
+/*
+ * Local Variables:
+ * mode: c
+ * c-basic-offset: 4
+ * fill-column: 78
+ * End:
+ */